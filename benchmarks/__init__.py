@@ -0,0 +1,4 @@
+"""
+Performance benchmarks for MP3 Spectrum Visualizer.
+Run with `python3 -m benchmarks.run`; see benchmarks/run.py for options.
+"""
@@ -0,0 +1,247 @@
+"""
+Benchmark runner.
+Measures per-frame cost of every suite at each resolution plus end-to-end
+generate_video() throughput, writes the results as JSON and compares them
+with a stored baseline.
+
+Usage:
+    python3 -m benchmarks.run --output results.json
+    python3 -m benchmarks.run --resolutions 720p --suites visualizers,effects
+    python3 -m benchmarks.run --output new.json --baseline baseline.json --tolerance 0.15
+
+With --baseline the exit code is 1 when any benchmark got slower than the
+tolerance allows.
+"""
+
+import argparse
+import json
+import os
+import platform
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+from typing import Any, Callable, Dict, List, Optional
+
+import numpy as np
+
+from benchmarks import fixtures
+from benchmarks.suites import SUITES, BenchmarkContext
+
+
+# Results file format version; comparisons refuse other versions
+RESULTS_VERSION = 1
+
+
+def time_per_frame(run: Callable[[int], Any], frames: int, repeats: int, warmup: int) -> Dict[str, float]:
+    """
+    Time a per-frame function over consecutive frame numbers.
+    
+    Args:
+        run: Function(frame_number)
+        frames: Frames per repeat
+        repeats: Timed repeats; the median is reported
+        warmup: Untimed frames first (caches, palettes, JIT)
+    
+    Returns:
+        {'ms_per_frame', 'fps', 'min_ms', 'max_ms'}
+    """
+    frame_number = 0
+    for _ in range(warmup):
+        run(frame_number)
+        frame_number += 1
+    
+    samples = []
+    for _ in range(repeats):
+        started = time.perf_counter()
+        for _ in range(frames):
+            run(frame_number)
+            frame_number += 1
+        samples.append((time.perf_counter() - started) / frames * 1000.0)
+    
+    ms = statistics.median(samples)
+    return {'ms_per_frame': ms, 'fps': 1000.0 / ms if ms > 0 else 0.0,
+            'min_ms': min(samples), 'max_ms': max(samples)}
+
+
+def time_generate_video(ctx: BenchmarkContext, size, seconds: int) -> Optional[Dict[str, float]]:
+    """
+    Time a full generate_video() of the fixture track (pipeline and encoder included).
+    
+    Args:
+        ctx: Benchmark context
+        size: Output (width, height)
+        seconds: Seconds of video to render
+    
+    Returns:
+        Timing like time_per_frame(), or None if the render failed
+    """
+    output_path = os.path.join(ctx.work_dir, f'render_{size[0]}x{size[1]}.mp4')
+    generator = ctx.generator(size, beat_sync_enabled=True, beat_effect_type='pulse',
+                              overlay_effect_type='snow', use_hardware_acceleration=False,
+                              use_multiprocessing=True)
+    started = time.perf_counter()
+    if not generator.generate_video(output_path, preview_seconds=seconds):
+        return None
+    elapsed = time.perf_counter() - started
+    frames = seconds * ctx.FRAME_RATE
+    ms = elapsed / frames * 1000.0
+    return {'ms_per_frame': ms, 'fps': frames / elapsed, 'min_ms': ms, 'max_ms': ms}
+
+
+def environment() -> Dict[str, Any]:
+    """Describe the machine and code version results were measured on."""
+    info = {
+        'python': platform.python_version(),
+        'numpy': np.__version__,
+        'platform': platform.platform(),
+        'processor': platform.processor(),
+        'cpu_count': os.cpu_count(),
+        'timestamp': time.strftime('%Y-%m-%dT%H:%M:%S'),
+    }
+    try:
+        info['commit'] = subprocess.run(['git', 'rev-parse', '--short', 'HEAD'], capture_output=True,
+                                        text=True, timeout=5).stdout.strip()
+    except (OSError, subprocess.SubprocessError):
+        pass
+    return info
+
+
+def run_benchmarks(resolutions: List[str], suites: List[str], frames: int, repeats: int,
+                   warmup: int, render_seconds: int) -> Dict[str, Any]:
+    """
+    Run the selected suites.
+    
+    Args:
+        resolutions: Keys of fixtures.RESOLUTIONS
+        suites: Keys of SUITES, plus 'generate_video' for the end-to-end render
+        frames: Frames per timed repeat
+        repeats: Timed repeats per benchmark
+        warmup: Untimed frames per benchmark
+        render_seconds: Seconds rendered by the end-to-end benchmark
+    
+    Returns:
+        Results document: {'version', 'environment', 'settings', 'results'}
+    """
+    work_dir = tempfile.mkdtemp(prefix='spectrum_viz_bench_')
+    results: Dict[str, Dict[str, float]] = {}
+    try:
+        ctx = BenchmarkContext(work_dir)
+        for resolution in resolutions:
+            size = fixtures.RESOLUTIONS[resolution]
+            for suite in suites:
+                if suite == 'generate_video':
+                    benchmarks = [('generate_video', None)]
+                else:
+                    benchmarks = list(SUITES[suite](ctx, size))
+                for name, setup in benchmarks:
+                    group = 'render' if suite == 'generate_video' else suite
+                    key = f'{group}/{name}@{resolution}'
+                    if setup is None:
+                        timing = time_generate_video(ctx, size, render_seconds)
+                    else:
+                        run = setup()
+                        timing = time_per_frame(run, frames, repeats, warmup) if run is not None else None
+                    if timing is None:
+                        print(f'{key:<55} skipped')
+                        continue
+                    results[key] = timing
+                    print(f"{key:<55} {timing['ms_per_frame']:9.2f} ms/frame  {timing['fps']:8.1f} fps")
+    finally:
+        shutil.rmtree(work_dir, ignore_errors=True)
+    
+    return {
+        'version': RESULTS_VERSION,
+        'environment': environment(),
+        'settings': {'frames': frames, 'repeats': repeats, 'warmup': warmup,
+                     'render_seconds': render_seconds},
+        'results': results,
+    }
+
+
+def compare(current: Dict[str, Any], baseline: Dict[str, Any], tolerance: float) -> List[Dict[str, Any]]:
+    """
+    Compare results with a baseline.
+    
+    Args:
+        current: Results document of this run
+        baseline: Stored results document
+        tolerance: Allowed slowdown as a fraction (0.1 = 10% slower per frame)
+    
+    Returns:
+        One entry per benchmark in both documents: {'name', 'baseline_ms',
+        'current_ms', 'ratio', 'status'} with status 'regression', 'improvement' or 'ok'
+    """
+    if baseline.get('version') != RESULTS_VERSION:
+        raise ValueError(f"Baseline has results version {baseline.get('version')}, expected {RESULTS_VERSION}")
+    
+    rows = []
+    for name, timing in sorted(current['results'].items()):
+        base = baseline['results'].get(name)
+        if base is None:
+            continue
+        ratio = timing['ms_per_frame'] / base['ms_per_frame'] if base['ms_per_frame'] > 0 else 1.0
+        if ratio > 1.0 + tolerance:
+            status = 'regression'
+        elif ratio < 1.0 / (1.0 + tolerance):
+            status = 'improvement'
+        else:
+            status = 'ok'
+        rows.append({'name': name, 'baseline_ms': base['ms_per_frame'],
+                     'current_ms': timing['ms_per_frame'], 'ratio': ratio, 'status': status})
+    return rows
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    """Command line entry point; returns the exit code."""
+    parser = argparse.ArgumentParser(description='MP3 Spectrum Visualizer benchmarks')
+    parser.add_argument('--resolutions', default=','.join(fixtures.RESOLUTIONS),
+                        help='comma-separated resolutions (720p,1080p,4k)')
+    parser.add_argument('--suites', default=','.join(list(SUITES) + ['generate_video']),
+                        help='comma-separated suites (%s,generate_video)' % ','.join(SUITES))
+    parser.add_argument('--frames', type=int, default=30, help='frames per timed repeat')
+    parser.add_argument('--repeats', type=int, default=3, help='timed repeats (median is reported)')
+    parser.add_argument('--warmup', type=int, default=5, help='untimed frames before timing')
+    parser.add_argument('--render-seconds', type=int, default=5,
+                        help='seconds rendered by the generate_video benchmark')
+    parser.add_argument('--output', help='write results JSON here')
+    parser.add_argument('--baseline', help='compare with this results JSON')
+    parser.add_argument('--tolerance', type=float, default=0.10,
+                        help='allowed per-frame slowdown before a regression is reported')
+    args = parser.parse_args(argv)
+    
+    resolutions = [r.strip() for r in args.resolutions.split(',') if r.strip()]
+    suites = [s.strip() for s in args.suites.split(',') if s.strip()]
+    unknown = [r for r in resolutions if r not in fixtures.RESOLUTIONS] + \
+              [s for s in suites if s not in SUITES and s != 'generate_video']
+    if unknown:
+        parser.error(f"unknown resolutions/suites: {', '.join(unknown)}")
+    
+    document = run_benchmarks(resolutions, suites, args.frames, args.repeats, args.warmup,
+                              args.render_seconds)
+    
+    exit_code = 0
+    if args.baseline:
+        with open(args.baseline, 'r') as f:
+            baseline = json.load(f)
+        rows = compare(document, baseline, args.tolerance)
+        document['comparison'] = {'baseline': args.baseline, 'tolerance': args.tolerance, 'rows': rows}
+        print()
+        for row in rows:
+            print(f"{row['name']:<55} {row['baseline_ms']:9.2f} -> {row['current_ms']:9.2f} ms "
+                  f"({row['ratio']:5.2f}x) {row['status']}")
+        regressions = [row for row in rows if row['status'] == 'regression']
+        if regressions:
+            print(f"\n{len(regressions)} regressions beyond {args.tolerance:.0%}")
+            exit_code = 1
+    
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(document, f, indent=4)
+    return exit_code
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,251 @@
+"""
+Benchmark suites.
+Each suite yields (name, setup) pairs per resolution; setup() builds what the
+benchmark needs and returns a function(frame_number) whose run time is measured
+per frame.
+"""
+
+import os
+from typing import Any, Callable, Dict, Iterator, Optional, Tuple
+
+import numpy as np
+
+from benchmarks import fixtures
+from core import effects
+from core.audio_processor import AudioProcessor, FeatureTable
+from core.overlay_effects import OverlayFactory
+from core.visualizers import VisualizerFactory
+
+
+FrameFunction = Callable[[int], Any]
+Setup = Callable[[], Optional[FrameFunction]]
+
+
+class BenchmarkContext:
+    """Fixtures shared by all benchmarks of a run, created on first use."""
+    
+    FRAME_RATE = 30
+    
+    def __init__(self, work_dir: str):
+        """
+        Initialize context.
+        
+        Args:
+            work_dir: Directory for generated fixtures and outputs
+        """
+        self.work_dir = work_dir
+        self.audio_path = fixtures.synthetic_track(os.path.join(work_dir, 'fixture.wav'))
+        self._audio_processor: Optional[AudioProcessor] = None
+        self._feature_table: Optional[FeatureTable] = None
+        self._images: Dict[Tuple[int, int], list] = {}
+        self._videos: Dict[Tuple[int, int], Optional[str]] = {}
+    
+    @property
+    def audio_processor(self) -> AudioProcessor:
+        """Analyzed processor of the fixture track."""
+        if self._audio_processor is None:
+            self._audio_processor = AudioProcessor(self.audio_path)
+            self._audio_processor.load_audio()
+        return self._audio_processor
+    
+    @property
+    def feature_table(self) -> FeatureTable:
+        """Per-frame features of the fixture track."""
+        if self._feature_table is None:
+            self._feature_table = self.audio_processor.get_feature_table(frame_rate=self.FRAME_RATE)
+        return self._feature_table
+    
+    def images(self, size: Tuple[int, int]) -> list:
+        """Background image paths at a size."""
+        if size not in self._images:
+            self._images[size] = fixtures.synthetic_images(self.work_dir, size)
+        return self._images[size]
+    
+    def video(self, size: Tuple[int, int]) -> Optional[str]:
+        """Background video path at a size (None without ffmpeg)."""
+        if size not in self._videos:
+            path = os.path.join(self.work_dir, f'background_{size[0]}x{size[1]}.mp4')
+            self._videos[size] = path if fixtures.synthetic_video(path, size) else None
+        return self._videos[size]
+    
+    def settings(self, size: Tuple[int, int], **overrides) -> Dict[str, Any]:
+        """Default settings at a size, with overrides."""
+        from core.settings import SettingsManager
+        
+        settings = dict(SettingsManager.DEFAULT_SETTINGS)
+        settings.update({'video_width': size[0], 'video_height': size[1], 'frame_rate': self.FRAME_RATE,
+                         'use_multiprocessing': False, 'analysis_cache_enabled': False})
+        settings.update(overrides)
+        return settings
+    
+    def generator(self, size: Tuple[int, int], **overrides):
+        """VideoGenerator of the fixture track."""
+        from core.video_generator import VideoGenerator
+        
+        return VideoGenerator(self.audio_processor, self.settings(size, **overrides))
+
+
+def visualizer_suite(ctx: BenchmarkContext, size: Tuple[int, int]) -> Iterator[Tuple[str, Setup]]:
+    """One benchmark per VisualizerFactory style: render_layer() per frame."""
+    for style in VisualizerFactory.STYLES:
+        def setup(style=style):
+            visualizer = VisualizerFactory.create(style, size[0], size[1], ctx.settings(size))
+            table = ctx.feature_table
+            
+            def run(frame_number: int):
+                features = table.frame(frame_number)
+                return visualizer.render_layer(features.bands, features.spectrum, frame_number)
+            return run
+        yield style, setup
+
+
+def bands_suite(ctx: BenchmarkContext, size: Tuple[int, int]) -> Iterator[Tuple[str, Setup]]:
+    """Raster kernel visualizers at 64 and 512 bands (the fixture bands resampled)."""
+    for style in ('bars', 'circle', 'line_waveform', 'modern_gradient_bars', 'frequency_dots'):
+        for num_bands in (64, 512):
+            def setup(style=style, num_bands=num_bands):
+                visualizer = VisualizerFactory.create(style, size[0], size[1], ctx.settings(size))
+                table = ctx.feature_table
+                
+                def run(frame_number: int):
+                    features = table.frame(frame_number)
+                    positions = np.linspace(0, len(features.bands) - 1, num_bands)
+                    bands = np.interp(positions, np.arange(len(features.bands)), features.bands)
+                    return visualizer.render_layer(bands, features.spectrum, frame_number)
+                return run
+            yield f'{style}_{num_bands}', setup
+
+
+def overlay_suite(ctx: BenchmarkContext, size: Tuple[int, int]) -> Iterator[Tuple[str, Setup]]:
+    """One benchmark per OverlayFactory overlay: update() and render_layer() per frame."""
+    for overlay_type in OverlayFactory.TYPES:
+        def setup(overlay_type=overlay_type):
+            overlay = OverlayFactory.create(overlay_type, size[0], size[1], ctx.settings(size))
+            
+            def run(frame_number: int):
+                overlay.update(frame_number)
+                return overlay.render_layer()
+            return run
+        yield overlay_type, setup
+
+
+def effects_suite(ctx: BenchmarkContext, size: Tuple[int, int]) -> Iterator[Tuple[str, Setup]]:
+    """One benchmark per public function of core/effects.py."""
+    def images():
+        from PIL import Image
+        paths = ctx.images(size)
+        return Image.open(paths[0]).convert('RGB'), Image.open(paths[1]).convert('RGB')
+    
+    def strength(frame_number: int) -> float:
+        # Sweeps 0..1 so threshold-gated effects run both paths
+        return (frame_number % 10) / 9.0
+    
+    spectrum = ctx.feature_table.spectrum
+    
+    def frame_effect(function: Callable) -> Setup:
+        def setup():
+            image, other = images()
+            return lambda n: function(image, other, n)
+        return setup
+    
+    matrix = effects.scale_matrix(size, 1.05)
+    benchmarks = {
+        'apply_blur': lambda image, _, n: effects.apply_blur(image, 10),
+        'apply_vignette': lambda image, _, n: effects.apply_vignette(image, 50),
+        'apply_bw': lambda image, _, n: effects.apply_bw(image),
+        'fit_background': lambda image, _, n: effects.fit_background(image, (size[0] // 2 * 3, size[1]), 'fill'),
+        'apply_strobe': lambda image, _, n: effects.apply_strobe(
+            image, spectrum[n % len(spectrum)], (255, 255, 255)),
+        'strobe_amount': lambda image, _, n: effects.strobe_amount(spectrum[n % len(spectrum)]),
+        'fade_in': lambda image, _, n: effects.fade_in(n, 90),
+        'apply_fade_in': lambda image, _, n: effects.apply_fade_in(image, n % 30, 30),
+        'apply_background_animation': lambda image, _, n: effects.apply_background_animation(
+            image, n % 300, 'fade_in', 300),
+        'scale_matrix': lambda image, _, n: effects.scale_matrix(size, 1.0 + strength(n) * 0.1),
+        'translation_matrix': lambda image, _, n: effects.translation_matrix(n % 7, n % 5),
+        'warp_affine': None,
+        'warp_image': lambda image, _, n: effects.warp_image(image, matrix),
+        'beat_pulse_matrix': lambda image, _, n: effects.beat_pulse_matrix(size, strength(n)),
+        'beat_zoom_matrix': lambda image, _, n: effects.beat_zoom_matrix(size, strength(n)),
+        'beat_shake_matrix': lambda image, _, n: effects.beat_shake_matrix(strength(n), 50,
+                                                                           np.random.default_rng(n)),
+        'apply_beat_pulse': lambda image, _, n: effects.apply_beat_pulse(image, strength(n)),
+        'apply_beat_flash': lambda image, _, n: effects.apply_beat_flash(image, strength(n)),
+        'beat_flash_amount': lambda image, _, n: effects.beat_flash_amount(strength(n)),
+        'apply_beat_strobe': lambda image, _, n: effects.apply_beat_strobe(image, strength(n)),
+        'beat_strobe_amount': lambda image, _, n: effects.beat_strobe_amount(strength(n)),
+        'apply_beat_zoom': lambda image, _, n: effects.apply_beat_zoom(image, strength(n)),
+        'apply_fade_transition': lambda image, other, n: effects.apply_fade_transition(image, other, (n % 30) / 30),
+        'apply_crossfade_transition': lambda image, other, n: effects.apply_crossfade_transition(
+            image, other, (n % 30) / 30),
+        'apply_slide_transition': lambda image, other, n: effects.apply_slide_transition(image, other, (n % 30) / 30),
+        'apply_zoom_transition': lambda image, other, n: effects.apply_zoom_transition(image, other, (n % 30) / 30),
+        'apply_beat_shake': lambda image, _, n: effects.apply_beat_shake(image, strength(n), 50,
+                                                                         np.random.default_rng(n)),
+    }
+    
+    def warp_affine_setup():
+        image, _ = images()
+        pixels = np.asarray(image.convert('RGBA')).astype(np.float32)
+        out = np.empty_like(pixels)
+        return lambda n: effects.warp_affine(pixels, matrix, size, out=out)
+    
+    for name, function in benchmarks.items():
+        yield name, warp_affine_setup if function is None else frame_effect(function)
+
+
+def background_suite(ctx: BenchmarkContext, size: Tuple[int, int]) -> Iterator[Tuple[str, Setup]]:
+    """Background stage per frame: static image, slideshow transition, large slideshow and video."""
+    def stage(generator, first_frame: int = 0) -> FrameFunction:
+        return lambda n: generator._load_frame_background(generator._prepare_frame(first_frame + n))
+    
+    def static():
+        return stage(ctx.generator(size, background_type='image', background_path=ctx.images(size)[0],
+                                   background_blur=10, vignette_intensity=50))
+    
+    def slideshow():
+        generator = ctx.generator(size, background_type='image', background_paths=ctx.images(size),
+                                  slideshow_enabled=True, slideshow_interval=1, transition_duration=10,
+                                  slideshow_transition='fade')
+        # Past the first interval every measured frame is mid-transition
+        return stage(generator, first_frame=ctx.FRAME_RATE)
+    
+    def slideshow_large():
+        # Hundreds of slides changing every 9 frames: steady frames should cost what a static one does
+        paths = ctx.images(size) * 150
+        generator = ctx.generator(size, background_type='image', background_paths=paths,
+                                  slideshow_enabled=True, slideshow_interval=0.2, transition_duration=0.1,
+                                  slideshow_transition='slide', background_blur=10, vignette_intensity=50)
+        return stage(generator)
+    
+    def video():
+        path = ctx.video(size)
+        if path is None:
+            return None
+        return stage(ctx.generator(size, background_type='video', video_background_path=path))
+    
+    yield 'static', static
+    yield 'slideshow_transition', slideshow
+    yield 'slideshow_large', slideshow_large
+    yield 'video', video
+
+
+def render_suite(ctx: BenchmarkContext, size: Tuple[int, int]) -> Iterator[Tuple[str, Setup]]:
+    """Whole frames: render_frame() in the encoder's YUV layout, beat sync and overlay on."""
+    def setup():
+        generator = ctx.generator(size, beat_sync_enabled=True, beat_effect_type='pulse',
+                                  overlay_effect_type='snow', vignette_intensity=30)
+        generator.seek(0)
+        return lambda n: generator.render_frame(n, 'yuv420p')
+    yield 'render_frame', setup
+
+
+# Suite name -> suite function
+SUITES = {
+    'visualizers': visualizer_suite,
+    'bands': bands_suite,
+    'overlays': overlay_suite,
+    'effects': effects_suite,
+    'backgrounds': background_suite,
+    'render': render_suite,
+}
@@ -0,0 +1,248 @@
+"""
+Audio analysis cache module for MP3 Spectrum Visualizer.
+Stores audio features on disk keyed by file content and analysis parameters,
+so re-rendering a track never decodes or analyzes it again.
+"""
+
+import hashlib
+import json
+import os
+import shutil
+import tempfile
+from typing import Any, Dict, Optional, Tuple
+
+import numpy as np
+
+from core.logger import get_logger
+
+
+class AnalysisCache:
+    """Content-addressed on-disk cache of analysis results (.npy arrays + meta.json)."""
+
+    # Bump when the stored layout or analysis algorithm changes
+    FORMAT_VERSION = 1
+
+    DEFAULT_DIR = os.path.join(os.path.expanduser('~'), '.cache', 'mp3tovideo', 'analysis')
+
+    def __init__(self, cache_dir: Optional[str] = None):
+        """
+        Initialize analysis cache.
+
+        Args:
+            cache_dir: Cache directory (None or empty uses DEFAULT_DIR)
+        """
+        self.cache_dir = cache_dir or self.DEFAULT_DIR
+        # File digests keyed by (path, size, mtime) so a file is hashed once per process
+        self._file_digests: Dict[Tuple[str, int, int], str] = {}
+
+    def file_digest(self, path: str) -> str:
+        """
+        Get the SHA-256 digest of a file's contents.
+
+        Args:
+            path: File path
+
+        Returns:
+            Hex digest
+        """
+        stat = os.stat(path)
+        stat_key = (os.path.abspath(path), stat.st_size, stat.st_mtime_ns)
+        if stat_key in self._file_digests:
+            return self._file_digests[stat_key]
+
+        sha = hashlib.sha256()
+        with open(path, 'rb') as f:
+            for block in iter(lambda: f.read(1024 * 1024), b''):
+                sha.update(block)
+
+        digest = sha.hexdigest()
+        self._file_digests[stat_key] = digest
+        return digest
+
+    def make_key(self, audio_path: str, params: Dict[str, Any]) -> str:
+        """
+        Build the cache key for an audio file and analysis parameters.
+
+        Args:
+            audio_path: Audio file path
+            params: JSON-serializable analysis parameters (sample rate, n_fft, ...)
+
+        Returns:
+            Hex key naming the cache entry
+        """
+        key_data = json.dumps({
+            'version': self.FORMAT_VERSION,
+            'audio': self.file_digest(audio_path),
+            'params': params,
+        }, sort_keys=True)
+        return hashlib.sha256(key_data.encode('utf-8')).hexdigest()
+
+    def load(self, key: str) -> Optional[Dict[str, Any]]:
+        """
+        Load a cache entry.
+
+        Arrays are memory-mapped read-only, so large spectra are paged in on demand.
+
+        Args:
+            key: Key from make_key()
+
+        Returns:
+            Dictionary of scalars and arrays, or None on a miss
+        """
+        entry_dir = os.path.join(self.cache_dir, key)
+        meta_path = os.path.join(entry_dir, 'meta.json')
+        if not os.path.exists(meta_path):
+            return None
+
+        try:
+            with open(meta_path, 'r') as f:
+                meta = json.load(f)
+
+            features = dict(meta['scalars'])
+            for name in meta['arrays']:
+                features[name] = np.load(os.path.join(entry_dir, f'{name}.npy'), mmap_mode='r')
+            return features
+        except (OSError, ValueError, KeyError) as e:
+            logger = get_logger()
+            logger.warning(f"Ignoring unreadable analysis cache entry {key}: {e}")
+            return None
+
+    def store(self, key: str, scalars: Dict[str, Any], arrays: Dict[str, np.ndarray]) -> bool:
+        """
+        Write a cache entry atomically.
+
+        The entry is written to a temporary directory and renamed into place, so
+        concurrent renders never see a partial entry.
+
+        Args:
+            key: Key from make_key()
+            scalars: JSON-serializable values
+            arrays: Arrays stored as individual .npy files
+
+        Returns:
+            True if the entry was written (or already existed), False on error
+        """
+        entry_dir = os.path.join(self.cache_dir, key)
+        if os.path.exists(entry_dir):
+            return True
+
+        temp_dir = None
+        try:
+            os.makedirs(self.cache_dir, exist_ok=True)
+            temp_dir = tempfile.mkdtemp(prefix=f'.{key[:16]}_', dir=self.cache_dir)
+
+            for name, array in arrays.items():
+                np.save(os.path.join(temp_dir, f'{name}.npy'), np.ascontiguousarray(array))
+
+            # meta.json marks a complete entry, so it is written last
+            with open(os.path.join(temp_dir, 'meta.json'), 'w') as f:
+                json.dump({'scalars': scalars, 'arrays': sorted(arrays)}, f)
+
+            os.rename(temp_dir, entry_dir)
+            temp_dir = None
+            return True
+        except OSError as e:
+            if os.path.exists(os.path.join(entry_dir, 'meta.json')):
+                # Another process stored the same entry first
+                return True
+            logger = get_logger()
+            logger.warning(f"Could not write analysis cache entry {key}: {e}")
+            return False
+        finally:
+            if temp_dir:
+                shutil.rmtree(temp_dir, ignore_errors=True)
+
+    def create_entry(self, key: str) -> Optional['CacheEntryWriter']:
+        """
+        Start writing a cache entry array by array (streaming analysis).
+
+        Args:
+            key: Key from make_key()
+
+        Returns:
+            Entry writer, or None if the cache directory is not writable
+        """
+        try:
+            os.makedirs(self.cache_dir, exist_ok=True)
+            temp_dir = tempfile.mkdtemp(prefix=f'.{key[:16]}_', dir=self.cache_dir)
+        except OSError as e:
+            logger = get_logger()
+            logger.warning(f"Could not create analysis cache entry {key}: {e}")
+            return None
+        return CacheEntryWriter(temp_dir, os.path.join(self.cache_dir, key))
+
+    def clear(self) -> None:
+        """Delete every cache entry."""
+        shutil.rmtree(self.cache_dir, ignore_errors=True)
+
+
+class CacheEntryWriter:
+    """
+    A cache entry written while it is being computed.
+
+    Large arrays are memory-mapped .npy files filled in place; commit() adds
+    the remaining arrays and meta.json and renames the directory into place,
+    so readers still only ever see complete entries. Mapped arrays stay valid
+    after the rename.
+    """
+
+    def __init__(self, temp_dir: str, entry_dir: str):
+        """
+        Initialize writer.
+
+        Args:
+            temp_dir: Private directory the entry is written to
+            entry_dir: Final entry directory
+        """
+        self.temp_dir = temp_dir
+        self.entry_dir = entry_dir
+        self._mapped: Dict[str, np.memmap] = {}
+
+    def array(self, name: str, shape: Tuple[int, ...], dtype) -> np.memmap:
+        """
+        Create a zero-filled array stored as name.npy and map it writable.
+
+        Args:
+            name: Array name
+            shape: Array shape
+            dtype: Array dtype
+
+        Returns:
+            Writable memory-mapped array
+        """
+        array = np.lib.format.open_memmap(os.path.join(self.temp_dir, f'{name}.npy'),
+                                          mode='w+', dtype=dtype, shape=shape)
+        self._mapped[name] = array
+        return array
+
+    def commit(self, scalars: Dict[str, Any], arrays: Dict[str, np.ndarray]) -> bool:
+        """
+        Finish the entry.
+
+        Args:
+            scalars: JSON-serializable values
+            arrays: Arrays not created with array()
+
+        Returns:
+            True if the entry is in place (or another process stored it first)
+        """
+        try:
+            for array in self._mapped.values():
+                array.flush()
+            for name, array in arrays.items():
+                np.save(os.path.join(self.temp_dir, f'{name}.npy'), np.ascontiguousarray(array))
+            with open(os.path.join(self.temp_dir, 'meta.json'), 'w') as f:
+                json.dump({'scalars': scalars, 'arrays': sorted(set(arrays) | set(self._mapped))}, f)
+            os.rename(self.temp_dir, self.entry_dir)
+            return True
+        except OSError as e:
+            self.abort()
+            if os.path.exists(os.path.join(self.entry_dir, 'meta.json')):
+                return True
+            logger = get_logger()
+            logger.warning(f"Could not write analysis cache entry {os.path.basename(self.entry_dir)}: {e}")
+            return False
+
+    def abort(self) -> None:
+        """Discard the entry; mapped arrays stay readable until released."""
+        shutil.rmtree(self.temp_dir, ignore_errors=True)
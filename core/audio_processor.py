@@ -5,29 +5,334 @@ Handles audio loading, spectrum analysis, and timing information.
 
 import librosa
 import numpy as np
-from typing import Tuple, List, Optional
+import scipy.fft
+from typing import Tuple, List, Optional, Dict, Any, NamedTuple, Callable
+
+from core import profiler
+from core.analysis_cache import AnalysisCache
+from core.frequency_bands import build_band_matrix
+from core.logger import get_logger
+
+
+class FrameFeatures(NamedTuple):
+    """Audio features for one video frame."""
+    bands: np.ndarray
+    spectrum: np.ndarray
+    beat_strength: float
+    is_beat: bool
+    intensity: float
+
+
+class FeatureTable:
+    """Per-frame audio features precomputed for a whole render."""
+    
+    def __init__(self, bands: np.ndarray, spectrum: np.ndarray, intensity: np.ndarray,
+                 beat_timeline_fn: Optional[Callable[[], Tuple[np.ndarray, np.ndarray]]] = None,
+                 progress=None):
+        """
+        Initialize feature table.
+        
+        Args:
+            bands: (num_frames, num_bands) band magnitudes
+            spectrum: (num_frames, n_bins) spectrum magnitudes
+            intensity: (num_frames,) audio intensity values
+            beat_timeline_fn: Returns the (beat_strength, is_beat) columns on first use
+                              (None means beats are not analyzed: strength 0, no beats)
+            progress: StreamingAnalysis still filling the arrays (None when complete)
+        """
+        self.bands = bands
+        self.spectrum = spectrum
+        self.intensity = intensity
+        self.num_frames = bands.shape[0]
+        self._beat_timelines: Optional[Tuple[np.ndarray, np.ndarray]] = None
+        self._beat_timeline_fn = beat_timeline_fn
+        self._progress = progress
+    
+    def wait_for(self, frame_number: int) -> None:
+        """Block until the features of a frame are written (streaming analysis only)."""
+        if self._progress is not None:
+            self._progress.wait(min(frame_number, self.num_frames - 1))
+    
+    def _get_beat_timelines(self) -> Tuple[np.ndarray, np.ndarray]:
+        """Build beat columns lazily so beat detection only runs when used."""
+        if self._beat_timelines is None:
+            if self._beat_timeline_fn is not None:
+                self._beat_timelines = self._beat_timeline_fn()
+            else:
+                self._beat_timelines = (np.zeros(self.num_frames, dtype=np.float32),
+                                        np.zeros(self.num_frames, dtype=bool))
+        return self._beat_timelines
+    
+    @property
+    def beat_strength(self) -> np.ndarray:
+        """Per-frame beat strength (0.0 to 1.0)."""
+        return self._get_beat_timelines()[0]
+    
+    @property
+    def is_beat(self) -> np.ndarray:
+        """Per-frame flag for frames near a beat."""
+        return self._get_beat_timelines()[1]
+    
+    def frame(self, frame_number: int) -> FrameFeatures:
+        """
+        Get the features of one frame (clamped to the last frame).
+        
+        Args:
+            frame_number: Frame number (0-indexed)
+            
+        Returns:
+            FrameFeatures for the frame
+        """
+        index = min(frame_number, self.num_frames - 1)
+        if self._progress is not None:
+            self._progress.wait(index)
+        if self._beat_timeline_fn is not None:
+            beat_strength, is_beat = self._get_beat_timelines()
+            strength, beat = float(beat_strength[index]), bool(is_beat[index])
+        else:
+            strength, beat = 0.0, False
+        return FrameFeatures(self.bands[index], self.spectrum[index],
+                             strength, beat, float(self.intensity[index]))
 
 
 class AudioProcessor:
     """Processes audio files and extracts spectrum data for visualization."""
     
-    def __init__(self, audio_path: str):
+    # STFT windows processed per FFT batch (bounds temporary memory)
+    STFT_BLOCK_FRAMES = 512
+    
+    def __init__(self, audio_path: str, band_layout: str = 'squared_log',
+                 analysis_cache: Optional[AnalysisCache] = None):
         """
         Initialize audio processor with an audio file.
         
         Args:
             audio_path: Path to the MP3 audio file
+            band_layout: Default frequency band layout (see core.frequency_bands)
+            analysis_cache: Optional on-disk cache used by analyze()
         """
         self.audio_path = audio_path
+        self.band_layout = band_layout
+        self.analysis_cache = analysis_cache
         self.audio_data: Optional[np.ndarray] = None
         self.sample_rate: Optional[int] = None
         self.duration: Optional[float] = None
+        # Frame-major (num_frames, n_bins) float32 magnitudes
         self._spectrum_cache: Optional[np.ndarray] = None
+        self._spectrum_params: Optional[Tuple[int, int]] = None
+        # Band matrices keyed by (num_bands, frame_rate, band_layout)
+        self._bands_cache: Dict[Tuple[int, int, str], np.ndarray] = {}
+        self._intensity_cache: Dict[Tuple[int, int], np.ndarray] = {}
         self._beat_frames: Optional[np.ndarray] = None
         self._beat_times: Optional[np.ndarray] = None
+        # Per-frame distance (in frames) to the nearest beat, keyed by frame_rate
+        self._beat_distance_cache: Dict[int, np.ndarray] = {}
+        self._beat_strength_cache: Dict[int, np.ndarray] = {}
+        self._is_beat_cache: Dict[Tuple[int, int], np.ndarray] = {}
         self._tempo: Optional[float] = None
         self._onset_envelope: Optional[np.ndarray] = None
+        # Running streaming analysis (see analyze()); whole-track lookups wait for it
+        self._streaming = None
+    
+    @classmethod
+    def from_features(cls, features: Dict[str, Any]) -> 'AudioProcessor':
+        """
+        Create a processor from previously exported analysis results.
+        
+        The audio is not decoded; spectrum and beat lookups use the given arrays.
+        
+        Args:
+            features: Dictionary produced by export_features()
+            
+        Returns:
+            AudioProcessor instance
+        """
+        processor = cls(features['audio_path'], features.get('band_layout', 'squared_log'))
+        processor.sample_rate = features.get('sample_rate')
+        processor.duration = features['duration']
+        processor._spectrum_cache = features['spectrum']
+        processor._spectrum_params = (features['frame_rate'], features['n_fft'])
+        
+        if features.get('bands') is not None:
+            bands = features['bands']
+            key = (bands.shape[1], features['frame_rate'], processor.band_layout)
+            processor._bands_cache[key] = bands
+        
+        if features.get('beat_times') is not None:
+            processor._set_beat_times(features['beat_times'])
+            processor._beat_frames = features.get('beat_frames')
+            processor._tempo = features.get('tempo')
+        
+        return processor
+    
+    def export_features(self, frame_rate: int = 30, include_beats: bool = True) -> Dict[str, Any]:
+        """
+        Export analysis results needed to render frames without the decoded audio.
+        
+        Args:
+            frame_rate: Video frame rate
+            include_beats: Whether to run (or reuse) beat detection and include it
+            
+        Returns:
+            Dictionary of analysis results
+        """
+        self.compute_spectrum(frame_rate=frame_rate)
+        features = {
+            'audio_path': self.audio_path,
+            'band_layout': self.band_layout,
+            'sample_rate': self.sample_rate,
+            'duration': self.get_duration(),
+            # Frame-major (num_frames, n_bins) magnitudes
+            'spectrum': self._spectrum_cache,
+            'frame_rate': self._spectrum_params[0],
+            'n_fft': self._spectrum_params[1],
+        }
+        
+        if include_beats:
+            self.detect_beats()
+            features['beat_times'] = self.get_beat_times()
+            features['beat_frames'] = self._beat_frames
+            features['tempo'] = self.get_tempo()
+        
+        return features
+    
+    def analyze(self, frame_rate: int = 30, n_fft: int = 2048, num_bands: int = 64,
+                stream_longer_than: float = 0) -> bool:
+        """
+        Run the full audio analysis, loading it from the analysis cache when possible.
+        
+        On a cache hit the audio is not decoded: spectrum, bands, beats and onset
+        envelope are memory-mapped from disk. On a miss everything is computed
+        and stored for the next render of the same file.
+        
+        Tracks longer than stream_longer_than seconds are analyzed in blocks on a
+        background thread instead, writing straight into the cache entry, so
+        memory does not grow with the track length. analyze() then returns at
+        once: get_feature_table() hands out frames as they are analyzed, and
+        whole-track lookups (spectrum, beats, onset envelope) wait for the end.
         
+        Args:
+            frame_rate: Video frame rate
+            n_fft: Number of FFT points
+            num_bands: Number of frequency bands to precompute
+            stream_longer_than: Duration in seconds above which the analysis streams
+                                (0 never streams; needs the analysis cache)
+            
+        Returns:
+            True if the analysis came from the cache, False if it was computed or started
+        """
+        key = None
+        if self.analysis_cache is not None:
+            params = {
+                'sample_rate': 'native',
+                'n_fft': n_fft,
+                'frame_rate': frame_rate,
+                'num_bands': num_bands,
+                'band_layout': self.band_layout,
+            }
+            key = self.analysis_cache.make_key(self.audio_path, params)
+            with profiler.span('audio.cache_load'):
+                cached = self.analysis_cache.load(key)
+            if cached is not None:
+                self.sample_rate = cached['sample_rate']
+                self.duration = cached['duration']
+                self._spectrum_cache = cached['spectrum']
+                self._spectrum_params = (frame_rate, n_fft)
+                self._bands_cache.clear()
+                self._intensity_cache.clear()
+                self._bands_cache[(num_bands, frame_rate, self.band_layout)] = cached['bands']
+                self._tempo = cached['tempo']
+                self._beat_frames = cached['beat_frames']
+                self._set_beat_times(cached['beat_times'])
+                self._onset_envelope = cached['onset_envelope']
+                return True
+            
+            if stream_longer_than > 0 and self._start_streaming(key, frame_rate, n_fft, num_bands,
+                                                                stream_longer_than):
+                return False
+        
+        spectrum = self._get_spectrum_frames(frame_rate=frame_rate, n_fft=n_fft)
+        bands = self.get_frequency_bands(num_bands=num_bands, frame_rate=frame_rate)
+        self.detect_beats()
+        onset_envelope = self.compute_onset_envelope()
+        
+        if key is not None:
+            self.analysis_cache.store(
+                key,
+                scalars={
+                    'sample_rate': int(self.sample_rate),
+                    'duration': float(self.duration),
+                    'tempo': float(self.get_tempo()),
+                },
+                arrays={
+                    'spectrum': spectrum,
+                    'bands': bands,
+                    'beat_frames': self._beat_frames,
+                    'beat_times': self.get_beat_times(),
+                    'onset_envelope': onset_envelope,
+                }
+            )
+        
+        return False
+    
+    def _start_streaming(self, key: str, frame_rate: int, n_fft: int, num_bands: int,
+                         min_duration: float) -> bool:
+        """
+        Start a streaming analysis into the cache entry of key if the track is long enough.
+        
+        Args:
+            key: Analysis cache key of the parameters
+            frame_rate: Video frame rate
+            n_fft: Number of FFT points
+            num_bands: Number of frequency bands
+            min_duration: Only tracks longer than this many seconds stream
+            
+        Returns:
+            True if the analysis was started
+        """
+        from core.streaming_audio import StreamingAnalysis, probe_audio
+        
+        info = probe_audio(self.audio_path)
+        if info is None or info.num_samples / info.sample_rate <= min_duration:
+            return False
+        writer = self.analysis_cache.create_entry(key)
+        if writer is None:
+            return False
+        
+        streaming = StreamingAnalysis(self.audio_path, info, writer, frame_rate, n_fft,
+                                      num_bands, self.band_layout, self.STFT_BLOCK_FRAMES)
+        self.sample_rate = streaming.sample_rate
+        self.duration = streaming.duration
+        self._streaming = streaming
+        get_logger().info(f"Streaming analysis of {self.duration / 60:.1f} minutes of audio in the background")
+        streaming.start()
+        return True
+    
+    def wait_for_analysis(self) -> None:
+        """
+        Block until a streaming analysis finished and take over its results.
+        
+        Raises:
+            RuntimeError: If the streaming analysis failed
+        """
+        streaming = self._streaming
+        if streaming is None:
+            return
+        streaming.wait()
+        if self._spectrum_cache is streaming.spectrum:
+            return
+        
+        self._spectrum_cache = streaming.spectrum
+        self._spectrum_params = (streaming.frame_rate, streaming.n_fft)
+        self._bands_cache.clear()
+        self._intensity_cache.clear()
+        self._bands_cache[(streaming.num_bands, streaming.frame_rate, streaming.band_layout)] = streaming.bands
+        self._intensity_cache[(streaming.frame_rate, streaming.intensity_window)] = streaming.intensity
+        self._tempo = streaming.results['tempo']
+        self._beat_frames = streaming.results['beat_frames']
+        self._set_beat_times(streaming.results['beat_times'])
+        self._onset_envelope = streaming.results['onset_envelope']
+    
     def load_audio(self) -> Tuple[np.ndarray, int]:
         """
         Load audio file and extract data.
@@ -36,11 +341,12 @@ class AudioProcessor:
             Tuple of (audio_data, sample_rate)
         """
         if self.audio_data is None:
-            self.audio_data, self.sample_rate = librosa.load(
-                self.audio_path,
-                sr=None,  # Keep original sample rate
-                mono=True  # Convert to mono
-            )
+            with profiler.span('audio.decode'):
+                self.audio_data, self.sample_rate = librosa.load(
+                    self.audio_path,
+                    sr=None,  # Keep original sample rate
+                    mono=True  # Convert to mono
+                )
             self.duration = librosa.get_duration(
                 y=self.audio_data,
                 sr=self.sample_rate
@@ -57,67 +363,89 @@ class AudioProcessor:
         """
         Compute spectrum data for each video frame.
         
+        STFT windows are centered exactly on each video frame's timestamp, so
+        there is one column per frame and no resampling step.
+        
         Args:
             frame_rate: Video frame rate (fps)
             n_fft: Number of FFT points
             
         Returns:
-            Array of shape (num_frames, n_fft//2 + 1) containing spectrum magnitudes
+            Array of shape (n_fft//2 + 1, num_frames) containing spectrum magnitudes
+            (a transposed view of the frame-major float32 cache)
         """
-        if self._spectrum_cache is not None:
+        return self._get_spectrum_frames(frame_rate, n_fft).T
+    
+    def _get_spectrum_frames(self, frame_rate: int = 30, n_fft: int = 2048) -> np.ndarray:
+        """
+        Get the frame-major spectrum, computing it on first use.
+        
+        Args:
+            frame_rate: Video frame rate (fps)
+            n_fft: Number of FFT points
+            
+        Returns:
+            Array of shape (num_frames, n_fft//2 + 1), float32
+        """
+        self.wait_for_analysis()
+        if self._spectrum_cache is not None and self._spectrum_params == (frame_rate, n_fft):
             return self._spectrum_cache
         
         audio_data, sr = self.load_audio()
         duration = self.get_duration()
         num_frames = int(duration * frame_rate)
         
-        # Calculate hop length for frame-by-frame analysis
-        hop_length = len(audio_data) // num_frames if num_frames > 0 else 512
-        
-        # Compute short-time Fourier transform
-        stft = librosa.stft(audio_data, n_fft=n_fft, hop_length=hop_length)
-        magnitude = np.abs(stft)
-        
-        # Resample to match exact number of frames
-        if magnitude.shape[1] != num_frames:
-            # Use numpy interpolation to match frame count
-            original_indices = np.linspace(0, magnitude.shape[1] - 1, magnitude.shape[1])
-            target_indices = np.linspace(0, magnitude.shape[1] - 1, num_frames)
-            # Interpolate each frequency bin
-            resampled = np.zeros((magnitude.shape[0], num_frames))
-            for i in range(magnitude.shape[0]):
-                resampled[i] = np.interp(target_indices, original_indices, magnitude[i])
-            magnitude = resampled
+        magnitude = np.zeros((num_frames, n_fft // 2 + 1), dtype=np.float32)
+        if num_frames > 0:
+            with profiler.span('audio.stft'):
+                # Zero-pad so windows centered near the edges stay in bounds (librosa's center=True)
+                half_window = n_fft // 2
+                padded = np.pad(audio_data.astype(np.float32, copy=False), half_window)
+                window = (0.5 - 0.5 * np.cos(2 * np.pi * np.arange(n_fft) / n_fft)).astype(np.float32)
+                
+                # Window start in padded coordinates equals the frame's center sample
+                centers = np.round(np.arange(num_frames) * (sr / frame_rate)).astype(np.int64)
+                centers = np.minimum(centers, len(audio_data) - 1)
+                offsets = np.arange(n_fft)
+                
+                for block_start in range(0, num_frames, self.STFT_BLOCK_FRAMES):
+                    block_end = min(block_start + self.STFT_BLOCK_FRAMES, num_frames)
+                    windows = padded[centers[block_start:block_end, None] + offsets]
+                    windows *= window
+                    magnitude[block_start:block_end] = np.abs(scipy.fft.rfft(windows, axis=1))
         
         self._spectrum_cache = magnitude
+        self._spectrum_params = (frame_rate, n_fft)
+        # Derived matrices belong to the previous spectrum
+        self._bands_cache.clear()
+        self._intensity_cache.clear()
         return magnitude
     
-    def get_frequency_bands(self, num_bands: int = 64, frame_rate: int = 30) -> np.ndarray:
+    def get_frequency_bands(self, num_bands: int = 64, frame_rate: int = 30,
+                            band_layout: Optional[str] = None) -> np.ndarray:
         """
         Get frequency bands for visualization.
         
         Args:
             num_bands: Number of frequency bands to create
             frame_rate: Video frame rate
+            band_layout: Band layout name (None uses the processor default)
             
         Returns:
             Array of shape (num_frames, num_bands) with band magnitudes
         """
-        spectrum = self.compute_spectrum(frame_rate=frame_rate)
-        n_fft = spectrum.shape[0]
-        
-        # Map FFT bins to frequency bands
-        bands = np.zeros((spectrum.shape[1], num_bands))
-        
-        for i in range(num_bands):
-            # Use logarithmic spacing for frequency bands
-            start_bin = int((i / num_bands) ** 2 * n_fft)
-            end_bin = int(((i + 1) / num_bands) ** 2 * n_fft)
-            end_bin = min(end_bin, n_fft)
-            
-            if start_bin < end_bin:
-                bands[:, i] = np.mean(spectrum[start_bin:end_bin, :].T, axis=1)
-        
+        layout = band_layout or self.band_layout
+        key = (num_bands, frame_rate, layout)
+        spectrum = self._get_spectrum_frames(frame_rate=frame_rate)
+        if key in self._bands_cache:
+            return self._bands_cache[key]
+        
+        # Map FFT bins to frequency bands with one matmul
+        with profiler.span('audio.bands'):
+            band_matrix = build_band_matrix(spectrum.shape[1], num_bands, layout,
+                                            self.sample_rate or 22050)
+            bands = spectrum @ band_matrix
+        self._bands_cache[key] = bands
         return bands
     
     def get_frame_spectrum(self, frame_number: int, frame_rate: int = 30) -> np.ndarray:
@@ -131,12 +459,13 @@ class AudioProcessor:
         Returns:
             Array of spectrum magnitudes for the frame
         """
-        spectrum = self.compute_spectrum(frame_rate=frame_rate)
-        if frame_number >= spectrum.shape[1]:
-            frame_number = spectrum.shape[1] - 1
-        return spectrum[:, frame_number]
+        spectrum = self._get_spectrum_frames(frame_rate=frame_rate)
+        if frame_number >= spectrum.shape[0]:
+            frame_number = spectrum.shape[0] - 1
+        return spectrum[frame_number]
     
-    def get_frame_bands(self, frame_number: int, num_bands: int = 64, frame_rate: int = 30) -> np.ndarray:
+    def get_frame_bands(self, frame_number: int, num_bands: int = 64, frame_rate: int = 30,
+                        band_layout: Optional[str] = None) -> np.ndarray:
         """
         Get frequency bands for a specific frame.
         
@@ -144,11 +473,13 @@ class AudioProcessor:
             frame_number: Frame number (0-indexed)
             num_bands: Number of frequency bands
             frame_rate: Video frame rate
+            band_layout: Band layout name (None uses the processor default)
             
         Returns:
             Array of band magnitudes for the frame
         """
-        bands = self.get_frequency_bands(num_bands=num_bands, frame_rate=frame_rate)
+        bands = self.get_frequency_bands(num_bands=num_bands, frame_rate=frame_rate,
+                                         band_layout=band_layout)
         if frame_number >= bands.shape[0]:
             frame_number = bands.shape[0] - 1
         return bands[frame_number]
@@ -165,18 +496,95 @@ class AudioProcessor:
         Returns:
             Intensity value (0.0 to 1.0)
         """
+        intensity = self.get_intensity_timeline(frame_rate, window_size)
+        if frame_number < 0 or frame_number >= len(intensity):
+            return 0.0
+        return float(intensity[frame_number])
+    
+    def get_intensity_timeline(self, frame_rate: int = 30, window_size: int = 10) -> np.ndarray:
+        """
+        Get audio intensity for every frame at once.
+        
+        Args:
+            frame_rate: Video frame rate
+            window_size: Number of frames to average over
+            
+        Returns:
+            Array of shape (num_frames,) with intensity values (0.0 to 1.0)
+        """
+        key = (frame_rate, window_size)
+        if key in self._intensity_cache:
+            return self._intensity_cache[key]
+        
         bands = self.get_frequency_bands(num_bands=64, frame_rate=frame_rate)
-        start_frame = max(0, frame_number - window_size // 2)
-        end_frame = min(bands.shape[0], frame_number + window_size // 2)
+        num_frames = bands.shape[0]
         
-        if start_frame >= end_frame:
-            return 0.0
+        # Windowed mean energy from a running sum of per-frame band means
+        frame_energy = np.concatenate(([0.0], np.cumsum(bands.mean(axis=1, dtype=np.float64))))
+        intensity = self.intensity_from_energy(frame_energy, np.arange(num_frames), num_frames, window_size)
+        self._intensity_cache[key] = intensity
+        return intensity
+    
+    @staticmethod
+    def intensity_from_energy(frame_energy: np.ndarray, frames: np.ndarray, num_frames: int,
+                              window_size: int) -> np.ndarray:
+        """
+        Get the intensity of frames from the running sum of per-frame band means.
+        
+        Args:
+            frame_energy: (num_frames + 1,) running sum, starting at 0
+            frames: Frame numbers to evaluate
+            num_frames: Frames in the track
+            window_size: Number of frames to average over
+            
+        Returns:
+            float32 intensity (0.0 to 1.0) per frame
+        """
+        start_frames = np.maximum(0, frames - window_size // 2)
+        end_frames = np.minimum(num_frames, frames + window_size // 2)
+        counts = end_frames - start_frames
+        energy = np.zeros(len(frames))
+        valid = counts > 0
+        energy[valid] = (frame_energy[end_frames[valid]] - frame_energy[start_frames[valid]]) / counts[valid]
         
-        # Calculate RMS energy
-        energy = np.mean(bands[start_frame:end_frame])
         # Normalize (this is a simple normalization, may need tuning)
-        intensity = min(1.0, energy / 0.1)  # Adjust threshold as needed
-        return float(intensity)
+        return np.minimum(1.0, energy / 0.1).astype(np.float32)  # Adjust threshold as needed
+    
+    def get_feature_table(self, num_bands: int = 64, frame_rate: int = 30,
+                          band_layout: Optional[str] = None,
+                          include_beats: bool = True) -> FeatureTable:
+        """
+        Get per-frame bands, spectrum, beat strength and intensity for a render.
+        
+        Args:
+            num_bands: Number of frequency bands
+            frame_rate: Video frame rate
+            band_layout: Band layout name (None uses the processor default)
+            include_beats: Whether beat strength is needed (runs beat detection on first use)
+            
+        Returns:
+            FeatureTable covering every frame
+        """
+        streaming = self._streaming
+        if (streaming is not None and not streaming.done and
+                streaming.covers(num_bands, frame_rate, band_layout or self.band_layout)):
+            # Frames become readable while the analysis runs; beats wait for its end
+            beat_timeline_fn = None
+            if include_beats:
+                beat_timeline_fn = lambda: self.get_beat_timelines(frame_rate)
+            return FeatureTable(streaming.bands, streaming.spectrum, streaming.intensity,
+                                beat_timeline_fn, progress=streaming)
+        
+        bands = self.get_frequency_bands(num_bands=num_bands, frame_rate=frame_rate,
+                                         band_layout=band_layout)
+        spectrum = self._get_spectrum_frames(frame_rate=frame_rate)
+        intensity = self.get_intensity_timeline(frame_rate)
+        
+        beat_timeline_fn = None
+        if include_beats:
+            beat_timeline_fn = lambda: self.get_beat_timelines(frame_rate)
+        
+        return FeatureTable(bands, spectrum, intensity, beat_timeline_fn)
     
     def detect_beats(self) -> Tuple[float, np.ndarray]:
         """
@@ -185,29 +593,34 @@ class AudioProcessor:
         Returns:
             Tuple of (tempo in BPM, beat frame numbers)
         """
+        self.wait_for_analysis()
         if self._tempo is not None and self._beat_frames is not None:
             return self._tempo, self._beat_frames
         
         audio_data, sr = self.load_audio()
         
         # Detect tempo and beat frames
-        tempo, beat_frames = librosa.beat.beat_track(y=audio_data, sr=sr)
+        with profiler.span('audio.beats'):
+            tempo, beat_frames = librosa.beat.beat_track(y=audio_data, sr=sr)
         
-        # Convert tempo from array to float if needed
-        if isinstance(tempo, np.ndarray):
-            tempo = float(tempo[0]) if len(tempo) > 0 else 120.0
-        else:
-            tempo = float(tempo)
+        tempo = self.tempo_value(tempo)
         
         # Convert beat frames to time
         beat_times = librosa.frames_to_time(beat_frames, sr=sr)
         
         self._tempo = tempo
         self._beat_frames = beat_frames
-        self._beat_times = beat_times
+        self._set_beat_times(beat_times)
         
         return tempo, beat_frames
     
+    @staticmethod
+    def tempo_value(tempo) -> float:
+        """Convert the tempo returned by librosa.beat.beat_track (float or array) to a float."""
+        if isinstance(tempo, np.ndarray):
+            return float(tempo[0]) if len(tempo) > 0 else 120.0
+        return float(tempo)
+    
     def get_tempo(self) -> float:
         """
         Get the tempo (BPM) of the audio.
@@ -230,6 +643,101 @@ class AudioProcessor:
             self.detect_beats()
         return self._beat_times if self._beat_times is not None else np.array([])
     
+    def _set_beat_times(self, beat_times: np.ndarray) -> None:
+        """Store beat times and drop the timelines derived from earlier ones."""
+        self._beat_times = beat_times
+        self._beat_distance_cache.clear()
+        self._beat_strength_cache.clear()
+        self._is_beat_cache.clear()
+    
+    def _nearest_beat_distance(self, frame_numbers: np.ndarray, frame_rate: int) -> np.ndarray:
+        """
+        Get the distance in frames from each frame to its nearest beat.
+        
+        Args:
+            frame_numbers: Frame numbers
+            frame_rate: Video frame rate
+            
+        Returns:
+            Distances in frames (inf when there are no beats)
+        """
+        beat_times = np.sort(self.get_beat_times())
+        frame_times = np.asarray(frame_numbers) / frame_rate
+        if len(beat_times) == 0:
+            return np.full(frame_times.shape, np.inf)
+        
+        # Nearest beat is one of the two neighbours of the insertion point
+        right = np.searchsorted(beat_times, frame_times)
+        left = np.maximum(right - 1, 0)
+        right = np.minimum(right, len(beat_times) - 1)
+        min_diff = np.minimum(np.abs(beat_times[left] - frame_times),
+                              np.abs(beat_times[right] - frame_times))
+        return min_diff * frame_rate
+    
+    def _get_beat_distance_timeline(self, frame_rate: int) -> np.ndarray:
+        """Get the nearest-beat distance for every frame, computed once per frame rate."""
+        if frame_rate not in self._beat_distance_cache:
+            num_frames = int(self.get_duration() * frame_rate)
+            self._beat_distance_cache[frame_rate] = self._nearest_beat_distance(
+                np.arange(num_frames), frame_rate
+            )
+        return self._beat_distance_cache[frame_rate]
+    
+    @staticmethod
+    def _strength_from_distance(frame_diff: np.ndarray) -> np.ndarray:
+        """Exponential beat decay: 1.0 at a beat, 0.0 beyond 10 frames."""
+        strength = np.zeros(frame_diff.shape)
+        near = frame_diff < 10  # Within 10 frames
+        strength[near] = np.clip(np.exp(-frame_diff[near] / 3.0), 0.0, 1.0)  # Decay factor
+        return strength
+    
+    def get_beat_strength_timeline(self, frame_rate: int = 30) -> np.ndarray:
+        """
+        Get beat strength for every frame.
+        
+        Args:
+            frame_rate: Video frame rate
+            
+        Returns:
+            Array of shape (num_frames,) with beat strength (1.0 at beat, fades to 0.0)
+        """
+        if frame_rate not in self._beat_strength_cache:
+            self._beat_strength_cache[frame_rate] = self._strength_from_distance(
+                self._get_beat_distance_timeline(frame_rate)
+            )
+        return self._beat_strength_cache[frame_rate]
+    
+    def get_is_beat_timeline(self, frame_rate: int = 30, tolerance: int = 2) -> np.ndarray:
+        """
+        Get the near-beat flag for every frame.
+        
+        Args:
+            frame_rate: Video frame rate
+            tolerance: Number of frames tolerance around beat
+            
+        Returns:
+            Boolean array of shape (num_frames,)
+        """
+        key = (frame_rate, tolerance)
+        if key not in self._is_beat_cache:
+            self._is_beat_cache[key] = self._get_beat_distance_timeline(frame_rate) <= tolerance
+        return self._is_beat_cache[key]
+    
+    def get_beat_timelines(self, frame_rate: int = 30,
+                           tolerance: int = 2) -> Tuple[np.ndarray, np.ndarray]:
+        """
+        Get the per-frame beat strength and near-beat flag arrays.
+        
+        Args:
+            frame_rate: Video frame rate
+            tolerance: Number of frames tolerance around beat
+            
+        Returns:
+            Tuple of (beat_strength, is_beat) arrays of shape (num_frames,)
+        """
+        return (self.get_beat_strength_timeline(frame_rate),
+                self.get_is_beat_timeline(frame_rate, tolerance))
+    
     def is_beat_frame(self, frame_number: int, frame_rate: int = 30, tolerance: int = 2) -> bool:
         """
         Check if a frame is close to a beat.
@@ -242,21 +750,12 @@ class AudioProcessor:
         Returns:
             True if frame is near a beat
         """
-        beat_times = self.get_beat_times()
-        if len(beat_times) == 0:
-            return False
-        
-        # Convert frame number to time
-        frame_time = frame_number / frame_rate
-        
-        # Check if any beat is within tolerance
-        for beat_time in beat_times:
-            time_diff = abs(frame_time - beat_time)
-            frame_diff = time_diff * frame_rate
-            if frame_diff <= tolerance:
-                return True
+        is_beat = self.get_is_beat_timeline(frame_rate, tolerance)
+        if 0 <= frame_number < len(is_beat):
+            return bool(is_beat[frame_number])
         
-        return False
+        # Outside the timeline (e.g. past the end): evaluate this frame directly
+        return bool(self._nearest_beat_distance(np.array([frame_number]), frame_rate)[0] <= tolerance)
     
     def get_beat_strength(self, frame_number: int, frame_rate: int = 30) -> float:
         """
@@ -269,25 +768,12 @@ class AudioProcessor:
         Returns:
             Beat strength (1.0 at beat, fades to 0.0)
         """
-        beat_times = self.get_beat_times()
-        if len(beat_times) == 0:
-            return 0.0
-        
-        frame_time = frame_number / frame_rate
-        
-        # Find closest beat
-        time_diffs = np.abs(beat_times - frame_time)
-        min_diff = np.min(time_diffs)
-        
-        # Convert to frame difference
-        frame_diff = min_diff * frame_rate
-        
-        # Calculate strength (exponential decay)
-        if frame_diff < 10:  # Within 10 frames
-            strength = np.exp(-frame_diff / 3.0)  # Decay factor
-            return float(np.clip(strength, 0.0, 1.0))
+        strength = self.get_beat_strength_timeline(frame_rate)
+        if 0 <= frame_number < len(strength):
+            return float(strength[frame_number])
         
-        return 0.0
+        frame_diff = self._nearest_beat_distance(np.array([frame_number]), frame_rate)
+        return float(self._strength_from_distance(frame_diff)[0])
     
     def compute_onset_envelope(self) -> np.ndarray:
         """
@@ -296,13 +782,15 @@ class AudioProcessor:
         Returns:
             Onset strength envelope
         """
+        self.wait_for_analysis()
         if self._onset_envelope is not None:
             return self._onset_envelope
         
         audio_data, sr = self.load_audio()
         
         # Compute onset strength
-        onset_env = librosa.onset.onset_strength(y=audio_data, sr=sr)
+        with profiler.span('audio.onset'):
+            onset_env = librosa.onset.onset_strength(y=audio_data, sr=sr)
         
         self._onset_envelope = onset_env
         return onset_env
@@ -0,0 +1,378 @@
+"""
+Batch rendering module for MP3 Spectrum Visualizer.
+Renders a manifest of (audio, template, output) jobs without the GUI. Every
+track is decoded and analyzed once; all jobs of that track share the analysis
+through read-only memory-mapped arrays and run on a process pool.
+"""
+
+import json
+import os
+import shutil
+import sys
+import tempfile
+import time
+from dataclasses import asdict, dataclass, field
+from multiprocessing import cpu_count, get_context
+from typing import Any, Callable, Dict, List, Optional, Tuple
+
+import numpy as np
+
+from core.logger import get_logger
+
+try:
+    import resource
+except ImportError:  # Windows: peak memory is not reported
+    resource = None
+
+
+@dataclass
+class BatchJob:
+    """One output video of a batch."""
+    audio_path: str
+    output_path: str
+    template: Optional[str] = None
+    settings: Dict[str, Any] = field(default_factory=dict)  # Applied on top of the template
+    name: str = ''
+
+
+@dataclass
+class JobResult:
+    """Outcome and cost of one batch job."""
+    name: str
+    output_path: str
+    success: bool
+    frames: int = 0
+    seconds: float = 0.0
+    fps: float = 0.0
+    peak_memory_mb: Optional[float] = None  # Peak RSS of the render process
+    encoder_peak_memory_mb: Optional[float] = None  # Peak RSS of its ffmpeg process
+    error: str = ''
+    
+    def to_dict(self) -> Dict[str, Any]:
+        """Get the result as a JSON-serializable dictionary."""
+        return asdict(self)
+
+
+def load_manifest(path: str) -> Tuple[List[BatchJob], Dict[str, Any], int]:
+    """
+    Load a batch manifest.
+    
+    The manifest is JSON: {"settings": {...}, "workers": N, "jobs": [...]}. A
+    job is {"audio", "template", "output", "settings"}, or {"audio", "outputs":
+    [{"template", "output", "settings"}, ...]} to render one track in several
+    formats. Relative paths are resolved against the manifest's directory.
+    
+    Args:
+        path: Manifest file path
+    
+    Returns:
+        (jobs, settings shared by every job, workers from the manifest or 0)
+    
+    Raises:
+        ValueError: If the manifest is malformed
+    """
+    with open(path, 'r') as f:
+        manifest = json.load(f)
+    base_dir = os.path.dirname(os.path.abspath(path))
+    
+    def resolve(entry_path: str) -> str:
+        return os.path.normpath(os.path.join(base_dir, os.path.expanduser(entry_path)))
+    
+    jobs = []
+    for index, entry in enumerate(manifest.get('jobs', [])):
+        if 'audio' not in entry:
+            raise ValueError(f"Job {index} has no 'audio'")
+        outputs = entry.get('outputs', [entry])
+        for output in outputs:
+            if 'output' not in output:
+                raise ValueError(f"Job {index} has an output without 'output'")
+            settings = dict(entry.get('settings', {})) if output is not entry else {}
+            settings.update(output.get('settings', {}))
+            output_path = resolve(output['output'])
+            jobs.append(BatchJob(
+                audio_path=resolve(entry['audio']),
+                output_path=output_path,
+                template=output.get('template', entry.get('template')),
+                settings=settings,
+                name=output.get('name', os.path.basename(output_path)),
+            ))
+    if not jobs:
+        raise ValueError("Manifest has no jobs")
+    return jobs, manifest.get('settings', {}), int(manifest.get('workers', 0))
+
+
+def _peak_memory_mb(who) -> Optional[float]:
+    """Peak RSS of this process or its children in MB (None where unsupported)."""
+    if resource is None:
+        return None
+    peak = resource.getrusage(who).ru_maxrss
+    # ru_maxrss is in bytes on macOS and in kilobytes elsewhere
+    return peak / (1024 * 1024) if sys.platform == 'darwin' else peak / 1024
+
+
+def _render_job(task: Tuple[str, str, Dict[str, Any], Dict[str, Any], Dict[str, str]]) -> JobResult:
+    """
+    Render one job in a pool worker.
+    
+    Args:
+        task: (name, output path, settings, scalar features, array name -> .npy path)
+    
+    Returns:
+        Job result
+    """
+    name, output_path, settings, features, array_paths = task
+    from core.audio_processor import AudioProcessor
+    from core.video_generator import VideoGenerator
+    
+    started = time.perf_counter()
+    frames = 0
+    
+    def on_status(status: Dict[str, Any]) -> None:
+        nonlocal frames
+        if status.get('stage') == 'complete':
+            frames = status.get('total_frames', 0)
+    
+    try:
+        arrays = {key: np.load(path, mmap_mode='r') for key, path in array_paths.items()}
+        audio_processor = AudioProcessor.from_features({**features, **arrays})
+        output_dir = os.path.dirname(output_path)
+        if output_dir:
+            os.makedirs(output_dir, exist_ok=True)
+        generator = VideoGenerator(audio_processor, settings)
+        success = generator.generate_video(output_path, status_callback=on_status)
+        error = '' if success else 'render failed, see log'
+    except Exception as e:
+        get_logger().error(f"Batch job '{name}' failed: {e}", exc_info=True)
+        success, error = False, str(e)
+    
+    seconds = time.perf_counter() - started
+    return JobResult(
+        name=name,
+        output_path=output_path,
+        success=success,
+        frames=frames,
+        seconds=seconds,
+        fps=frames / seconds if seconds > 0 else 0.0,
+        peak_memory_mb=_peak_memory_mb(resource.RUSAGE_SELF) if resource else None,
+        encoder_peak_memory_mb=_peak_memory_mb(resource.RUSAGE_CHILDREN) if resource else None,
+        error=error,
+    )
+
+
+class BatchRenderer:
+    """
+    Renders batch jobs on a process pool, sharing audio analysis per track.
+    
+    Jobs are grouped by (track, frame rate). Each group's track is decoded and
+    analyzed once in this process (through the analysis cache when given), its
+    spectrum and band matrices are written to .npy files, and every job of the
+    group memory-maps them read-only instead of decoding the track again.
+    
+    Each job runs in a fresh worker process, so its peak memory is its own.
+    Jobs render their frames in that process (frame-level multiprocessing is
+    off); the batch gets its parallelism from running jobs side by side.
+    """
+    
+    def __init__(self, jobs: List[BatchJob], settings: Dict[str, Any], workers: int = 0,
+                 analysis_cache=None, templates_dir: str = 'templates'):
+        """
+        Initialize batch renderer.
+        
+        Args:
+            jobs: Jobs to render
+            settings: Settings shared by every job, before templates are applied
+            workers: Jobs rendered at once (0 means half the CPU cores)
+            analysis_cache: Optional AnalysisCache for the per-track analysis
+            templates_dir: Directory of user templates
+        """
+        self.jobs = jobs
+        self.settings = settings
+        self.workers = workers if workers > 0 else max(1, cpu_count() // 2)
+        self.analysis_cache = analysis_cache
+        self.templates_dir = templates_dir
+    
+    def resolve_settings(self, job: BatchJob) -> Dict[str, Any]:
+        """
+        Get the render settings of a job: shared settings, then template, then overrides.
+        
+        Args:
+            job: Batch job
+        
+        Returns:
+            Settings dictionary
+        
+        Raises:
+            ValueError: If the job's template doesn't exist
+        """
+        from core.templates import TemplateManager
+        
+        settings = dict(self.settings)
+        if job.template:
+            manager = TemplateManager(self.templates_dir)
+            if manager.get_template(job.template) is None:
+                raise ValueError(f"Unknown template '{job.template}' in job '{job.name}'")
+            settings = manager.apply_template(job.template, settings)
+        settings.update(job.settings)
+        # Pool workers cannot start render processes of their own
+        settings['use_multiprocessing'] = False
+        return settings
+    
+    def run(self, result_callback: Optional[Callable[[JobResult], None]] = None) -> List[JobResult]:
+        """
+        Render all jobs.
+        
+        Args:
+            result_callback: Called with each JobResult as its job finishes
+        
+        Returns:
+            Results in the order jobs finished
+        """
+        logger = get_logger()
+        results: List[JobResult] = []
+        
+        def finish(result: JobResult) -> None:
+            results.append(result)
+            if result_callback:
+                result_callback(result)
+        
+        groups: Dict[Tuple[str, int], List[Tuple[BatchJob, Dict[str, Any]]]] = {}
+        for job in self.jobs:
+            try:
+                settings = self.resolve_settings(job)
+            except ValueError as e:
+                finish(JobResult(job.name, job.output_path, False, error=str(e)))
+                continue
+            key = (job.audio_path, settings.get('frame_rate', 30))
+            groups.setdefault(key, []).append((job, settings))
+        
+        feature_dir = tempfile.mkdtemp(prefix='spectrum_viz_batch_')
+        try:
+            tasks = []
+            for index, ((audio_path, frame_rate), group) in enumerate(groups.items()):
+                try:
+                    features, spectrum_path, band_paths = self._share_analysis(
+                        audio_path, frame_rate, [settings for _, settings in group],
+                        os.path.join(feature_dir, f'track_{index}')
+                    )
+                except Exception as e:
+                    logger.error(f"Analysis of {audio_path} failed: {e}", exc_info=True)
+                    for job, _ in group:
+                        finish(JobResult(job.name, job.output_path, False, error=f"analysis failed: {e}"))
+                    continue
+                
+                for job, settings in group:
+                    layout = settings.get('band_layout', 'squared_log')
+                    job_features = {**features, 'band_layout': layout}
+                    array_paths = {'spectrum': spectrum_path, 'bands': band_paths[layout]}
+                    tasks.append((job.name, job.output_path, settings, job_features, array_paths))
+            
+            if tasks:
+                logger.info(f"Rendering {len(tasks)} jobs of {len(groups)} tracks "
+                            f"on {self.workers} worker processes")
+                # Spawned like the frame renderer's workers; one job per process
+                # keeps every job's peak memory measurement separate
+                context = get_context('spawn')
+                with context.Pool(min(self.workers, len(tasks)), maxtasksperchild=1) as pool:
+                    for result in pool.imap_unordered(_render_job, tasks):
+                        finish(result)
+        finally:
+            shutil.rmtree(feature_dir, ignore_errors=True)
+        return results
+    
+    def _share_analysis(self, audio_path: str, frame_rate: int, settings_list: List[Dict[str, Any]],
+                        track_dir: str) -> Tuple[Dict[str, Any], str, Dict[str, str]]:
+        """
+        Analyze a track once and write its arrays for the group's workers.
+        
+        Args:
+            audio_path: Track path
+            frame_rate: Frame rate of the group
+            settings_list: Settings of every job of the group
+            track_dir: Directory for the .npy files
+        
+        Returns:
+            (scalar features, spectrum .npy path, band layout -> bands .npy path)
+        """
+        from core.audio_processor import AudioProcessor
+        
+        logger = get_logger()
+        started = time.perf_counter()
+        processor = AudioProcessor(audio_path, analysis_cache=self.analysis_cache)
+        if self.analysis_cache is not None:
+            # Workers need the whole analysis, but streaming keeps long tracks out of memory
+            processor.analyze(frame_rate=frame_rate,
+                              stream_longer_than=settings_list[0].get('streaming_analysis_seconds', 1200))
+        include_beats = any(s.get('beat_sync_enabled', False) or
+                            s.get('background_beat_shake_enabled', False) for s in settings_list)
+        features = processor.export_features(frame_rate=frame_rate, include_beats=include_beats)
+        
+        os.makedirs(track_dir, exist_ok=True)
+        spectrum_path = os.path.join(track_dir, 'spectrum.npy')
+        np.save(spectrum_path, np.ascontiguousarray(features.pop('spectrum')))
+        band_paths = {}
+        for layout in sorted({s.get('band_layout', 'squared_log') for s in settings_list}):
+            path = os.path.join(track_dir, f'bands_{layout}.npy')
+            bands = processor.get_frequency_bands(num_bands=64, frame_rate=frame_rate, band_layout=layout)
+            np.save(path, np.ascontiguousarray(bands))
+            band_paths[layout] = path
+        
+        logger.info(f"Analyzed {os.path.basename(audio_path)} once for {len(settings_list)} jobs "
+                    f"in {time.perf_counter() - started:.1f}s")
+        return features, spectrum_path, band_paths
+
+
+def run_batch(manifest_path: str, workers: int = 0, report_path: Optional[str] = None,
+              settings_file: Optional[str] = None) -> bool:
+    """
+    Render a batch manifest from the command line.
+    
+    Args:
+        manifest_path: Manifest file path (see load_manifest)
+        workers: Jobs rendered at once (0 uses the manifest, then the batch_workers setting)
+        report_path: Optional path of a JSON report with every job's result
+        settings_file: Optional settings JSON used as the base of every job
+    
+    Returns:
+        True if every job succeeded
+    """
+    from core.analysis_cache import AnalysisCache
+    from core.settings import SettingsManager
+    
+    logger = get_logger()
+    jobs, manifest_settings, manifest_workers = load_manifest(manifest_path)
+    
+    settings_manager = SettingsManager(settings_file) if settings_file else SettingsManager()
+    settings = settings_manager.load_settings() if settings_file else dict(SettingsManager.DEFAULT_SETTINGS)
+    settings.update(manifest_settings)
+    workers = workers or manifest_workers or settings.get('batch_workers', 0)
+    
+    analysis_cache = None
+    if settings.get('analysis_cache_enabled', True):
+        analysis_cache = AnalysisCache(settings.get('analysis_cache_dir', ''))
+    
+    def report(result: JobResult) -> None:
+        if result.success:
+            memory = f", peak memory {result.peak_memory_mb:.0f} MB" if result.peak_memory_mb else ''
+            logger.info(f"[{result.name}] {result.frames} frames in {result.seconds:.1f}s "
+                        f"({result.fps:.1f} fps){memory}")
+        else:
+            logger.error(f"[{result.name}] failed: {result.error}")
+    
+    started = time.perf_counter()
+    renderer = BatchRenderer(jobs, settings, workers, analysis_cache)
+    results = renderer.run(report)
+    elapsed = time.perf_counter() - started
+    
+    total_frames = sum(result.frames for result in results)
+    succeeded = sum(1 for result in results if result.success)
+    logger.info(f"Batch finished: {succeeded}/{len(results)} jobs, {total_frames} frames "
+                f"in {elapsed:.1f}s ({total_frames / elapsed if elapsed > 0 else 0:.1f} fps overall)")
+    
+    if report_path:
+        with open(report_path, 'w') as f:
+            json.dump({
+                'seconds': elapsed,
+                'frames': total_frames,
+                'jobs': [result.to_dict() for result in results],
+            }, f, indent=4)
+    return succeeded == len(results)
@@ -0,0 +1,165 @@
+"""
+Blur and glow kernels for MP3 Spectrum Visualizer.
+Approximates Gaussian blur with separable box filters at reduced resolution
+(OpenCV-backed) for background blur and visualizer glow.
+"""
+
+import math
+from typing import List, Optional
+
+import cv2
+import numpy as np
+
+from core import profiler
+
+
+# Box filter passes used to approximate one Gaussian
+BOX_PASSES = 3
+
+# Largest downsampling factor per axis (4 = quarter resolution)
+MAX_DOWNSAMPLE = 4
+
+
+def box_sizes(sigma: float, passes: int = BOX_PASSES) -> List[int]:
+    """
+    Get odd box widths whose repeated application approximates a Gaussian.
+    
+    Args:
+        sigma: Gaussian standard deviation in pixels
+        passes: Number of box filter passes
+    
+    Returns:
+        Box width for each pass
+    """
+    ideal = math.sqrt(12.0 * sigma * sigma / passes + 1.0)
+    lower = int(ideal)
+    if lower % 2 == 0:
+        lower -= 1
+    lower = max(lower, 1)
+    upper = lower + 2
+    
+    lower_passes = round((12.0 * sigma * sigma - passes * lower * lower - 4 * passes * lower - 3 * passes)
+                         / (-4.0 * lower - 4.0))
+    return [lower if i < lower_passes else upper for i in range(passes)]
+
+
+def downsample_factor(sigma: float) -> int:
+    """
+    Get how far an image can be downsampled before blurring by sigma.
+    
+    The blur stays at least 3 pixels wide at the reduced resolution, so
+    bilinear upsampling of the result is visually smooth.
+    
+    Args:
+        sigma: Gaussian standard deviation in full-resolution pixels
+    
+    Returns:
+        Downsampling factor per axis (1 to MAX_DOWNSAMPLE)
+    """
+    return int(min(max(sigma // 3, 1), MAX_DOWNSAMPLE))
+
+
+def gaussian_blur(pixels: np.ndarray, sigma: float, factor: Optional[int] = None) -> np.ndarray:
+    """
+    Blur an image: downsample, separable box passes, bilinear upsample.
+    
+    Args:
+        pixels: (height, width, channels) uint8 or float32 array
+        sigma: Gaussian standard deviation in pixels
+        factor: Downsampling factor per axis (None picks one from sigma)
+    
+    Returns:
+        Blurred float32 array of the same shape
+    """
+    height, width = pixels.shape[:2]
+    if factor is None:
+        factor = downsample_factor(sigma)
+    
+    low_width = max(-(-width // factor), 1)
+    low_height = max(-(-height // factor), 1)
+    if factor > 1:
+        low = cv2.resize(pixels, (low_width, low_height), interpolation=cv2.INTER_AREA)
+    else:
+        low = pixels
+    low = low.astype(np.float32)
+    
+    for size in box_sizes(sigma / factor):
+        if size > 1:
+            low = cv2.blur(low, (size, size), borderType=cv2.BORDER_REPLICATE)
+    
+    if factor > 1:
+        # Resizing to whole multiples keeps the sample grid aligned with the source
+        low = cv2.resize(low, (low_width * factor, low_height * factor),
+                         interpolation=cv2.INTER_LINEAR)[:height, :width]
+    if low.ndim < pixels.ndim:
+        # OpenCV drops a trailing single channel
+        low = low[:, :, np.newaxis]
+    return low
+
+
+class GlowKernel:
+    """
+    Glow/bloom for straight-alpha RGBA regions, with work buffers reused per resolution.
+    
+    The glow is blurred in premultiplied space at reduced resolution and the
+    original is blended over it in one pass.
+    """
+    
+    def __init__(self, width: int, height: int):
+        """
+        Initialize glow buffers for the largest region (the frame).
+        
+        Args:
+            width: Frame width
+            height: Frame height
+        """
+        self.width = width
+        self.height = height
+        self._premultiplied = np.empty((height, width, 4), dtype=np.float32)
+        self._alpha = np.empty((height, width, 1), dtype=np.float32)
+        self._inv_alpha = np.empty((height, width, 1), dtype=np.float32)
+        self._work = np.empty((height, width, 3), dtype=np.float32)
+    
+    @staticmethod
+    def margin(sigma: float) -> int:
+        """Get how far the glow spreads beyond the drawn pixels."""
+        return int(3 * sigma) + MAX_DOWNSAMPLE
+    
+    def apply(self, region: np.ndarray, sigma: float) -> None:
+        """
+        Add glow to an RGBA region in place.
+        
+        Args:
+            region: (height, width, 4) uint8 straight-alpha pixels, at most frame size
+            sigma: Glow standard deviation in pixels
+        """
+        with profiler.span('layer.glow'):
+            height, width = region.shape[:2]
+            alpha = self._alpha[:height, :width]
+            inv_alpha = self._inv_alpha[:height, :width]
+            premultiplied = self._premultiplied[:height, :width]
+            work = self._work[:height, :width]
+            
+            np.multiply(region[:, :, 3:4], 1.0 / 255.0, out=alpha, casting='unsafe')
+            np.multiply(region[:, :, :3], alpha, out=premultiplied[:, :, :3], casting='unsafe')
+            premultiplied[:, :, 3:4] = alpha
+            
+            glow = gaussian_blur(premultiplied, sigma)
+            
+            # Original over glow: out = src + glow * (1 - src_alpha)
+            np.subtract(1.0, alpha, out=inv_alpha)
+            np.multiply(glow[:, :, :3], inv_alpha, out=work)
+            work += premultiplied[:, :, :3]
+            np.multiply(glow[:, :, 3:4], inv_alpha, out=inv_alpha)
+            alpha += inv_alpha
+            
+            # Back to straight alpha
+            np.maximum(alpha, 1.0 / 255.0, out=inv_alpha)
+            work /= inv_alpha
+            work += 0.5
+            np.clip(work, 0.0, 255.0, out=work)
+            region[:, :, :3] = work
+            alpha *= 255.0
+            alpha += 0.5
+            np.clip(alpha, 0.0, 255.0, out=alpha)
+            region[:, :, 3:4] = alpha
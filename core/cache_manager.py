@@ -1,188 +1,282 @@
 """
 Cache management module for MP3 Spectrum Visualizer.
-Provides intelligent caching for computed data and resources.
+Provides a single byte-budgeted LRU cache for computed data and resources.
 """
 
-from typing import Any, Dict, Optional, Tuple
+import threading
+from collections import OrderedDict
+from typing import Any, Callable, Dict, Hashable, Optional, Tuple
 import numpy as np
-from functools import lru_cache
-import hashlib
+from PIL import Image
+
+
+def estimate_nbytes(value: Any) -> int:
+    """
+    Estimate the memory held by a cached value.
+
+    Args:
+        value: NumPy array, PIL Image, bytes, an object with an nbytes attribute
+               or a tuple/list of those
+
+    Returns:
+        Approximate size in bytes
+    """
+    if isinstance(value, np.ndarray):
+        return value.nbytes
+    if isinstance(value, Image.Image):
+        return value.width * value.height * len(value.getbands())
+    if isinstance(value, (bytes, bytearray, memoryview)):
+        return len(value)
+    if isinstance(value, (tuple, list)):
+        return sum(estimate_nbytes(item) for item in value)
+    # Objects such as sprites report their own size
+    nbytes = getattr(value, 'nbytes', None)
+    if isinstance(nbytes, int):
+        return nbytes
+    return 64
 
 
 class CacheManager:
-    """Manages caching for expensive operations."""
-    
-    def __init__(self, max_size: int = 100):
+    """
+    LRU cache bounded by total bytes, shared by every cache user of a render.
+
+    Entries live under a namespace (e.g. 'background', 'logo', 'video_frame') so
+    one budget governs all of them. Arrays are stored and returned as read-only
+    views; images are returned without copying and must not be modified in place.
+    """
+
+    DEFAULT_BUDGET_BYTES = 512 * 1024 * 1024
+
+    def __init__(self, max_bytes: int = DEFAULT_BUDGET_BYTES):
         """
         Initialize cache manager.
-        
+
+        Args:
+            max_bytes: Maximum total size of cached values in bytes
+        """
+        self.max_bytes = max_bytes
+        self._entries: 'OrderedDict[Tuple[str, Hashable], Tuple[Any, int]]' = OrderedDict()
+        self._bytes_used = 0
+        self._namespace_bytes: Dict[str, int] = {}
+        self._hits = 0
+        self._misses = 0
+        self._evictions = 0
+        self._lock = threading.RLock()
+
+    def put(self, namespace: str, key: Hashable, value: Any, nbytes: Optional[int] = None,
+            evict: bool = True) -> bool:
+        """
+        Cache a value, evicting least recently used entries to stay within budget.
+
+        Args:
+            namespace: Cache namespace
+            key: Key within the namespace
+            value: Value to cache
+            nbytes: Size of the value (estimated if None)
+            evict: Whether older entries may be evicted to make room
+
+        Returns:
+            True if the value was cached, False if it does not fit
+        """
+        if nbytes is None:
+            nbytes = estimate_nbytes(value)
+        if isinstance(value, np.ndarray):
+            value = value.view()
+            value.flags.writeable = False
+
+        full_key = (namespace, key)
+        with self._lock:
+            self._remove(full_key)
+
+            if nbytes > self.max_bytes:
+                return False
+            if not evict and self._bytes_used + nbytes > self.max_bytes:
+                return False
+
+            while self._bytes_used + nbytes > self.max_bytes:
+                oldest_key = next(iter(self._entries))
+                self._remove(oldest_key)
+                self._evictions += 1
+
+            self._entries[full_key] = (value, nbytes)
+            self._bytes_used += nbytes
+            self._namespace_bytes[namespace] = self._namespace_bytes.get(namespace, 0) + nbytes
+            return True
+
+    def get(self, namespace: str, key: Hashable, default: Any = None) -> Any:
+        """
+        Get a cached value and mark it most recently used.
+
         Args:
-            max_size: Maximum number of items to cache
-        """
-        self.max_size = max_size
-        self._spectrum_cache: Dict[int, np.ndarray] = {}
-        self._bands_cache: Dict[Tuple[int, int], np.ndarray] = {}
-        self._image_cache: Dict[str, Any] = {}
-        self._access_count: Dict[str, int] = {}
-    
+            namespace: Cache namespace
+            key: Key within the namespace
+            default: Value returned on a miss
+
+        Returns:
+            Cached value (read-only) or default
+        """
+        full_key = (namespace, key)
+        with self._lock:
+            entry = self._entries.get(full_key)
+            if entry is None:
+                self._misses += 1
+                return default
+            self._entries.move_to_end(full_key)
+            self._hits += 1
+            return entry[0]
+
+    def get_or_create(self, namespace: str, key: Hashable, factory: Callable[[], Any]) -> Any:
+        """
+        Get a cached value, creating and caching it on a miss.
+
+        Args:
+            namespace: Cache namespace
+            key: Key within the namespace
+            factory: Builds the value on a miss
+
+        Returns:
+            Cached or newly created value
+        """
+        value = self.get(namespace, key)
+        if value is None:
+            value = factory()
+            if value is not None:
+                self.put(namespace, key, value)
+        return value
+
+    def contains(self, namespace: str, key: Hashable) -> bool:
+        """Check whether a key is cached without touching recency or stats."""
+        with self._lock:
+            return (namespace, key) in self._entries
+
+    def available_bytes(self) -> int:
+        """Get the budget left before entries have to be evicted."""
+        with self._lock:
+            return self.max_bytes - self._bytes_used
+
+    def invalidate(self, namespace: str, key: Optional[Hashable] = None) -> None:
+        """
+        Remove one entry, or every entry of a namespace when key is None.
+
+        Args:
+            namespace: Cache namespace
+            key: Key within the namespace (None removes the whole namespace)
+        """
+        with self._lock:
+            if key is not None:
+                self._remove((namespace, key))
+                return
+            for full_key in [k for k in self._entries if k[0] == namespace]:
+                self._remove(full_key)
+
+    def _remove(self, full_key: Tuple[str, Hashable]) -> None:
+        """Remove an entry and release its bytes (caller holds the lock)."""
+        entry = self._entries.pop(full_key, None)
+        if entry is not None:
+            self._bytes_used -= entry[1]
+            self._namespace_bytes[full_key[0]] -= entry[1]
+
     def cache_spectrum(self, frame_number: int, spectrum: np.ndarray) -> None:
         """
         Cache spectrum data for a frame.
-        
+
         Args:
             frame_number: Frame number
             spectrum: Spectrum data
         """
-        if len(self._spectrum_cache) >= self.max_size:
-            # Remove least accessed item
-            self._evict_lru(self._spectrum_cache)
-        
-        self._spectrum_cache[frame_number] = spectrum.copy()
-        self._access_count[f'spectrum_{frame_number}'] = 0
-    
+        self.put('spectrum', frame_number, spectrum)
+
     def get_spectrum(self, frame_number: int) -> Optional[np.ndarray]:
         """
         Get cached spectrum data.
-        
+
         Args:
             frame_number: Frame number
-            
+
         Returns:
-            Spectrum data or None if not cached
-        """
-        key = f'spectrum_{frame_number}'
-        if frame_number in self._spectrum_cache:
-            self._access_count[key] = self._access_count.get(key, 0) + 1
-            return self._spectrum_cache[frame_number].copy()
-        return None
-    
+            Read-only spectrum data or None if not cached
+        """
+        return self.get('spectrum', frame_number)
+
     def cache_bands(self, frame_number: int, num_bands: int, bands: np.ndarray) -> None:
         """
         Cache frequency bands for a frame.
-        
+
         Args:
             frame_number: Frame number
             num_bands: Number of bands
             bands: Band data
         """
-        key = (frame_number, num_bands)
-        
-        if len(self._bands_cache) >= self.max_size:
-            self._evict_lru(self._bands_cache)
-        
-        self._bands_cache[key] = bands.copy()
-        self._access_count[f'bands_{frame_number}_{num_bands}'] = 0
-    
+        self.put('bands', (frame_number, num_bands), bands)
+
     def get_bands(self, frame_number: int, num_bands: int) -> Optional[np.ndarray]:
         """
         Get cached frequency bands.
-        
+
         Args:
             frame_number: Frame number
             num_bands: Number of bands
-            
+
         Returns:
-            Band data or None if not cached
-        """
-        key = (frame_number, num_bands)
-        cache_key = f'bands_{frame_number}_{num_bands}'
-        
-        if key in self._bands_cache:
-            self._access_count[cache_key] = self._access_count.get(cache_key, 0) + 1
-            return self._bands_cache[key].copy()
-        return None
-    
+            Read-only band data or None if not cached
+        """
+        return self.get('bands', (frame_number, num_bands))
+
     def cache_image(self, image_path: str, image: Any) -> None:
         """
         Cache an image.
-        
+
         Args:
             image_path: Path to image (used as key)
             image: PIL Image object
         """
-        if len(self._image_cache) >= self.max_size:
-            self._evict_lru(self._image_cache)
-        
-        self._image_cache[image_path] = image.copy()
-        self._access_count[f'image_{image_path}'] = 0
-    
+        self.put('image', image_path, image)
+
     def get_image(self, image_path: str) -> Optional[Any]:
         """
         Get cached image.
-        
+
         Args:
             image_path: Path to image
-            
+
         Returns:
-            PIL Image or None if not cached
-        """
-        key = f'image_{image_path}'
-        if image_path in self._image_cache:
-            self._access_count[key] = self._access_count.get(key, 0) + 1
-            return self._image_cache[image_path].copy()
-        return None
-    
-    def _evict_lru(self, cache: Dict) -> None:
-        """
-        Evict least recently used item from cache.
-        
-        Args:
-            cache: Cache dictionary to evict from
-        """
-        if not cache:
-            return
-        
-        # Find least accessed item
-        min_key = None
-        min_count = float('inf')
-        
-        for key in cache.keys():
-            # Create access key based on cache type
-            if isinstance(key, tuple):
-                access_key = f'bands_{key[0]}_{key[1]}'
-            elif isinstance(key, int):
-                access_key = f'spectrum_{key}'
-            else:
-                access_key = f'image_{key}'
-            
-            count = self._access_count.get(access_key, 0)
-            if count < min_count:
-                min_count = count
-                min_key = key
-        
-        # Remove least accessed item
-        if min_key is not None:
-            del cache[min_key]
-            # Clean up access count
-            if isinstance(min_key, tuple):
-                access_key = f'bands_{min_key[0]}_{min_key[1]}'
-            elif isinstance(min_key, int):
-                access_key = f'spectrum_{min_key}'
-            else:
-                access_key = f'image_{min_key}'
-            self._access_count.pop(access_key, None)
-    
+            PIL Image (do not modify in place) or None if not cached
+        """
+        return self.get('image', image_path)
+
     def clear(self) -> None:
         """Clear all caches."""
-        self._spectrum_cache.clear()
-        self._bands_cache.clear()
-        self._image_cache.clear()
-        self._access_count.clear()
-    
-    def get_cache_stats(self) -> Dict[str, int]:
+        with self._lock:
+            self._entries.clear()
+            self._namespace_bytes.clear()
+            self._bytes_used = 0
+
+    def get_cache_stats(self) -> Dict[str, Any]:
         """
         Get cache statistics.
-        
+
         Returns:
-            Dictionary with cache statistics
+            Dictionary with entry counts, byte usage and hit/miss/eviction counters
         """
-        return {
-            'spectrum_cached': len(self._spectrum_cache),
-            'bands_cached': len(self._bands_cache),
-            'images_cached': len(self._image_cache),
-            'total_cached': len(self._spectrum_cache) + len(self._bands_cache) + len(self._image_cache)
-        }
-
-
-
+        with self._lock:
+            namespace_counts: Dict[str, int] = {}
+            for namespace, _ in self._entries:
+                namespace_counts[namespace] = namespace_counts.get(namespace, 0) + 1
+            lookups = self._hits + self._misses
 
+            return {
+                'spectrum_cached': namespace_counts.get('spectrum', 0),
+                'bands_cached': namespace_counts.get('bands', 0),
+                'images_cached': namespace_counts.get('image', 0),
+                'total_cached': len(self._entries),
+                'namespaces': {
+                    namespace: {'entries': count, 'bytes': self._namespace_bytes.get(namespace, 0)}
+                    for namespace, count in namespace_counts.items()
+                },
+                'bytes_used': self._bytes_used,
+                'max_bytes': self.max_bytes,
+                'hits': self._hits,
+                'misses': self._misses,
+                'evictions': self._evictions,
+                'hit_rate': self._hits / lookups if lookups else 0.0,
+            }
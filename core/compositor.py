@@ -0,0 +1,364 @@
+"""
+Frame compositing module for MP3 Spectrum Visualizer.
+Blends background, visualizer, overlay and sprite layers into one preallocated
+frame buffer with NumPy in-place operations, and emits RGB24 or YUV 4:2:0 frames.
+"""
+
+from typing import Dict, Optional, Tuple, Union
+
+import cv2
+import numpy as np
+from PIL import Image
+
+from core.effects import translation_matrix, warp_affine
+from core.layers import Layer, LayerSnapshot
+from core.logger import get_logger
+from core.sprites import Sprite
+
+
+# BT.709 luma coefficients
+KR, KB = 0.2126, 0.0722
+KG = 1.0 - KR - KB
+
+# Raw 4:2:0 formats the compositor can emit
+YUV_FORMATS = ('yuv420p', 'nv12')
+
+
+def yuv420_frame_size(width: int, height: int) -> int:
+    """Get the byte size of a 4:2:0 frame (chroma planes round odd sizes up)."""
+    return width * height + 2 * ((width + 1) // 2) * ((height + 1) // 2)
+
+
+def bt709_matrices(full_range: bool = False) -> Tuple[np.ndarray, np.ndarray]:
+    """
+    Get the BT.709 RGB -> YCbCr matrices for 8-bit RGB input.
+    
+    The offsets include +0.5, so truncating the clipped result rounds.
+    
+    Args:
+        full_range: True for full range (0-255), False for limited range
+                    (Y 16-235, Cb/Cr 16-240)
+    
+    Returns:
+        (luma, chroma) affine matrices of shape (1, 4) and (2, 4), for cv2.transform
+    """
+    if full_range:
+        luma_scale, chroma_scale, luma_offset = 1.0, 1.0, 0.0
+    else:
+        luma_scale, chroma_scale, luma_offset = 219.0 / 255.0, 224.0 / 255.0, 16.0
+    
+    luma = np.array([[KR, KG, KB, 0.0]]) * luma_scale
+    luma[0, 3] = luma_offset + 0.5
+    
+    # Cb = (B - Y) / (2 (1 - Kb)), Cr = (R - Y) / (2 (1 - Kr))
+    cb = (np.array([0.0, 0.0, 1.0]) - np.array([KR, KG, KB])) / (2.0 * (1.0 - KB))
+    cr = (np.array([1.0, 0.0, 0.0]) - np.array([KR, KG, KB])) / (2.0 * (1.0 - KR))
+    chroma = np.zeros((2, 4))
+    chroma[0, :3] = cb * chroma_scale
+    chroma[1, :3] = cr * chroma_scale
+    chroma[:, 3] = 128.0 + 0.5
+    return luma.astype(np.float32), chroma.astype(np.float32)
+
+
+class YUVConverter:
+    """
+    Converts float or 8-bit RGB frames to raw BT.709 YUV 4:2:0 in a reused buffer.
+    
+    Luma is one affine transform per pixel; chroma is transformed after a 2x2
+    area downsample of the RGB frame, which is the same as averaging the
+    full-resolution chroma because the transform is linear.
+    """
+    
+    def __init__(self, width: int, height: int, pix_fmt: str = 'yuv420p', full_range: bool = False):
+        """
+        Initialize converter buffers.
+        
+        Args:
+            width: Frame width
+            height: Frame height
+            pix_fmt: 'yuv420p' (planar Y, U, V) or 'nv12' (Y plane, interleaved UV)
+            full_range: Full (0-255) instead of limited (16-235) range
+        """
+        if pix_fmt not in YUV_FORMATS:
+            raise ValueError(f"Unsupported YUV format: {pix_fmt}")
+        
+        self.width = width
+        self.height = height
+        self.pix_fmt = pix_fmt
+        self.chroma_size = ((width + 1) // 2, (height + 1) // 2)
+        chroma_width, chroma_height = self.chroma_size
+        
+        self.out = np.empty(yuv420_frame_size(width, height), dtype=np.uint8)
+        self._y_plane = self.out[:width * height].reshape(height, width)
+        chroma = self.out[width * height:]
+        if pix_fmt == 'nv12':
+            self._uv_plane = chroma.reshape(chroma_height, chroma_width, 2)
+        else:
+            plane = chroma_width * chroma_height
+            self._u_plane = chroma[:plane].reshape(chroma_height, chroma_width)
+            self._v_plane = chroma[plane:].reshape(chroma_height, chroma_width)
+        
+        self._rgb = None  # Float copy, only needed for 8-bit input
+        self._luma = np.empty((height, width), dtype=np.float32)
+        self._chroma_rgb = np.empty((chroma_height, chroma_width, 3), dtype=np.float32)
+        self._chroma = np.empty((chroma_height, chroma_width, 2), dtype=np.float32)
+        self._luma_matrix, self._chroma_matrix = bt709_matrices(full_range)
+    
+    def convert(self, rgb: np.ndarray) -> np.ndarray:
+        """
+        Convert one frame.
+        
+        Args:
+            rgb: (height, width, 3) float32 (0-255, e.g. the compositor canvas) or uint8 array
+        
+        Returns:
+            Flat uint8 YUV frame, overwritten by the next call
+        """
+        if rgb.dtype != np.float32:
+            if self._rgb is None:
+                self._rgb = np.empty((self.height, self.width, 3), dtype=np.float32)
+            np.copyto(self._rgb, rgb, casting='unsafe')
+            rgb = self._rgb
+        
+        cv2.transform(rgb, self._luma_matrix, dst=self._luma)
+        np.clip(self._luma, 0.0, 255.0, out=self._luma)
+        np.copyto(self._y_plane, self._luma, casting='unsafe')
+        
+        cv2.resize(rgb, self.chroma_size, dst=self._chroma_rgb, interpolation=cv2.INTER_AREA)
+        cv2.transform(self._chroma_rgb, self._chroma_matrix, dst=self._chroma)
+        np.clip(self._chroma, 0.0, 255.0, out=self._chroma)
+        if self.pix_fmt == 'nv12':
+            np.copyto(self._uv_plane, self._chroma, casting='unsafe')
+        else:
+            np.copyto(self._u_plane, self._chroma[:, :, 0], casting='unsafe')
+            np.copyto(self._v_plane, self._chroma[:, :, 1], casting='unsafe')
+        return self.out
+
+
+class FrameCompositor:
+    """
+    Composites layers into a reusable float32 canvas and emits RGB24 or YUV frames.
+    
+    The canvas is always opaque, so it stores premultiplied RGB with an implicit
+    alpha of 1. All work buffers are allocated once per resolution.
+    """
+    
+    def __init__(self, width: int, height: int):
+        """
+        Initialize compositor buffers.
+        
+        Args:
+            width: Frame width
+            height: Frame height
+        """
+        self.width = width
+        self.height = height
+        self.canvas = np.zeros((height, width, 3), dtype=np.float32)
+        self._color_work = np.empty((height, width, 3), dtype=np.float32)
+        self._alpha_work = np.empty((height, width, 1), dtype=np.float32)
+        self._rgb_out = np.empty((height, width, 3), dtype=np.uint8)
+        self._warp_out = np.empty((height, width, 3), dtype=np.uint8)
+        self._yuv_converters: Dict[Tuple[str, bool], YUVConverter] = {}
+    
+    def make_current(self) -> None:
+        """Prepare the compositor for use from the calling thread (nothing to do on CPU)."""
+    
+    def supports_visualizer(self, visualizer) -> bool:
+        """Visualizers are always rendered into CPU layers by this compositor."""
+        return False
+    
+    def begin(self, background: Image.Image, opacity: int = 100,
+              transform: Optional[np.ndarray] = None) -> None:
+        """
+        Start a frame from a background image.
+        
+        Args:
+            background: Background image (frame size)
+            opacity: Background opacity (0-100), composited over black
+            transform: Optional 3x3 affine matrix (beat pulse/zoom/shake) applied
+                       while the background is copied in
+        """
+        if background.mode != 'RGB':
+            background = background.convert('RGB')
+        pixels = np.asarray(background)
+        if transform is not None:
+            pixels = warp_affine(pixels, transform, (self.width, self.height), out=self._warp_out)
+        np.copyto(self.canvas, pixels, casting='unsafe')
+        if opacity < 100:
+            self.canvas *= max(opacity, 0) / 100.0
+    
+    def add_layer(self, layer: Union[Layer, LayerSnapshot, Image.Image], opacity: int = 100,
+                  transform: Optional[np.ndarray] = None) -> None:
+        """
+        Blend a straight-alpha RGBA layer over the canvas ("over" operator).
+        
+        Layers are blended over their dirty box only; plain images cover the frame.
+        
+        Args:
+            layer: Layer, layer snapshot or RGBA image (frame size)
+            opacity: Layer opacity (0-100), multiplied into the layer alpha
+            transform: Optional 3x3 affine matrix applied to the layer while blending
+        """
+        if opacity <= 0:
+            return
+        if isinstance(layer, (Layer, LayerSnapshot)):
+            box = layer.finish()
+            if box is None:
+                return
+            pixels = layer.pixels(box)
+        else:
+            if layer.mode != 'RGBA':
+                layer = layer.convert('RGBA')
+            box = (0, 0, self.width, self.height)
+            pixels = np.asarray(layer)
+        
+        if transform is not None:
+            box, pixels = self._warp_region(box, pixels, transform)
+            if box is None:
+                return
+        
+        left, top, right, bottom = box
+        region = self.canvas[top:bottom, left:right]
+        alpha = self._alpha_work[:bottom - top, :right - left]
+        np.multiply(pixels[:, :, 3:4], min(opacity, 100) / (100.0 * 255.0), out=alpha,
+                    casting='unsafe')
+        
+        # region += (color - region) * alpha
+        color = self._color_work[:bottom - top, :right - left]
+        np.subtract(pixels[:, :, :3], region, out=color, casting='unsafe')
+        color *= alpha
+        region += color
+    
+    def _warp_region(self, box, pixels: np.ndarray, transform: np.ndarray):
+        """
+        Transform a layer region, producing the region it covers afterwards.
+        
+        Args:
+            box: (left, top, right, bottom) frame box of the pixels
+            pixels: (height, width, 4) uint8 region
+            transform: 3x3 affine matrix in frame coordinates
+        
+        Returns:
+            (box, pixels) of the transformed region; box is None when it leaves the frame
+        """
+        left, top, right, bottom = box
+        corners = np.array([[left, top, 1], [right, top, 1], [left, bottom, 1], [right, bottom, 1]],
+                           dtype=np.float64)
+        moved = corners @ transform[:2].T
+        dst_left = max(int(np.floor(moved[:, 0].min())) - 1, 0)
+        dst_top = max(int(np.floor(moved[:, 1].min())) - 1, 0)
+        dst_right = min(int(np.ceil(moved[:, 0].max())) + 1, self.width)
+        dst_bottom = min(int(np.ceil(moved[:, 1].max())) + 1, self.height)
+        if dst_left >= dst_right or dst_top >= dst_bottom:
+            return None, None
+        
+        # Same transform expressed between the source and destination regions
+        region_transform = translation_matrix(-dst_left, -dst_top) @ transform @ translation_matrix(left, top)
+        warped = warp_affine(pixels, region_transform, (dst_right - dst_left, dst_bottom - dst_top))
+        return (dst_left, dst_top, dst_right, dst_bottom), warped
+    
+    def blend_color(self, color, amount: float) -> None:
+        """
+        Blend a solid color over the whole canvas (flash and strobe effects).
+        
+        Args:
+            color: RGB color
+            amount: Blend amount (0.0 to 1.0)
+        """
+        if amount <= 0:
+            return
+        amount = min(amount, 1.0)
+        self.canvas *= 1.0 - amount
+        self.canvas += np.asarray(color, dtype=np.float32) * amount
+    
+    def add_sprite(self, sprite: Optional[Sprite]) -> None:
+        """
+        Blend a premultiplied sprite over its bounding box.
+        
+        Args:
+            sprite: Sprite to blend (None is ignored)
+        """
+        if sprite is not None:
+            sprite.blend_into(self.canvas)
+    
+    def to_rgb(self) -> np.ndarray:
+        """
+        Convert the canvas to RGB24.
+        
+        Returns:
+            (height, width, 3) uint8 array, reused by the next call
+        """
+        np.add(self.canvas, 0.5, out=self._color_work)
+        np.clip(self._color_work, 0.0, 255.0, out=self._color_work)
+        np.copyto(self._rgb_out, self._color_work, casting='unsafe')
+        return self._rgb_out
+    
+    def to_yuv(self, pix_fmt: str = 'yuv420p', full_range: bool = False) -> np.ndarray:
+        """
+        Convert the canvas straight to BT.709 YUV 4:2:0, without an RGB24 pass.
+        
+        Args:
+            pix_fmt: 'yuv420p' or 'nv12'
+            full_range: Full (0-255) instead of limited (16-235) range
+        
+        Returns:
+            Flat uint8 frame, reused by the next call
+        """
+        return get_yuv_converter(self._yuv_converters, self.width, self.height,
+                                 pix_fmt, full_range).convert(self.canvas)
+    
+    def to_output(self, pix_fmt: str = 'rgb24', full_range: bool = False) -> np.ndarray:
+        """
+        Emit the frame in a raw pipe format.
+        
+        Args:
+            pix_fmt: 'rgb24', 'yuv420p' or 'nv12'
+            full_range: Full range YUV (ignored for RGB)
+        
+        Returns:
+            uint8 array, reused by the next call
+        """
+        if pix_fmt in YUV_FORMATS:
+            return self.to_yuv(pix_fmt, full_range)
+        return self.to_rgb()
+    
+    def to_image(self) -> Image.Image:
+        """
+        Get the canvas as an RGB PIL Image (a copy, safe to keep).
+        
+        Returns:
+            RGB PIL Image
+        """
+        return Image.fromarray(self.to_rgb())
+
+
+def get_yuv_converter(converters: Dict[Tuple[str, bool], YUVConverter], width: int, height: int,
+                      pix_fmt: str, full_range: bool) -> YUVConverter:
+    """Get a converter from a per-compositor cache, creating it on first use."""
+    key = (pix_fmt, full_range)
+    converter = converters.get(key)
+    if converter is None:
+        converter = YUVConverter(width, height, pix_fmt, full_range)
+        converters[key] = converter
+    return converter
+
+
+def create_compositor(width: int, height: int, backend: str = 'cpu'):
+    """
+    Create the frame compositor for a render backend.
+    
+    Args:
+        width: Frame width
+        height: Frame height
+        backend: 'cpu' or 'gpu' (falls back to cpu when OpenGL is unavailable)
+    
+    Returns:
+        FrameCompositor or GPUFrameCompositor
+    """
+    if backend == 'gpu':
+        try:
+            from core.gpu_compositor import GPUFrameCompositor
+            return GPUFrameCompositor(width, height)
+        except Exception as e:
+            get_logger().warning(f"GPU render backend unavailable, using CPU: {e}")
+    return FrameCompositor(width, height)
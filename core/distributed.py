@@ -0,0 +1,361 @@
+"""
+Distributed rendering module for MP3 Spectrum Visualizer.
+Splits a render into GOP-aligned segments, renders them on local or remote
+worker nodes, and joins the encoded segments with ffmpeg's concat demuxer
+without re-encoding, muxing the audio once at the end.
+"""
+
+import json
+import os
+import queue
+import shlex
+import shutil
+import subprocess
+import sys
+import threading
+import time
+from dataclasses import dataclass
+from multiprocessing import cpu_count
+from typing import Any, Callable, Dict, List, Optional, Tuple
+
+import ffmpeg
+
+from core.encoders import QUALITY_LEVELS
+from core.logger import get_logger
+
+
+# Tries per segment before the render gives up
+MAX_SEGMENT_ATTEMPTS = 3
+
+
+def plan_segments(total_frames: int, segment_frames: int, gop_frames: int) -> List[Tuple[int, int]]:
+    """
+    Split a timeline into segments that start on GOP boundaries.
+    
+    Args:
+        total_frames: Frames in the render
+        segment_frames: Wanted frames per segment (rounded down to whole GOPs)
+        gop_frames: Frames per GOP
+    
+    Returns:
+        (start_frame, end_frame) ranges covering [0, total_frames)
+    """
+    gop_frames = max(int(gop_frames), 1)
+    length = max(int(segment_frames) // gop_frames, 1) * gop_frames
+    return [(start, min(start + length, total_frames)) for start in range(0, total_frames, length)]
+
+
+@dataclass
+class SegmentTask:
+    """One segment of a distributed render."""
+    index: int
+    start_frame: int
+    end_frame: int
+    task_path: str  # JSON task file read by the node
+    output_path: str
+    attempts: int = 0
+
+
+def render_segment_task(task_path: str) -> bool:
+    """
+    Render the segment described by a task file (run on a worker node).
+    
+    The task file holds the audio path, settings, frame range, GOP size and
+    output path. With a shared analysis cache the node memory-maps the
+    coordinator's analysis instead of decoding the track.
+    
+    Args:
+        task_path: Path of the JSON task file
+    
+    Returns:
+        True if the segment was encoded
+    """
+    from core.analysis_cache import AnalysisCache
+    from core.audio_processor import AudioProcessor
+    from core.video_generator import VideoGenerator
+    
+    with open(task_path, 'r') as f:
+        task = json.load(f)
+    settings = task['settings']
+    
+    analysis_cache = None
+    if settings.get('analysis_cache_enabled', True):
+        analysis_cache = AnalysisCache(settings.get('analysis_cache_dir', ''))
+    audio_processor = AudioProcessor(task['audio_path'], band_layout=settings.get('band_layout', 'squared_log'),
+                                     analysis_cache=analysis_cache)
+    if analysis_cache is not None:
+        audio_processor.analyze(frame_rate=settings.get('frame_rate', 30))
+    else:
+        audio_processor.load_audio()
+    
+    generator = VideoGenerator(audio_processor, settings)
+    return generator.render_segment(task['output_path'], task['start_frame'], task['end_frame'],
+                                    task['gop_frames'])
+
+
+class SegmentNode:
+    """
+    A worker node that renders segment tasks through a command.
+    
+    The command is this program's entry point on the node, e.g.
+    "python3 main.py" locally or "ssh render1 cd /srv/mp3tovideo && python3
+    main.py" for a remote machine; "--segment <task file>" is appended. Task
+    files, segment outputs, the audio and the analysis cache must be on
+    storage every node sees under the same paths.
+    """
+    
+    def __init__(self, command: List[str], name: str):
+        """
+        Initialize node.
+        
+        Args:
+            command: Command prefix that starts main.py on the node
+            name: Node name for logging
+        """
+        self.command = list(command)
+        self.name = name
+        self.failures = 0
+    
+    def run(self, task: SegmentTask) -> bool:
+        """
+        Render one segment on the node.
+        
+        Args:
+            task: Segment task
+        
+        Returns:
+            True if the node reported success and the segment exists
+        """
+        result = subprocess.run(self.command + ['--segment', task.task_path],
+                                stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True)
+        if result.returncode != 0:
+            tail = '\n'.join(result.stderr.splitlines()[-10:])
+            get_logger().error(f"Node {self.name} failed segment {task.index}: {tail}")
+            return False
+        return os.path.exists(task.output_path)
+
+
+def local_nodes(count: int) -> List[SegmentNode]:
+    """
+    Get nodes that render segments in processes on this machine.
+    
+    Args:
+        count: Number of concurrent segment processes
+    
+    Returns:
+        Segment nodes
+    """
+    main_script = os.path.join(os.path.dirname(os.path.dirname(os.path.abspath(__file__))), 'main.py')
+    return [SegmentNode([sys.executable, main_script], f'local-{i}') for i in range(max(count, 1))]
+
+
+def nodes_from_settings(settings: Dict[str, Any]) -> List[SegmentNode]:
+    """
+    Get the nodes of the distributed_nodes setting, or local nodes when it is empty.
+    
+    Args:
+        settings: Settings dictionary
+    
+    Returns:
+        Segment nodes
+    """
+    commands = settings.get('distributed_nodes', [])
+    if not commands:
+        return local_nodes(max(1, cpu_count() // 2))
+    return [SegmentNode(shlex.split(command), f'node-{i}') for i, command in enumerate(commands)]
+
+
+def concat_segments(segment_paths: List[str], output_path: str, audio_path: str,
+                    list_path: str, audio_bitrate: str = '192k') -> bool:
+    """
+    Join encoded segments with the concat demuxer and mux the audio once.
+    
+    Video packets are copied, not re-encoded.
+    
+    Args:
+        segment_paths: Segment videos in timeline order
+        output_path: Final video path
+        audio_path: Audio track muxed over the whole video
+        list_path: Path for the concat demuxer's list file
+        audio_bitrate: AAC bitrate
+    
+    Returns:
+        True if successful, False otherwise
+    """
+    with open(list_path, 'w') as f:
+        for path in segment_paths:
+            # The concat list quotes paths with single quotes
+            escaped = os.path.abspath(path).replace("'", "'\\''")
+            f.write(f"file '{escaped}'\n")
+    
+    video = ffmpeg.input(list_path, format='concat', safe=0)
+    audio = ffmpeg.input(audio_path)
+    output = ffmpeg.output(
+        video.video, audio.audio, output_path,
+        vcodec='copy', acodec='aac', shortest=None, movflags='+faststart',
+        **{'b:a': audio_bitrate}
+    )
+    try:
+        ffmpeg.run(output, quiet=True, overwrite_output=True)
+        return True
+    except ffmpeg.Error as e:
+        stderr = e.stderr.decode(errors='replace') if e.stderr else ''
+        get_logger().error(f"Concatenating segments failed: {stderr}")
+        return False
+
+
+class DistributedRenderer:
+    """
+    Coordinates a render split into segments over worker nodes.
+    
+    The timeline is cut on GOP boundaries into segments of about
+    segment_seconds. Each node thread takes the next segment from a shared
+    queue, so fast nodes render more of them; a failed segment goes back on
+    the queue for another try, and a node that keeps failing stops taking work.
+    Every segment is encoded with the same software encoder settings, because
+    copying streams together needs identical parameters and nodes may differ
+    in the hardware encoders they have.
+    """
+    
+    def __init__(self, audio_path: str, settings: Dict[str, Any],
+                 nodes: Optional[List[SegmentNode]] = None, work_dir: Optional[str] = None):
+        """
+        Initialize distributed renderer.
+        
+        Args:
+            audio_path: Track to render
+            settings: Settings dictionary
+            nodes: Worker nodes (None uses the distributed_nodes setting)
+            work_dir: Shared directory for task files and segments
+                      (None uses a directory next to the output)
+        """
+        self.audio_path = os.path.abspath(audio_path)
+        self.settings = dict(settings)
+        self.nodes = nodes if nodes is not None else nodes_from_settings(settings)
+        self.work_dir = work_dir
+    
+    def render(self, output_path: str,
+               progress_callback: Optional[Callable[[int, int], None]] = None) -> bool:
+        """
+        Render the track on the nodes and write the joined video.
+        
+        Args:
+            output_path: Final video path
+            progress_callback: Callback function(segments done, total segments)
+        
+        Returns:
+            True if successful, False otherwise
+        """
+        from core.analysis_cache import AnalysisCache
+        from core.audio_processor import AudioProcessor
+        
+        logger = get_logger()
+        started = time.perf_counter()
+        settings = self.settings
+        frame_rate = settings.get('frame_rate', 30)
+        
+        # Analyze once here: with a shared analysis cache nodes only memory-map it
+        analysis_cache = None
+        if settings.get('analysis_cache_enabled', True):
+            analysis_cache = AnalysisCache(settings.get('analysis_cache_dir', ''))
+        else:
+            logger.warning("Analysis cache disabled: every node decodes the track itself")
+        processor = AudioProcessor(self.audio_path, band_layout=settings.get('band_layout', 'squared_log'),
+                                   analysis_cache=analysis_cache)
+        if analysis_cache is not None:
+            processor.analyze(frame_rate=frame_rate,
+                              stream_longer_than=settings.get('streaming_analysis_seconds', 1200))
+            # Nodes load the finished cache entry
+            processor.wait_for_analysis()
+        total_frames = int(processor.get_duration() * frame_rate)
+        
+        gop_frames = int(settings.get('segment_gop_frames', 0)) or frame_rate * 2
+        segment_frames = int(settings.get('segment_seconds', 60) * frame_rate)
+        ranges = plan_segments(total_frames, segment_frames, gop_frames)
+        
+        work_dir = self.work_dir or f'{os.path.abspath(output_path)}.segments'
+        os.makedirs(work_dir, exist_ok=True)
+        segment_settings = dict(settings)
+        segment_settings.update({'use_hardware_acceleration': False, 'output_mode': 'pipe'})
+        
+        tasks = []
+        for index, (start_frame, end_frame) in enumerate(ranges):
+            task = SegmentTask(index, start_frame, end_frame,
+                               os.path.join(work_dir, f'segment_{index:05d}.json'),
+                               os.path.join(work_dir, f'segment_{index:05d}.mp4'))
+            with open(task.task_path, 'w') as f:
+                json.dump({
+                    'audio_path': self.audio_path,
+                    'settings': segment_settings,
+                    'start_frame': start_frame,
+                    'end_frame': end_frame,
+                    'gop_frames': gop_frames,
+                    'output_path': task.output_path,
+                }, f)
+            tasks.append(task)
+        logger.info(f"Rendering {total_frames} frames as {len(tasks)} segments "
+                    f"({gop_frames}-frame GOPs) on {len(self.nodes)} nodes")
+        
+        if not self._run_tasks(tasks, progress_callback):
+            return False
+        
+        quality_preset = settings.get('quality_preset', 'balanced')
+        audio_bitrate = QUALITY_LEVELS.get(quality_preset, QUALITY_LEVELS['balanced'])[1]
+        success = concat_segments([task.output_path for task in tasks], output_path, self.audio_path,
+                                  os.path.join(work_dir, 'segments.txt'), audio_bitrate)
+        if success:
+            shutil.rmtree(work_dir, ignore_errors=True)
+            logger.info(f"Distributed render finished in {time.perf_counter() - started:.1f}s")
+        return success
+    
+    def _run_tasks(self, tasks: List[SegmentTask],
+                   progress_callback: Optional[Callable[[int, int], None]]) -> bool:
+        """Render all segments, one thread per node pulling from a shared queue."""
+        logger = get_logger()
+        pending: 'queue.Queue[SegmentTask]' = queue.Queue()
+        for task in tasks:
+            pending.put(task)
+        lock = threading.Lock()
+        done = []
+        failed = []
+        
+        def work(node: SegmentNode) -> None:
+            while not failed:
+                with lock:
+                    if len(done) == len(tasks):
+                        return
+                try:
+                    task = pending.get(timeout=0.5)
+                except queue.Empty:
+                    # Others may still put a failed segment back
+                    continue
+                if node.run(task):
+                    node.failures = 0
+                    with lock:
+                        done.append(task.index)
+                        if progress_callback:
+                            progress_callback(len(done), len(tasks))
+                    continue
+                
+                task.attempts += 1
+                node.failures += 1
+                if task.attempts >= MAX_SEGMENT_ATTEMPTS:
+                    logger.error(f"Segment {task.index} failed {task.attempts} times, giving up")
+                    failed.append(task.index)
+                    return
+                pending.put(task)
+                if node.failures >= MAX_SEGMENT_ATTEMPTS:
+                    logger.warning(f"Node {node.name} keeps failing, taking it out of the render")
+                    return
+        
+        threads = [threading.Thread(target=work, args=(node,), name=f'segments-{node.name}', daemon=True)
+                   for node in self.nodes]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        
+        if len(done) != len(tasks):
+            logger.error(f"{len(tasks) - len(done)} segments were not rendered")
+            return False
+        return True
@@ -3,10 +3,14 @@ Visual effects module for MP3 Spectrum Visualizer.
 Handles background effects, animations, and strobe effects.
 """
 
+import cv2
 import numpy as np
-from PIL import Image, ImageFilter, ImageEnhance
+from functools import lru_cache
+from PIL import Image, ImageEnhance
 from typing import Tuple, Optional
 
+from core.blur import gaussian_blur
+
 
 def apply_blur(image: Image.Image, intensity: float) -> Image.Image:
     """
@@ -24,7 +28,34 @@ def apply_blur(image: Image.Image, intensity: float) -> Image.Image:
     
     # Convert intensity (0-100) to radius (0-20)
     radius = intensity / 5.0
-    return image.filter(ImageFilter.GaussianBlur(radius=radius))
+    blurred = gaussian_blur(np.asarray(image), radius)
+    blurred += 0.5
+    np.clip(blurred, 0.0, 255.0, out=blurred)
+    return Image.fromarray(blurred.astype(np.uint8))
+
+
+@lru_cache(maxsize=8)
+def _vignette_mask(width: int, height: int, intensity: float) -> np.ndarray:
+    """
+    Build the vignette mask for a resolution and intensity (cached).
+    
+    Args:
+        width: Image width
+        height: Image height
+        intensity: Vignette intensity (0.0 to 100.0)
+        
+    Returns:
+        Read-only (height, width, 1) float32 mask in [0, 1]
+    """
+    center_x, center_y = width / 2, height / 2
+    max_distance = np.sqrt(center_x**2 + center_y**2)
+    
+    y, x = np.ogrid[:height, :width]
+    distance = np.sqrt((x - center_x)**2 + (y - center_y)**2)
+    mask = 1.0 - (distance / max_distance) * (intensity / 100.0)
+    mask = np.clip(mask, 0.0, 1.0).astype(np.float32)[:, :, np.newaxis]
+    mask.flags.writeable = False
+    return mask
 
 
 def apply_vignette(image: Image.Image, intensity: float) -> Image.Image:
@@ -42,23 +73,16 @@ def apply_vignette(image: Image.Image, intensity: float) -> Image.Image:
         return image
     
     width, height = image.size
-    center_x, center_y = width / 2, height / 2
-    max_distance = np.sqrt(center_x**2 + center_y**2)
-    
-    # Convert image to numpy array
-    img_array = np.array(image, dtype=np.float32)
-    
-    # Create vignette mask
-    y, x = np.ogrid[:height, :width]
-    distance = np.sqrt((x - center_x)**2 + (y - center_y)**2)
-    mask = 1.0 - (distance / max_distance) * (intensity / 100.0)
-    mask = np.clip(mask, 0.0, 1.0)
+    mask = _vignette_mask(width, height, float(intensity))
     
-    # Apply vignette (darken edges)
-    for c in range(img_array.shape[2]):
-        img_array[:, :, c] *= mask
+    # Darken edges in one multiply; mask <= 1 keeps values within uint8 range
+    img_array = np.asarray(image)
+    if img_array.ndim == 2:
+        img_array = img_array[:, :, np.newaxis]
+    darkened = np.multiply(img_array, mask, dtype=np.float32)
+    result = darkened.astype(np.uint8)
     
-    return Image.fromarray(np.clip(img_array, 0, 255).astype(np.uint8))
+    return Image.fromarray(result[:, :, 0] if result.shape[2] == 1 else result)
 
 
 def apply_bw(image: Image.Image) -> Image.Image:
@@ -137,22 +161,41 @@ def apply_strobe(frame: Image.Image, spectrum_data: np.ndarray, color: Tuple[int
     Returns:
         Image with strobe effect applied
     """
-    # Calculate average intensity from spectrum
-    audio_intensity = np.mean(spectrum_data) if len(spectrum_data) > 0 else 0.0
-    # Normalize (simple normalization, may need tuning)
-    normalized_intensity = min(1.0, audio_intensity / 0.1)
-    
-    if normalized_intensity < threshold:
+    amount = strobe_amount(spectrum_data, threshold, intensity)
+    if amount <= 0:
         return frame
     
     # Create strobe overlay
     overlay = Image.new('RGB', frame.size, color=color)
     
     # Blend with original frame
-    strobe_frame = Image.blend(frame, overlay, intensity)
+    strobe_frame = Image.blend(frame, overlay, amount)
     return strobe_frame
 
 
+def strobe_amount(spectrum_data: np.ndarray, threshold: float = 0.5,
+                  intensity: float = 0.8) -> float:
+    """
+    Get how strongly the audio-driven strobe color covers the frame.
+    
+    Args:
+        spectrum_data: Spectrum data for the frame
+        threshold: Intensity threshold to trigger strobe (0.0 to 1.0)
+        intensity: Strobe intensity (0.0 to 1.0)
+    
+    Returns:
+        Blend amount (0.0 when the strobe is off)
+    """
+    # Calculate average intensity from spectrum
+    audio_intensity = np.mean(spectrum_data) if len(spectrum_data) > 0 else 0.0
+    # Normalize (simple normalization, may need tuning)
+    normalized_intensity = min(1.0, audio_intensity / 0.1)
+    
+    if normalized_intensity < threshold:
+        return 0.0
+    return intensity
+
+
 def fade_in(frame_number: int, total_frames: int) -> float:
     """
     Calculate fade-in alpha value for a frame.
@@ -220,38 +263,156 @@ def apply_background_animation(base_image: Image.Image, frame_number: int,
         return base_image
 
 
-def apply_beat_pulse(frame: Image.Image, beat_strength: float, 
-                     scale_factor: float = 1.1) -> Image.Image:
+def scale_matrix(size: Tuple[int, int], scale: float) -> np.ndarray:
     """
-    Apply pulse effect on beats by scaling the image.
+    Get the affine matrix that scales a frame about its center.
     
     Args:
-        frame: PIL Image to pulse
+        size: Frame (width, height)
+        scale: Scale factor (>1 enlarges)
+    
+    Returns:
+        3x3 float64 matrix mapping source to destination pixel coordinates
+    """
+    center_x, center_y = (size[0] - 1) / 2.0, (size[1] - 1) / 2.0
+    return np.array([
+        [scale, 0.0, center_x * (1.0 - scale)],
+        [0.0, scale, center_y * (1.0 - scale)],
+        [0.0, 0.0, 1.0],
+    ])
+
+
+def translation_matrix(offset_x: float, offset_y: float) -> np.ndarray:
+    """
+    Get the affine matrix that moves a frame.
+    
+    Args:
+        offset_x: Horizontal offset in pixels
+        offset_y: Vertical offset in pixels
+    
+    Returns:
+        3x3 float64 matrix
+    """
+    return np.array([
+        [1.0, 0.0, offset_x],
+        [0.0, 1.0, offset_y],
+        [0.0, 0.0, 1.0],
+    ])
+
+
+def warp_affine(pixels: np.ndarray, matrix: np.ndarray, size: Tuple[int, int],
+                out: Optional[np.ndarray] = None) -> np.ndarray:
+    """
+    Apply an affine transform with bilinear sampling; uncovered pixels are zero.
+    
+    Args:
+        pixels: (height, width, channels) uint8 array
+        matrix: 3x3 matrix mapping source to destination pixel coordinates
+        size: Destination (width, height)
+        out: Optional destination array of that size and the source dtype
+    
+    Returns:
+        Warped array (out when given)
+    """
+    return cv2.warpAffine(pixels, np.ascontiguousarray(matrix[:2]), size, dst=out,
+                          flags=cv2.INTER_LINEAR, borderMode=cv2.BORDER_CONSTANT, borderValue=0)
+
+
+def warp_image(image: Image.Image, matrix: np.ndarray) -> Image.Image:
+    """
+    Apply an affine transform to a PIL image, keeping its size.
+    
+    Args:
+        image: PIL Image
+        matrix: 3x3 matrix mapping source to destination pixel coordinates
+    
+    Returns:
+        Transformed image
+    """
+    return Image.fromarray(warp_affine(np.asarray(image), matrix, image.size))
+
+
+def beat_pulse_matrix(size: Tuple[int, int], beat_strength: float,
+                      scale_factor: float = 1.1) -> Optional[np.ndarray]:
+    """
+    Get the pulse transform for a beat (enlarge about the center).
+    
+    Args:
+        size: Frame (width, height)
         beat_strength: Beat strength (0.0 to 1.0)
         scale_factor: Maximum scale factor at full beat strength
         
     Returns:
-        Image with pulse effect
+        3x3 matrix, or None when the beat is too weak to move pixels
     """
     if beat_strength < 0.01:
-        return frame
+        return None
+    return scale_matrix(size, 1.0 + (scale_factor - 1.0) * beat_strength)
+
+
+def beat_zoom_matrix(size: Tuple[int, int], beat_strength: float,
+                     zoom_amount: float = 0.05) -> Optional[np.ndarray]:
+    """
+    Get the zoom transform for a beat (crop the center and enlarge it to the frame).
+    
+    Args:
+        size: Frame (width, height)
+        beat_strength: Beat strength (0.0 to 1.0)
+        zoom_amount: Amount to zoom (0.0 to 1.0)
     
-    # Calculate scale based on beat strength
-    scale = 1.0 + (scale_factor - 1.0) * beat_strength
+    Returns:
+        3x3 matrix, or None when the beat is too weak to move pixels
+    """
+    if beat_strength < 0.01:
+        return None
+    return scale_matrix(size, 1.0 + zoom_amount * beat_strength)
+
+
+def beat_shake_matrix(beat_strength: float, intensity: int = 50,
+                      rng: Optional[np.random.Generator] = None) -> Optional[np.ndarray]:
+    """
+    Get the shake transform for a beat (random integer offset).
+    
+    Args:
+        beat_strength: Beat strength (0.0 to 1.0)
+        intensity: Shake intensity (0-100)
+        rng: Random generator for the offset (per-frame seeded for reproducible renders)
     
-    # Scale image
-    width, height = frame.size
-    new_width = int(width * scale)
-    new_height = int(height * scale)
+    Returns:
+        3x3 matrix, or None when there is no shake
+    """
+    if beat_strength < 0.01 or intensity == 0:
+        return None
     
-    scaled = frame.resize((new_width, new_height), Image.Resampling.LANCZOS)
+    # Calculate shake amount based on beat strength and intensity
+    max_shake = int((intensity / 100) * 20)  # Max 20 pixels shake
+    shake_amount = int(max_shake * beat_strength)
     
-    # Crop back to original size (centered)
-    left = (new_width - width) // 2
-    top = (new_height - height) // 2
-    cropped = scaled.crop((left, top, left + width, top + height))
+    # Random offset
+    if rng is None:
+        rng = np.random.default_rng()
+    offset_x = int(rng.integers(-shake_amount, shake_amount + 1))
+    offset_y = int(rng.integers(-shake_amount, shake_amount + 1))
+    return translation_matrix(offset_x, offset_y)
+
+
+def apply_beat_pulse(frame: Image.Image, beat_strength: float, 
+                     scale_factor: float = 1.1) -> Image.Image:
+    """
+    Apply pulse effect on beats by scaling the image.
+    
+    Args:
+        frame: PIL Image to pulse
+        beat_strength: Beat strength (0.0 to 1.0)
+        scale_factor: Maximum scale factor at full beat strength
     
-    return cropped
+    Returns:
+        Image with pulse effect
+    """
+    matrix = beat_pulse_matrix(frame.size, beat_strength, scale_factor)
+    if matrix is None:
+        return frame
+    return warp_image(frame, matrix)
 
 
 def apply_beat_flash(frame: Image.Image, beat_strength: float, 
@@ -269,12 +430,10 @@ def apply_beat_flash(frame: Image.Image, beat_strength: float,
     Returns:
         Image with flash effect
     """
-    if beat_strength < 0.01:
+    intensity = beat_flash_amount(beat_strength, max_intensity)
+    if intensity <= 0:
         return frame
     
-    # Calculate flash intensity
-    intensity = beat_strength * max_intensity
-    
     # Create flash overlay
     overlay = Image.new('RGB', frame.size, color=color)
     
@@ -283,6 +442,22 @@ def apply_beat_flash(frame: Image.Image, beat_strength: float,
     return flashed
 
 
+def beat_flash_amount(beat_strength: float, max_intensity: float = 0.3) -> float:
+    """
+    Get how strongly the flash color covers the frame on a beat.
+    
+    Args:
+        beat_strength: Beat strength (0.0 to 1.0)
+        max_intensity: Maximum flash intensity
+    
+    Returns:
+        Blend amount (0.0 when there is no flash)
+    """
+    if beat_strength < 0.01:
+        return 0.0
+    return beat_strength * max_intensity
+
+
 def apply_beat_strobe(frame: Image.Image, beat_strength: float, 
                       color: Tuple[int, int, int] = (255, 255, 255),
                       threshold: float = 0.5) -> Image.Image:
@@ -298,20 +473,35 @@ def apply_beat_strobe(frame: Image.Image, beat_strength: float,
     Returns:
         Image with beat-synchronized strobe
     """
-    if beat_strength < threshold:
+    intensity = beat_strobe_amount(beat_strength, threshold)
+    if intensity <= 0:
         return frame
     
     # Full intensity strobe on beat
     overlay = Image.new('RGB', frame.size, color=color)
     
-    # Calculate intensity based on beat strength
-    intensity = min(0.8, beat_strength)
-    
     # Blend with original frame
     strobed = Image.blend(frame, overlay, intensity)
     return strobed
 
 
+def beat_strobe_amount(beat_strength: float, threshold: float = 0.5) -> float:
+    """
+    Get how strongly the strobe color covers the frame on a beat.
+    
+    Args:
+        beat_strength: Beat strength (0.0 to 1.0)
+        threshold: Minimum beat strength to trigger strobe
+    
+    Returns:
+        Blend amount (0.0 below the threshold)
+    """
+    if beat_strength < threshold:
+        return 0.0
+    # Calculate intensity based on beat strength
+    return min(0.8, beat_strength)
+
+
 def apply_beat_zoom(frame: Image.Image, beat_strength: float,
                     zoom_amount: float = 0.05) -> Image.Image:
     """
@@ -325,25 +515,10 @@ def apply_beat_zoom(frame: Image.Image, beat_strength: float,
     Returns:
         Image with zoom effect
     """
-    if beat_strength < 0.01:
+    matrix = beat_zoom_matrix(frame.size, beat_strength, zoom_amount)
+    if matrix is None:
         return frame
-    
-    # Calculate zoom based on beat strength
-    zoom = 1.0 + (zoom_amount * beat_strength)
-    
-    width, height = frame.size
-    new_width = int(width / zoom)
-    new_height = int(height / zoom)
-    
-    # Calculate crop box (centered)
-    left = (width - new_width) // 2
-    top = (height - new_height) // 2
-    
-    # Crop and resize back
-    cropped = frame.crop((left, top, left + new_width, top + new_height))
-    zoomed = cropped.resize((width, height), Image.Resampling.LANCZOS)
-    
-    return zoomed
+    return warp_image(frame, matrix)
 
 
 def apply_fade_transition(image1: Image.Image, image2: Image.Image, progress: float) -> Image.Image:
@@ -475,7 +650,8 @@ def apply_zoom_transition(image1: Image.Image, image2: Image.Image, progress: fl
     return apply_fade_transition(zoomed1, image2, progress)
 
 
-def apply_beat_shake(frame: Image.Image, beat_strength: float, intensity: int = 50) -> Image.Image:
+def apply_beat_shake(frame: Image.Image, beat_strength: float, intensity: int = 50,
+                     rng: Optional[np.random.Generator] = None) -> Image.Image:
     """
     Apply shake effect based on beat strength.
     
@@ -483,32 +659,12 @@ def apply_beat_shake(frame: Image.Image, beat_strength: float, intensity: int =
         frame: PIL Image to shake
         beat_strength: Beat strength (0.0 to 1.0)
         intensity: Shake intensity (0-100)
+        rng: Random generator for the offset (per-frame seeded for reproducible renders)
         
     Returns:
         Image with shake effect
     """
-    if beat_strength < 0.01 or intensity == 0:
+    matrix = beat_shake_matrix(beat_strength, intensity, rng)
+    if matrix is None:
         return frame
-    
-    import random
-    
-    width, height = frame.size
-    
-    # Calculate shake amount based on beat strength and intensity
-    max_shake = int((intensity / 100) * 20)  # Max 20 pixels shake
-    shake_amount = int(max_shake * beat_strength)
-    
-    # Random offset
-    offset_x = random.randint(-shake_amount, shake_amount)
-    offset_y = random.randint(-shake_amount, shake_amount)
-    
-    # Create new image with black background
-    result = Image.new('RGB', (width, height), (0, 0, 0))
-    
-    # Paste original image with offset
-    result.paste(frame, (offset_x, offset_y))
-    
-    return result
-
-
-
+    return warp_image(frame, matrix)
@@ -0,0 +1,276 @@
+"""
+Video encoder selection module for MP3 Spectrum Visualizer.
+Probes the hardware encoders ffmpeg can actually use on this machine (NVENC,
+Quick Sync, VAAPI, VideoToolbox) and builds encoder arguments per codec and
+quality preset, falling back to software encoders.
+"""
+
+import platform
+import subprocess
+from dataclasses import dataclass, field
+from typing import Any, Dict, List, Optional, Tuple
+
+from core.logger import get_logger
+
+
+# Output codecs -> ffmpeg encoder per backend
+ENCODERS = {
+    'nvenc': {'h264': 'h264_nvenc', 'hevc': 'hevc_nvenc', 'av1': 'av1_nvenc'},
+    'qsv': {'h264': 'h264_qsv', 'hevc': 'hevc_qsv', 'av1': 'av1_qsv'},
+    'vaapi': {'h264': 'h264_vaapi', 'hevc': 'hevc_vaapi', 'av1': 'av1_vaapi'},
+    'videotoolbox': {'h264': 'h264_videotoolbox', 'hevc': 'hevc_videotoolbox'},
+    'software': {'h264': 'libx264', 'hevc': 'libx265', 'av1': 'libsvtav1'},
+}
+
+# Hardware backends in probing order
+HARDWARE_BACKENDS = ('nvenc', 'qsv', 'vaapi', 'videotoolbox')
+
+# Quality preset -> (video bitrate, audio bitrate, constant quality level)
+QUALITY_LEVELS = {
+    'fast': ('3000k', '128k', 28),
+    'balanced': ('5000k', '192k', 23),
+    'high': ('8000k', '256k', 19),
+}
+
+# Quality preset -> encoder speed preset per hardware backend
+HARDWARE_PRESETS = {
+    'nvenc': {'fast': 'p1', 'balanced': 'p4', 'high': 'p7'},
+    'qsv': {'fast': 'veryfast', 'balanced': 'medium', 'high': 'veryslow'},
+}
+
+# SVT-AV1 speed presets (0 slowest .. 13 fastest) per quality preset
+SVTAV1_PRESETS = {'fast': '12', 'balanced': '8', 'high': '5'}
+
+DEFAULT_VAAPI_DEVICE = '/dev/dri/renderD128'
+
+# Probe results per (ffmpeg encoder, vaapi device), kept for the process lifetime
+_probe_cache: Dict[Tuple[str, str], bool] = {}
+_available_encoders: Optional[List[str]] = None
+
+
+@dataclass
+class EncoderConfig:
+    """Encoder chosen for a render: ffmpeg arguments and the raw frame format it wants."""
+    backend: str
+    codec: str
+    vcodec: str
+    output_args: Dict[str, Any]
+    upload_pix_fmt: str = 'nv12'  # Raw pipe format the encoder consumes without conversion
+    global_args: List[str] = field(default_factory=list)
+    video_filter: Optional[str] = None
+    
+    @property
+    def hardware(self) -> bool:
+        """Whether the encoder runs on a GPU/media engine."""
+        return self.backend != 'software'
+
+
+def list_ffmpeg_encoders() -> List[str]:
+    """
+    Get the names of the encoders compiled into ffmpeg.
+    
+    Returns:
+        Encoder names (empty when ffmpeg cannot be run)
+    """
+    global _available_encoders
+    if _available_encoders is None:
+        try:
+            result = subprocess.run(['ffmpeg', '-hide_banner', '-encoders'],
+                                    capture_output=True, text=True, timeout=15)
+            names = []
+            for line in result.stdout.splitlines():
+                parts = line.split()
+                # Encoder lines look like " V....D h264_nvenc    NVIDIA NVENC H.264 encoder"
+                if len(parts) >= 2 and len(parts[0]) == 6 and parts[0][0] in 'VAS':
+                    names.append(parts[1])
+            _available_encoders = names
+        except (OSError, subprocess.SubprocessError) as e:
+            get_logger().warning(f"Could not list ffmpeg encoders: {e}")
+            _available_encoders = []
+    return _available_encoders
+
+
+def probe_encoder(backend: str, codec: str, vaapi_device: str = DEFAULT_VAAPI_DEVICE) -> bool:
+    """
+    Check that an encoder works by encoding a few frames to the null muxer.
+    
+    Being compiled into ffmpeg is not enough: the driver and device must be
+    present too, so every hardware encoder is test-run once per process.
+    
+    Args:
+        backend: Backend name from ENCODERS
+        codec: Output codec ('h264', 'hevc', 'av1')
+        vaapi_device: DRM render node for VAAPI
+    
+    Returns:
+        True if the encoder produced output
+    """
+    vcodec = ENCODERS.get(backend, {}).get(codec)
+    if vcodec is None or vcodec not in list_ffmpeg_encoders():
+        return False
+    
+    key = (vcodec, vaapi_device if backend == 'vaapi' else '')
+    if key not in _probe_cache:
+        command = ['ffmpeg', '-hide_banner', '-nostats', '-loglevel', 'error']
+        if backend == 'vaapi':
+            command += ['-vaapi_device', vaapi_device]
+        # 256x256 stays above the minimum frame size of every hardware encoder
+        command += ['-f', 'lavfi', '-i', 'color=black:s=256x256:r=30:d=0.1']
+        if backend == 'vaapi':
+            command += ['-vf', 'format=nv12,hwupload']
+        else:
+            command += ['-pix_fmt', 'nv12']
+        command += ['-c:v', vcodec, '-f', 'null', '-']
+        try:
+            result = subprocess.run(command, capture_output=True, timeout=30)
+            _probe_cache[key] = result.returncode == 0
+        except (OSError, subprocess.SubprocessError):
+            _probe_cache[key] = False
+    return _probe_cache[key]
+
+
+def detect_hardware_backends(codec: str = 'h264',
+                             vaapi_device: str = DEFAULT_VAAPI_DEVICE) -> List[str]:
+    """
+    Get the hardware backends that can encode a codec on this machine.
+    
+    Args:
+        codec: Output codec ('h264', 'hevc', 'av1')
+        vaapi_device: DRM render node for VAAPI
+    
+    Returns:
+        Usable backend names in preference order
+    """
+    candidates = list(HARDWARE_BACKENDS)
+    if platform.system() != 'Darwin':
+        candidates.remove('videotoolbox')
+    return [backend for backend in candidates if probe_encoder(backend, codec, vaapi_device)]
+
+
+def select_encoder(settings: Dict[str, Any], use_hardware: Optional[bool] = None) -> EncoderConfig:
+    """
+    Pick the encoder for the render settings.
+    
+    Args:
+        settings: Settings dictionary (video_codec, hardware_encoder, quality_preset,
+                  encoding_preset, vaapi_device)
+        use_hardware: Override of use_hardware_acceleration (False forces software)
+    
+    Returns:
+        Encoder configuration
+    """
+    codec = settings.get('video_codec', 'h264')
+    if codec not in ENCODERS['software']:
+        codec = 'h264'
+    if use_hardware is None:
+        use_hardware = settings.get('use_hardware_acceleration', True)
+    vaapi_device = settings.get('vaapi_device', DEFAULT_VAAPI_DEVICE)
+    
+    backend = 'software'
+    if use_hardware:
+        requested = settings.get('hardware_encoder', 'auto')
+        if requested == 'auto':
+            usable = detect_hardware_backends(codec, vaapi_device)
+            if usable:
+                backend = usable[0]
+        elif probe_encoder(requested, codec, vaapi_device):
+            backend = requested
+        if backend == 'software':
+            get_logger().info(f"No usable hardware {codec} encoder, encoding in software")
+    
+    return build_encoder_config(backend, codec, settings)
+
+
+def build_encoder_config(backend: str, codec: str, settings: Dict[str, Any]) -> EncoderConfig:
+    """
+    Build ffmpeg arguments for an encoder backend.
+    
+    Args:
+        backend: Backend name from ENCODERS
+        codec: Output codec ('h264', 'hevc', 'av1')
+        settings: Settings dictionary
+    
+    Returns:
+        Encoder configuration
+    """
+    quality_preset = settings.get('quality_preset', 'balanced')
+    if quality_preset not in QUALITY_LEVELS:
+        quality_preset = 'balanced'
+    video_bitrate, audio_bitrate, quality = QUALITY_LEVELS[quality_preset]
+    vcodec = ENCODERS[backend][codec]
+    global_args: List[str] = []
+    video_filter = None
+    
+    if backend == 'nvenc':
+        extra_args = {'preset': HARDWARE_PRESETS['nvenc'][quality_preset], 'tune': 'hq',
+                      'rc': 'vbr', 'cq': str(quality), 'b:v': video_bitrate}
+    elif backend == 'qsv':
+        extra_args = {'preset': HARDWARE_PRESETS['qsv'][quality_preset],
+                      'global_quality': str(quality), 'b:v': video_bitrate}
+    elif backend == 'vaapi':
+        # Frames are uploaded to the device as NV12 surfaces inside ffmpeg
+        global_args = ['-vaapi_device', settings.get('vaapi_device', DEFAULT_VAAPI_DEVICE)]
+        video_filter = 'format=nv12,hwupload'
+        extra_args = {'rc_mode': 'VBR', 'b:v': video_bitrate}
+    elif backend == 'videotoolbox':
+        # VideoToolbox doesn't use presets, use quality/bitrate instead
+        extra_args = {'b:v': video_bitrate}
+    elif codec == 'av1':
+        extra_args = {'preset': SVTAV1_PRESETS[quality_preset], 'crf': str(quality + 10)}
+    else:
+        # x265's CRF scale sits about 5 above x264's for the same visual quality
+        crf = quality + 5 if codec == 'hevc' else quality
+        extra_args = {'preset': settings.get('encoding_preset', 'medium'), 'crf': str(crf)}
+    
+    if codec == 'hevc' and backend in ('software', 'videotoolbox'):
+        # Tag HEVC as hvc1 so QuickTime and Apple devices play it
+        extra_args['tag:v'] = 'hvc1'
+    
+    output_args = {
+        'vcodec': vcodec,
+        'acodec': 'aac',
+        'b:a': audio_bitrate,
+        **extra_args
+    }
+    if video_filter is None:
+        output_args['pix_fmt'] = 'nv12' if backend != 'software' else 'yuv420p'
+    
+    return EncoderConfig(
+        backend=backend,
+        codec=codec,
+        vcodec=vcodec,
+        output_args=output_args,
+        upload_pix_fmt='nv12' if backend != 'software' else 'yuv420p',
+        global_args=global_args,
+        video_filter=video_filter,
+    )
+
+
+def fixed_gop_args(encoder: EncoderConfig, gop_frames: int) -> Dict[str, Any]:
+    """
+    Get encoder arguments for fixed-length, closed GOPs.
+    
+    With a keyframe exactly every gop_frames frames and no scene-cut
+    keyframes, separately encoded segments that start on a GOP boundary have
+    the same GOP structure as one continuous encode and can be concatenated
+    without re-encoding.
+    
+    Args:
+        encoder: Encoder configuration
+        gop_frames: Frames per GOP
+    
+    Returns:
+        Extra ffmpeg output arguments
+    """
+    args: Dict[str, Any] = {'g': str(gop_frames)}
+    if encoder.vcodec == 'libx264':
+        # x264 GOPs are closed unless open-gop is requested
+        args.update({'keyint_min': str(gop_frames), 'sc_threshold': '0'})
+    elif encoder.vcodec == 'libx265':
+        args['x265-params'] = f'keyint={gop_frames}:min-keyint={gop_frames}:scenecut=0:open-gop=0'
+    elif encoder.vcodec == 'libsvtav1':
+        args['svtav1-params'] = f'keyint={gop_frames}:scd=0'
+    elif encoder.backend == 'nvenc':
+        args.update({'no-scenecut': '1', 'strict_gop': '1', 'forced-idr': '1'})
+    return args
+
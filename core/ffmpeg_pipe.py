@@ -0,0 +1,182 @@
+"""
+FFmpeg streaming output module for MP3 Spectrum Visualizer.
+Feeds raw video frames into a long-running ffmpeg process over stdin.
+"""
+
+import threading
+from collections import deque
+from typing import Any, Dict, List, Optional, Union
+
+import ffmpeg
+import numpy as np
+from PIL import Image
+
+from core.logger import get_logger
+
+
+class FFmpegPipeWriter:
+    """Streams raw frames into an ffmpeg encoder so encoding overlaps rendering."""
+
+    # Raw input pixel formats: ffmpeg pix_fmt -> (PIL mode, bits per pixel)
+    # YUV 4:2:0 formats have no PIL mode and are written as arrays or bytes
+    PIXEL_FORMATS = {
+        'rgb24': ('RGB', 24),
+        'rgba': ('RGBA', 32),
+        'nv12': (None, 12),
+        'yuv420p': (None, 12),
+    }
+
+    def __init__(self, output_path: str, width: int, height: int, frame_rate: int,
+                 output_args: Dict[str, Any], audio_path: Optional[str] = None,
+                 pix_fmt: str = 'rgb24', global_args: Optional[List[str]] = None,
+                 input_args: Optional[Dict[str, Any]] = None):
+        """
+        Initialize pipe writer.
+
+        Args:
+            output_path: Output video path
+            width: Frame width
+            height: Frame height
+            frame_rate: Frame rate (fps)
+            output_args: ffmpeg output arguments (codec, bitrate, etc.)
+            audio_path: Optional audio file to mux with the video stream
+            pix_fmt: Raw input pixel format ('rgb24', 'rgba', 'nv12' or 'yuv420p')
+            global_args: Extra global ffmpeg arguments (e.g. hardware device setup)
+            input_args: Extra rawvideo input arguments (e.g. color_range of YUV frames)
+        """
+        if pix_fmt not in self.PIXEL_FORMATS:
+            raise ValueError(f"Unsupported raw pixel format: {pix_fmt}")
+
+        self.output_path = output_path
+        self.width = width
+        self.height = height
+        self.frame_rate = frame_rate
+        self.output_args = output_args
+        self.audio_path = audio_path
+        self.pix_fmt = pix_fmt
+        self.global_args = list(global_args or [])
+        self.input_args = dict(input_args or {})
+        self.image_mode, bits_per_pixel = self.PIXEL_FORMATS[pix_fmt]
+        if bits_per_pixel == 12:
+            # 4:2:0 chroma planes round odd frame sizes up
+            self.frame_size = width * height + 2 * ((width + 1) // 2) * ((height + 1) // 2)
+        else:
+            self.frame_size = width * height * bits_per_pixel // 8
+        self.frames_written = 0
+        self.process = None
+        self._stderr_tail = deque(maxlen=50)
+        self._stderr_thread: Optional[threading.Thread] = None
+
+    def start(self) -> None:
+        """Start the ffmpeg process with a rawvideo stdin input."""
+        video_input = ffmpeg.input(
+            'pipe:',
+            format='rawvideo',
+            pix_fmt=self.pix_fmt,
+            s=f'{self.width}x{self.height}',
+            framerate=self.frame_rate,
+            **self.input_args
+        )
+
+        streams = [video_input.video]
+        if self.audio_path:
+            streams.append(ffmpeg.input(self.audio_path).audio)
+
+        output = ffmpeg.output(*streams, self.output_path, **self.output_args)
+        # Keep stderr small; it is drained continuously so ffmpeg never blocks on it
+        output = output.global_args('-nostats', '-loglevel', 'error', *self.global_args)
+
+        self.process = ffmpeg.run_async(
+            output, pipe_stdin=True, pipe_stderr=True, overwrite_output=True
+        )
+
+        self._stderr_thread = threading.Thread(target=self._drain_stderr, daemon=True)
+        self._stderr_thread.start()
+
+    def write_frame(self, frame: Union[Image.Image, np.ndarray, bytes]) -> None:
+        """
+        Write one frame to the encoder.
+
+        Args:
+            frame: PIL Image, (height, width, channels) uint8 array or raw bytes
+        """
+        if self.process is None:
+            raise RuntimeError("ffmpeg pipe has not been started")
+
+        if isinstance(frame, Image.Image):
+            if self.image_mode is None:
+                raise ValueError(f"{self.pix_fmt} frames must be written as arrays or bytes")
+            if frame.mode != self.image_mode:
+                frame = frame.convert(self.image_mode)
+            data = frame.tobytes()
+        elif isinstance(frame, np.ndarray):
+            data = memoryview(np.ascontiguousarray(frame, dtype=np.uint8)).cast('B')
+        else:
+            data = frame
+
+        if len(data) != self.frame_size:
+            raise ValueError(
+                f"Frame has {len(data)} bytes, expected {self.frame_size} "
+                f"({self.width}x{self.height} {self.pix_fmt})"
+            )
+
+        try:
+            self.process.stdin.write(data)
+        except (BrokenPipeError, OSError) as e:
+            raise IOError(f"ffmpeg pipe closed unexpectedly: {self.get_error_output()}") from e
+
+        self.frames_written += 1
+
+    def close(self) -> bool:
+        """
+        Close stdin and wait for ffmpeg to finish encoding.
+
+        Returns:
+            True if ffmpeg exited successfully, False otherwise
+        """
+        if self.process is None:
+            return False
+
+        try:
+            self.process.stdin.close()
+        except (BrokenPipeError, OSError):
+            pass
+
+        return_code = self.process.wait()
+        if self._stderr_thread:
+            self._stderr_thread.join(timeout=5)
+        self.process = None
+
+        if return_code != 0:
+            logger = get_logger()
+            logger.error(f"ffmpeg exited with code {return_code}: {self.get_error_output()}")
+            return False
+
+        return True
+
+    def abort(self) -> None:
+        """Terminate the ffmpeg process without finalizing the output."""
+        if self.process is None:
+            return
+
+        try:
+            self.process.stdin.close()
+        except (BrokenPipeError, OSError):
+            pass
+        self.process.kill()
+        self.process.wait()
+        self.process = None
+
+    def get_error_output(self) -> str:
+        """Get the last lines ffmpeg wrote to stderr."""
+        return '\n'.join(self._stderr_tail)
+
+    def _drain_stderr(self) -> None:
+        """Read ffmpeg stderr until it closes, keeping only the tail."""
+        process = self.process
+        if process is None or process.stderr is None:
+            return
+
+        for line in iter(process.stderr.readline, b''):
+            self._stderr_tail.append(line.decode('utf-8', errors='replace').rstrip())
+        process.stderr.close()
@@ -0,0 +1,93 @@
+"""
+Frequency band layout module for MP3 Spectrum Visualizer.
+Builds bin-to-band weight matrices so band magnitudes for every frame are one matmul.
+"""
+
+from functools import lru_cache
+from typing import Tuple
+
+import numpy as np
+
+
+# Supported band layouts; 'squared_log' is the original (i / num_bands) ** 2 rule
+BAND_LAYOUTS = ('squared_log', 'linear', 'log', 'mel')
+
+
+def band_bin_ranges(n_bins: int, num_bands: int, layout: str = 'squared_log',
+                    sample_rate: int = 22050, fmin: float = 20.0) -> Tuple[np.ndarray, np.ndarray]:
+    """
+    Get the [start, end) FFT bin range of each band for range-based layouts.
+
+    Args:
+        n_bins: Number of FFT bins (n_fft // 2 + 1)
+        num_bands: Number of bands
+        layout: 'squared_log', 'linear' or 'log'
+        sample_rate: Audio sample rate (used by 'log')
+        fmin: Lowest band edge in Hz (used by 'log')
+
+    Returns:
+        Tuple of (start_bins, end_bins) integer arrays
+    """
+    positions = np.arange(num_bands + 1) / num_bands
+
+    if layout == 'squared_log':
+        # Same truncation as the original per-band int() computation
+        edges = np.array([int(p ** 2 * n_bins) for p in positions])
+        starts = edges[:-1]
+        ends = np.minimum(edges[1:], n_bins)
+        return starts, ends
+
+    if layout == 'linear':
+        edges = np.floor(positions * n_bins).astype(int)
+    elif layout == 'log':
+        nyquist = sample_rate / 2.0
+        freqs = fmin * (nyquist / fmin) ** positions
+        edges = np.floor(freqs / nyquist * (n_bins - 1)).astype(int)
+        edges[0] = 0
+        # Every band gets at least one bin so low bands are never empty
+        for i in range(1, len(edges)):
+            edges[i] = max(edges[i], edges[i - 1] + 1)
+        edges = np.minimum(edges, n_bins)
+    else:
+        raise ValueError(f"Layout '{layout}' is not range-based")
+
+    return edges[:-1], np.minimum(edges[1:], n_bins)
+
+
+@lru_cache(maxsize=16)
+def build_band_matrix(n_bins: int, num_bands: int, layout: str = 'squared_log',
+                      sample_rate: int = 22050) -> np.ndarray:
+    """
+    Build the (n_bins, num_bands) weight matrix mapping FFT bins to bands.
+
+    Each column averages the bins of one band, so spectrum @ matrix gives the
+    per-band mean magnitude. Empty bands get an all-zero column.
+
+    Args:
+        n_bins: Number of FFT bins (n_fft // 2 + 1)
+        num_bands: Number of bands
+        layout: One of BAND_LAYOUTS
+        sample_rate: Audio sample rate (used by 'log' and 'mel')
+
+    Returns:
+        Read-only float32 weight matrix
+    """
+    if layout not in BAND_LAYOUTS:
+        raise ValueError(f"Unknown band layout '{layout}', expected one of {BAND_LAYOUTS}")
+
+    if layout == 'mel':
+        import librosa
+        n_fft = (n_bins - 1) * 2
+        weights = librosa.filters.mel(sr=sample_rate, n_fft=n_fft, n_mels=num_bands,
+                                      norm=None).T.astype(np.float32)
+        sums = weights.sum(axis=0)
+        weights[:, sums > 0] /= sums[sums > 0]
+    else:
+        starts, ends = band_bin_ranges(n_bins, num_bands, layout, sample_rate)
+        weights = np.zeros((n_bins, num_bands), dtype=np.float32)
+        for band, (start, end) in enumerate(zip(starts, ends)):
+            if start < end:
+                weights[start:end, band] = 1.0 / (end - start)
+
+    weights.setflags(write=False)
+    return weights
@@ -0,0 +1,466 @@
+"""
+GPU compositing backend for MP3 Spectrum Visualizer.
+Composites frames in an offscreen OpenGL framebuffer (moderngl) and draws bar
+visualizers as instanced geometry fed with the per-frame band array.
+"""
+
+from typing import Any, Dict, Optional, Tuple, Union
+
+import numpy as np
+from PIL import Image
+
+from core.compositor import YUV_FORMATS, YUVConverter, get_yuv_converter
+from core.effects import translation_matrix
+from core.layers import Layer, LayerSnapshot
+from core.sprites import Sprite
+from core.visualizers import BarsVisualizer, BaseVisualizer, DualSpectrumVisualizer
+
+try:
+    import moderngl
+except ImportError:  # Optional dependency, the CPU compositor is used without it
+    moderngl = None
+
+
+_VERTEX_SHADER = '''
+#version 330
+// Rectangle corners in pixel edge coordinates (origin top-left)
+in vec2 in_position;
+uniform vec2 frame_size;
+void main() {
+    // Row 0 is stored at the bottom of the framebuffer, so read-back rows come out top first
+    gl_Position = vec4(in_position / frame_size * 2.0 - 1.0, 0.0, 1.0);
+}
+'''
+
+_FRAGMENT_SHADER = '''
+#version 330
+uniform sampler2D image;
+uniform vec2 image_size;
+uniform mat3 inverse_transform;  // destination -> source pixel centers
+uniform vec4 source_box;         // left, top, right, bottom (pixel edges)
+uniform float opacity;
+uniform vec4 color;
+uniform int mode;                // 0 background, 1 straight-alpha layer, 2 premultiplied sprite, 3 color
+out vec4 f_color;
+void main() {
+    if (mode == 3) {
+        f_color = color;
+        return;
+    }
+    vec2 p = (inverse_transform * vec3(gl_FragCoord.xy - 0.5, 1.0)).xy;
+    if (p.x < source_box.x - 0.5 || p.y < source_box.y - 0.5 ||
+        p.x > source_box.z - 0.5 || p.y > source_box.w - 0.5) {
+        if (mode == 0) {
+            f_color = vec4(0.0, 0.0, 0.0, 1.0);  // Uncovered background is black
+            return;
+        }
+        discard;
+    }
+    vec4 c = texture(image, (p + 0.5) / image_size);
+    if (mode == 0) {
+        f_color = vec4(c.rgb * opacity, 1.0);
+    } else if (mode == 1) {
+        f_color = vec4(c.rgb, c.a * opacity);
+    } else {
+        f_color = c;
+    }
+}
+'''
+
+_BARS_VERTEX_SHADER = '''
+#version 330
+in float in_magnitude;          // normalized band magnitude, one per instance
+uniform vec2 frame_size;
+uniform mat3 transform;         // source -> destination pixel centers
+uniform float bar_width;
+uniform float bar_spacing;
+uniform float height_scale;
+uniform int mirrored;
+uniform sampler2D palette;      // (levels x bands) RGBA lookup from the visualizer
+uniform float opacity;
+out vec4 v_color;
+void main() {
+    int index = gl_InstanceID;
+    float magnitude = clamp(in_magnitude, 0.0, 1.0);
+    float bar_height = min(floor(magnitude * frame_size.y * height_scale), frame_size.y);
+    float x0 = index * bar_width + bar_spacing;
+    float x1 = x0 + bar_width - bar_spacing + 1.0;
+    float y0, y1;
+    if (mirrored == 1) {
+        float center = floor(frame_size.y / 2.0);
+        y0 = center - bar_height;
+        y1 = center + bar_height + 1.0;
+    } else {
+        y0 = frame_size.y - bar_height;
+        y1 = frame_size.y;
+    }
+    // Triangle strip corners 0..3 -> (x0,y0) (x1,y0) (x0,y1) (x1,y1)
+    vec2 corner = vec2((gl_VertexID & 1) == 1 ? x1 : x0, (gl_VertexID & 2) == 2 ? y1 : y0);
+    vec2 position = (transform * vec3(corner - 0.5, 1.0)).xy + 0.5;
+    gl_Position = vec4(position / frame_size * 2.0 - 1.0, 0.0, 1.0);
+    
+    int level = int(magnitude * 255.0 + 0.5);
+    v_color = texelFetch(palette, ivec2(level, index), 0);
+    v_color.a *= opacity;
+}
+'''
+
+_BARS_FRAGMENT_SHADER = '''
+#version 330
+in vec4 v_color;
+out vec4 f_color;
+void main() {
+    f_color = v_color;
+}
+'''
+
+_IDENTITY = np.eye(3)
+
+
+def gpu_available() -> bool:
+    """Check whether the moderngl package is installed."""
+    return moderngl is not None
+
+
+def _create_context():
+    """Create a headless OpenGL context, trying EGL when no display is available."""
+    try:
+        return moderngl.create_context(standalone=True)
+    except Exception:
+        return moderngl.create_context(standalone=True, backend='egl')
+
+
+class GPUFrameCompositor:
+    """
+    Drop-in replacement for FrameCompositor that composites on the GPU.
+    
+    Backgrounds, CPU-rendered layers and sprites are uploaded as textures and
+    blended in an offscreen framebuffer; affine beat transforms are applied in
+    the shaders. Bar visualizers are drawn natively as instanced quads. Frames
+    are read back through a reusable pixel buffer into one RGB24 array.
+    """
+    
+    # Visualizers drawn as instanced bars: (bar height scale, mirrored)
+    NATIVE_VISUALIZERS = {
+        BarsVisualizer: (0.8, False),
+        DualSpectrumVisualizer: (0.45, True),
+    }
+    
+    def __init__(self, width: int, height: int):
+        """
+        Initialize the OpenGL context and frame-size resources.
+        
+        Args:
+            width: Frame width
+            height: Frame height
+        
+        Raises:
+            RuntimeError: If moderngl is not installed
+        """
+        if moderngl is None:
+            raise RuntimeError("moderngl is not installed")
+        
+        self.width = width
+        self.height = height
+        self.ctx = _create_context()
+        
+        self._target = self.ctx.texture((width, height), 4)
+        self.fbo = self.ctx.framebuffer(color_attachments=[self._target])
+        self._background = self.ctx.texture((width, height), 3, alignment=1)
+        self._layer = self.ctx.texture((width, height), 4)
+        self._pbo = self.ctx.buffer(reserve=width * height * 3)
+        self._rgb_out = np.empty((height, width, 3), dtype=np.uint8)
+        self._yuv_converters: Dict[Tuple[str, bool], YUVConverter] = {}
+        
+        self._program = self.ctx.program(vertex_shader=_VERTEX_SHADER,
+                                          fragment_shader=_FRAGMENT_SHADER)
+        self._program['frame_size'].value = (float(width), float(height))
+        self._quad = self.ctx.buffer(reserve=4 * 2 * 4)
+        self._quad_vao = self.ctx.vertex_array(self._program, [(self._quad, '2f', 'in_position')])
+        
+        self._bars_program = self.ctx.program(vertex_shader=_BARS_VERTEX_SHADER,
+                                               fragment_shader=_BARS_FRAGMENT_SHADER)
+        self._bars_program['frame_size'].value = (float(width), float(height))
+        self._magnitudes = None
+        self._bars_vao = None
+        
+        # Uploaded textures that stay valid across frames
+        self._background_source: Optional[Image.Image] = None
+        self._palettes: Dict[int, Tuple[np.ndarray, Any]] = {}
+        self._sprites: Dict[int, Tuple[Sprite, Any]] = {}
+    
+    def _draw_quad(self, box: Tuple[float, float, float, float]) -> None:
+        """Draw the rectangle (left, top, right, bottom) with the image program."""
+        left, top, right, bottom = box
+        self._quad.write(np.array([left, top, right, top, left, bottom, right, bottom],
+                                  dtype=np.float32).tobytes())
+        self._quad_vao.render(moderngl.TRIANGLE_STRIP)
+    
+    def _set_source(self, transform: Optional[np.ndarray], source_box, image_size=None) -> None:
+        """
+        Set the sampling uniforms of the image program.
+        
+        Args:
+            transform: 3x3 matrix from texture pixels to frame pixels (None is identity)
+            source_box: Valid (left, top, right, bottom) texture area
+            image_size: Texture size (defaults to the frame size)
+        """
+        matrix = _IDENTITY if transform is None else np.linalg.inv(transform)
+        self._program['inverse_transform'].write(matrix.T.astype(np.float32).tobytes())
+        self._program['source_box'].value = tuple(float(v) for v in source_box)
+        self._program['image_size'].value = tuple(float(v) for v in (image_size or (self.width, self.height)))
+    
+    def _destination_box(self, box, transform: Optional[np.ndarray]):
+        """Bounds of a box after a transform, clipped to the frame (None when outside)."""
+        left, top, right, bottom = box
+        if transform is not None:
+            corners = np.array([[left, top, 1], [right, top, 1], [left, bottom, 1], [right, bottom, 1]],
+                               dtype=np.float64) @ transform[:2].T
+            left, top = np.floor(corners.min(axis=0)) - 1
+            right, bottom = np.ceil(corners.max(axis=0)) + 1
+        left, top = max(left, 0), max(top, 0)
+        right, bottom = min(right, self.width), min(bottom, self.height)
+        if left >= right or top >= bottom:
+            return None
+        return (left, top, right, bottom)
+    
+    def make_current(self) -> None:
+        """Make the OpenGL context current on the calling thread (e.g. a pipeline stage)."""
+        self.ctx.__enter__()
+    
+    def supports_visualizer(self, visualizer: Optional[BaseVisualizer]) -> bool:
+        """Check whether a visualizer is drawn natively on the GPU."""
+        return type(visualizer) in self.NATIVE_VISUALIZERS
+    
+    def begin(self, background: Image.Image, opacity: int = 100,
+              transform: Optional[np.ndarray] = None) -> None:
+        """
+        Start a frame from a background image.
+        
+        Args:
+            background: Background image (frame size)
+            opacity: Background opacity (0-100), composited over black
+            transform: Optional 3x3 affine matrix (beat pulse/zoom/shake)
+        """
+        if background is not self._background_source:
+            # Static backgrounds are the same cached image every frame: upload once
+            rgb = background if background.mode == 'RGB' else background.convert('RGB')
+            self._background.write(np.ascontiguousarray(np.asarray(rgb)))
+            self._background_source = background
+        
+        self.fbo.use()
+        self.ctx.disable(moderngl.BLEND)
+        self._background.use(0)
+        self._program['image'].value = 0
+        self._program['mode'].value = 0
+        self._program['opacity'].value = max(min(opacity, 100), 0) / 100.0
+        self._set_source(transform, (0, 0, self.width, self.height))
+        self._draw_quad((0, 0, self.width, self.height))
+    
+    def add_layer(self, layer: Union[Layer, LayerSnapshot, Image.Image], opacity: int = 100,
+                  transform: Optional[np.ndarray] = None) -> None:
+        """
+        Blend a straight-alpha RGBA layer over the frame.
+        
+        Only the layer's dirty box (plus a transparent one-pixel border for
+        bilinear sampling) is uploaded.
+        
+        Args:
+            layer: Layer or RGBA image (frame size)
+            opacity: Layer opacity (0-100)
+            transform: Optional 3x3 affine matrix applied to the layer
+        """
+        if opacity <= 0:
+            return
+        if isinstance(layer, (Layer, LayerSnapshot)):
+            box = layer.finish()
+            if box is None:
+                return
+            box = layer.clip((box[0] - 1, box[1] - 1, box[2] + 1, box[3] + 1))
+        else:
+            layer = layer if layer.mode == 'RGBA' else layer.convert('RGBA')
+            box = (0, 0, self.width, self.height)
+        
+        destination = self._destination_box(box, transform)
+        if destination is None:
+            return
+        
+        left, top, right, bottom = box
+        if isinstance(layer, Image.Image):
+            pixels = np.asarray(layer)
+        else:
+            pixels = np.ascontiguousarray(layer.pixels(box))
+        self._layer.write(pixels, viewport=(left, top, right - left, bottom - top))
+        
+        self.fbo.use()
+        self.ctx.enable(moderngl.BLEND)
+        self.ctx.blend_func = moderngl.SRC_ALPHA, moderngl.ONE_MINUS_SRC_ALPHA
+        self._layer.use(0)
+        self._program['image'].value = 0
+        self._program['mode'].value = 1
+        self._program['opacity'].value = min(opacity, 100) / 100.0
+        self._set_source(transform, box)
+        self._draw_quad(destination)
+    
+    def add_visualizer(self, visualizer: BaseVisualizer, bands: np.ndarray, opacity: int = 100,
+                       transform: Optional[np.ndarray] = None) -> None:
+        """
+        Draw a bar visualizer as instanced quads with its color palette.
+        
+        Args:
+            visualizer: Visualizer accepted by supports_visualizer()
+            bands: Frequency band magnitudes for the frame
+            opacity: Visualizer opacity (0-100)
+            transform: Optional 3x3 affine matrix applied to the geometry
+        """
+        num_bands = len(bands)
+        if opacity <= 0 or num_bands == 0:
+            return
+        height_scale, mirrored = self.NATIVE_VISUALIZERS[type(visualizer)]
+        
+        peak = np.max(bands)
+        magnitudes = (bands / peak if peak > 0 else bands).astype(np.float32)
+        if self._magnitudes is None or self._magnitudes.size != magnitudes.nbytes:
+            self._magnitudes = self.ctx.buffer(reserve=magnitudes.nbytes)
+            self._bars_vao = self.ctx.vertex_array(self._bars_program,
+                                                   [(self._magnitudes, '1f/i', 'in_magnitude')])
+        self._magnitudes.write(magnitudes.tobytes())
+        
+        program = self._bars_program
+        self._palette_texture(visualizer.get_palette(num_bands)).use(1)
+        program['palette'].value = 1
+        program['bar_width'].value = float(self.width // num_bands)
+        program['bar_spacing'].value = 2.0
+        program['height_scale'].value = height_scale
+        program['mirrored'].value = int(mirrored)
+        program['opacity'].value = min(opacity, 100) / 100.0
+        matrix = _IDENTITY if transform is None else transform
+        program['transform'].write(matrix.T.astype(np.float32).tobytes())
+        
+        self.fbo.use()
+        self.ctx.enable(moderngl.BLEND)
+        self.ctx.blend_func = moderngl.SRC_ALPHA, moderngl.ONE_MINUS_SRC_ALPHA
+        self._bars_vao.render(moderngl.TRIANGLE_STRIP, vertices=4, instances=num_bands)
+    
+    def _palette_texture(self, palette: np.ndarray):
+        """Get the texture of a visualizer palette, uploading it on first use."""
+        entry = self._palettes.get(id(palette))
+        if entry is None or entry[0] is not palette:
+            texture = self.ctx.texture((palette.shape[1], palette.shape[0]), 4,
+                                       np.ascontiguousarray(palette).tobytes())
+            texture.filter = (moderngl.NEAREST, moderngl.NEAREST)
+            entry = (palette, texture)
+            self._palettes[id(palette)] = entry
+        return entry[1]
+    
+    def add_sprite(self, sprite: Optional[Sprite]) -> None:
+        """
+        Blend a premultiplied sprite over its bounding box.
+        
+        Args:
+            sprite: Sprite to blend (None is ignored)
+        """
+        if sprite is None or sprite.empty:
+            return
+        
+        entry = self._sprites.get(id(sprite))
+        if entry is None or entry[0] is not sprite:
+            if len(self._sprites) >= 32:
+                for _, texture in self._sprites.values():
+                    texture.release()
+                self._sprites.clear()
+            rgba = np.concatenate([sprite.premultiplied / 255.0, sprite.alpha], axis=2)
+            texture = self.ctx.texture((rgba.shape[1], rgba.shape[0]), 4,
+                                       np.ascontiguousarray(rgba, dtype=np.float32).tobytes(),
+                                       dtype='f4')
+            entry = (sprite, texture)
+            self._sprites[id(sprite)] = entry
+        
+        left, top, right, bottom = sprite.box
+        destination = self._destination_box(sprite.box, None)
+        if destination is None:
+            return
+        
+        self.fbo.use()
+        self.ctx.enable(moderngl.BLEND)
+        self.ctx.blend_func = moderngl.ONE, moderngl.ONE_MINUS_SRC_ALPHA
+        entry[1].use(0)
+        self._program['image'].value = 0
+        self._program['mode'].value = 2
+        self._set_source(translation_matrix(left, top), (0, 0, right - left, bottom - top),
+                         (right - left, bottom - top))
+        self._draw_quad(destination)
+    
+    def blend_color(self, color, amount: float) -> None:
+        """
+        Blend a solid color over the whole frame (flash and strobe effects).
+        
+        Args:
+            color: RGB color
+            amount: Blend amount (0.0 to 1.0)
+        """
+        if amount <= 0:
+            return
+        self.fbo.use()
+        self.ctx.enable(moderngl.BLEND)
+        self.ctx.blend_func = moderngl.SRC_ALPHA, moderngl.ONE_MINUS_SRC_ALPHA
+        self._program['mode'].value = 3
+        self._program['color'].value = tuple(c / 255.0 for c in color[:3]) + (min(amount, 1.0),)
+        self._draw_quad((0, 0, self.width, self.height))
+    
+    def to_rgb(self) -> np.ndarray:
+        """
+        Read the frame back to RGB24.
+        
+        Returns:
+            (height, width, 3) uint8 array, reused by the next call
+        """
+        self.fbo.read_into(self._pbo, components=3, alignment=1)
+        self._pbo.read_into(self._rgb_out)
+        return self._rgb_out
+    
+    def to_yuv(self, pix_fmt: str = 'yuv420p', full_range: bool = False) -> np.ndarray:
+        """
+        Read the frame back and convert it to BT.709 YUV 4:2:0.
+        
+        Args:
+            pix_fmt: 'yuv420p' or 'nv12'
+            full_range: Full (0-255) instead of limited (16-235) range
+        
+        Returns:
+            Flat uint8 frame, reused by the next call
+        """
+        return get_yuv_converter(self._yuv_converters, self.width, self.height,
+                                 pix_fmt, full_range).convert(self.to_rgb())
+    
+    def to_output(self, pix_fmt: str = 'rgb24', full_range: bool = False) -> np.ndarray:
+        """
+        Emit the frame in a raw pipe format.
+        
+        Args:
+            pix_fmt: 'rgb24', 'yuv420p' or 'nv12'
+            full_range: Full range YUV (ignored for RGB)
+        
+        Returns:
+            uint8 array, reused by the next call
+        """
+        if pix_fmt in YUV_FORMATS:
+            return self.to_yuv(pix_fmt, full_range)
+        return self.to_rgb()
+    
+    def to_image(self) -> Image.Image:
+        """
+        Get the frame as an RGB PIL Image (a copy, safe to keep).
+        
+        Returns:
+            RGB PIL Image
+        """
+        return Image.fromarray(self.to_rgb())
+    
+    def release(self) -> None:
+        """Release GPU resources."""
+        for _, texture in list(self._palettes.values()) + list(self._sprites.values()):
+            texture.release()
+        self._palettes.clear()
+        self._sprites.clear()
+        self.ctx.release()
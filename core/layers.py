@@ -0,0 +1,233 @@
+"""
+Layer module for MP3 Spectrum Visualizer.
+Provides reusable RGBA layer buffers that track the region drawn each frame,
+so layers are cleared and composited over that region only.
+"""
+
+from typing import Optional, Tuple
+
+import numpy as np
+from PIL import Image, ImageDraw
+
+Box = Tuple[int, int, int, int]
+
+
+def union_box(a: Optional[Box], b: Optional[Box]) -> Optional[Box]:
+    """
+    Get the smallest box containing two boxes.
+    
+    Args:
+        a: (left, top, right, bottom) box or None
+        b: (left, top, right, bottom) box or None
+    
+    Returns:
+        Union box, or None when both are None
+    """
+    if a is None:
+        return b
+    if b is None:
+        return a
+    return (min(a[0], b[0]), min(a[1], b[1]), max(a[2], b[2]), max(a[3], b[3]))
+
+
+def clip_box(box: Box, width: int, height: int) -> Optional[Box]:
+    """
+    Clip a box to a width x height frame.
+    
+    Args:
+        box: (left, top, right, bottom) box, may extend past the frame
+        width: Frame width
+        height: Frame height
+    
+    Returns:
+        Clipped box, or None when nothing of it is inside the frame
+    """
+    left, top = max(int(box[0]), 0), max(int(box[1]), 0)
+    right, bottom = min(int(box[2]), width), min(int(box[3]), height)
+    if left >= right or top >= bottom:
+        return None
+    return (left, top, right, bottom)
+
+
+class Layer:
+    """
+    Frame-sized RGBA image allocated once and reused for every frame.
+    
+    A frame starts with begin(), which clears only what the previous frame drew.
+    Content is drawn with ImageDraw through canvas() or written as NumPy regions
+    through region()/put_region(). finish() reports the dirty box the
+    compositor has to blend.
+    """
+    
+    def __init__(self, width: int, height: int):
+        """
+        Initialize layer.
+        
+        Args:
+            width: Layer width
+            height: Layer height
+        """
+        self.width = width
+        self.height = height
+        self.image = Image.new('RGBA', (width, height), (0, 0, 0, 0))
+        self.draw = ImageDraw.Draw(self.image)
+        self.bbox: Optional[Box] = None
+        self._written: Optional[Box] = None  # Union of boxes replaced through paste()
+        self._drawn = False  # ImageDraw was used, the dirty box must be scanned
+    
+    def begin(self) -> None:
+        """Start a frame: clear what the previous frame drew."""
+        box = self.finish()
+        if box is not None:
+            self.image.paste((0, 0, 0, 0), box)
+        self.bbox = None
+        self._written = None
+        self._drawn = False
+    
+    def canvas(self) -> Tuple[Image.Image, ImageDraw.ImageDraw]:
+        """
+        Get the layer image and a drawer for it.
+        
+        Returns:
+            (image, draw) tuple
+        """
+        self._drawn = True
+        return self.image, self.draw
+    
+    def clip(self, box: Box) -> Optional[Box]:
+        """
+        Clip a box to the layer.
+        
+        Args:
+            box: (left, top, right, bottom) box, may extend past the layer
+        
+        Returns:
+            Clipped box, or None when nothing of it is inside the layer
+        """
+        return clip_box(box, self.width, self.height)
+    
+    def region(self, box: Box) -> np.ndarray:
+        """
+        Get a writable copy of the layer pixels in a box.
+        
+        Args:
+            box: Clipped (left, top, right, bottom) box
+        
+        Returns:
+            (height, width, 4) uint8 array
+        """
+        if self.bbox is None and self._written is None and not self._drawn:
+            # Nothing drawn yet this frame, the layer is transparent
+            return np.zeros((box[3] - box[1], box[2] - box[0], 4), dtype=np.uint8)
+        return np.array(self.image.crop(box))
+    
+    def put_region(self, pixels: np.ndarray, box: Box) -> None:
+        """
+        Write pixels into a box of the layer and mark it dirty.
+        
+        Args:
+            pixels: (height, width, 4) uint8 array
+            box: Clipped (left, top, right, bottom) box the pixels cover
+        """
+        self.paste(Image.fromarray(pixels), box)
+    
+    def paste(self, image: Image.Image, box: Box) -> None:
+        """
+        Replace a box of the layer with an image and mark it dirty.
+        
+        Args:
+            image: RGBA image the size of the box
+            box: Clipped (left, top, right, bottom) box
+        """
+        self.image.paste(image, box[:2])
+        self._written = union_box(self._written, box)
+    
+    def pixels(self, box: Box) -> np.ndarray:
+        """
+        Get the layer pixels in a box for compositing.
+        
+        Args:
+            box: Clipped (left, top, right, bottom) box
+        
+        Returns:
+            (height, width, 4) uint8 array
+        """
+        return np.asarray(self.image.crop(box))
+    
+    def snapshot(self) -> 'LayerSnapshot':
+        """Copy the current frame's content so it outlives the next begin()."""
+        return LayerSnapshot(self)
+    
+    def finish(self) -> Optional[Box]:
+        """
+        Get the dirty box of the current frame.
+        
+        Returns:
+            (left, top, right, bottom) box, or None when nothing was drawn
+        """
+        if self._drawn:
+            self.bbox = union_box(self.bbox, self.image.getbbox())
+            self._drawn = False
+        self.bbox = union_box(self.bbox, self._written)
+        self._written = None
+        return self.bbox
+
+
+class LayerSnapshot:
+    """
+    Frozen copy of a layer's dirty region, for caches that keep rendered layers
+    across frames (e.g. the preview engine). Composites like a Layer.
+    """
+    
+    def __init__(self, layer: Layer):
+        """
+        Copy a layer's current content.
+        
+        Args:
+            layer: Layer after drawing the frame
+        """
+        self.width = layer.width
+        self.height = layer.height
+        self.bbox = layer.finish()
+        # Only the dirty box is stored; everything outside it is transparent
+        self.image = layer.image.crop(self.bbox) if self.bbox is not None else None
+    
+    @property
+    def nbytes(self) -> int:
+        """Memory held by the copied pixels."""
+        if self.image is None:
+            return 0
+        return self.image.width * self.image.height * 4
+    
+    def finish(self) -> Optional[Box]:
+        """Get the dirty box of the copied frame."""
+        return self.bbox
+    
+    def clip(self, box: Box) -> Optional[Box]:
+        """Clip a box to the layer."""
+        return clip_box(box, self.width, self.height)
+    
+    def pixels(self, box: Box) -> np.ndarray:
+        """
+        Get the copied pixels in a box (transparent outside the dirty box).
+        
+        Args:
+            box: Clipped (left, top, right, bottom) box
+        
+        Returns:
+            (height, width, 4) uint8 array
+        """
+        if self.bbox is not None and box == self.bbox:
+            return np.asarray(self.image)
+        pixels = np.zeros((box[3] - box[1], box[2] - box[0], 4), dtype=np.uint8)
+        if self.bbox is None:
+            return pixels
+        overlap = clip_box((max(box[0], self.bbox[0]), max(box[1], self.bbox[1]),
+                            min(box[2], self.bbox[2]), min(box[3], self.bbox[3])),
+                           self.width, self.height)
+        if overlap is not None:
+            left, top, right, bottom = overlap
+            pixels[top - box[1]:bottom - box[1], left - box[0]:right - box[0]] = np.asarray(
+                self.image.crop((left - self.bbox[0], top - self.bbox[1],
+                                 right - self.bbox[0], bottom - self.bbox[1])))
+        return pixels
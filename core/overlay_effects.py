@@ -4,14 +4,23 @@ Implements particle systems and video overlays (rain, snow, sparkles, bubbles).
 """
 
 import numpy as np
-from PIL import Image, ImageDraw
+from PIL import Image
 from typing import List, Dict, Any, Optional, Tuple
-import random
+
+from core.layers import Layer
+from core.particles import (
+    ParticleSystem, particle_box, splat, disc_stamp, ring_stamp, vline_stamp, cross_stamp
+)
+from core.random_state import frame_rng
 
 
 class BaseOverlay:
     """Base class for overlay effects."""
     
+    # Particle pool size and fields (name -> dtype, or (dtype, width)) of subclasses
+    max_particles = 0
+    particle_fields: Dict[str, Any] = {}
+    
     def __init__(self, width: int, height: int, settings: Dict[str, Any]):
         """
         Initialize overlay effect.
@@ -24,7 +33,10 @@ class BaseOverlay:
         self.width = width
         self.height = height
         self.settings = settings
-        self.particles: List[Dict[str, Any]] = []
+        self.seed = settings.get('random_seed', 0)
+        self.particles = ParticleSystem(self.max_particles, self.particle_fields)
+        self.layer = Layer(width, height)
+        self._next_frame = 0
     
     def update(self, frame_number: int) -> None:
         """
@@ -33,265 +45,337 @@ class BaseOverlay:
         Args:
             frame_number: Current frame number
         """
-        raise NotImplementedError("Subclasses must implement update()")
+        rng = frame_rng(self.seed, frame_number, type(self).__name__)
+        self._update(frame_number, rng)
+        self._next_frame = frame_number + 1
+    
+    def _update(self, frame_number: int, rng: np.random.Generator) -> None:
+        """
+        Spawn and move particles for one frame.
+        
+        Args:
+            frame_number: Current frame number
+            rng: Random generator seeded for this frame
+        """
+        raise NotImplementedError("Subclasses must implement _update()")
+    
+    def _spawn_count(self) -> int:
+        """Number of particles to spawn this frame (spawn rate limited by free slots)."""
+        return min(self.spawn_rate, self.particles.free)
+    
+    def reset(self) -> None:
+        """Reset overlay state to before frame 0."""
+        self.particles.reset()
+        self._next_frame = 0
+    
+    def seek(self, frame_number: int) -> None:
+        """
+        Bring state to exactly where it is just before updating frame_number.
+        
+        Args:
+            frame_number: Frame that will be updated next
+        """
+        if self._next_frame > frame_number:
+            self.reset()
+        
+        for f in range(self._next_frame, frame_number):
+            self.update(f)
+    
+    def render_layer(self) -> Layer:
+        """
+        Render overlay effect into the reusable layer.
+        
+        Only the box the particles can reach is cleared, drawn and reported dirty.
+        
+        Returns:
+            Layer with the overlay effect (reused by the next call)
+        """
+        self.layer.begin()
+        p = self.particles
+        box = particle_box(p['x'], p['y'], self._reach())
+        box = self.layer.clip(box) if box is not None else None
+        if box is not None:
+            pixels = self.layer.region(box)
+            self._draw(pixels, box[:2])
+            self.layer.put_region(pixels, box)
+        self.layer.finish()
+        return self.layer
     
     def render(self) -> Image.Image:
         """
         Render overlay effect.
         
         Returns:
-            PIL Image with overlay effect
+            PIL Image with overlay effect (the layer image, reused by the next call)
         """
-        raise NotImplementedError("Subclasses must implement render()")
+        return self.render_layer().image
+    
+    def _reach(self) -> np.ndarray:
+        """
+        Get how far each particle draws from its position.
+        
+        Returns:
+            Scalar or per-particle reach in pixels
+        """
+        raise NotImplementedError("Subclasses must implement _reach()")
+    
+    def _draw(self, pixels: np.ndarray, origin: Tuple[int, int]) -> None:
+        """
+        Draw the live particles into a layer region.
+        
+        Args:
+            pixels: (height, width, 4) uint8 region, modified in place
+            origin: Frame position of pixels[0, 0]
+        """
+        raise NotImplementedError("Subclasses must implement _draw()")
+
+
+def _rgba(rgb: Tuple[int, int, int], alpha: np.ndarray) -> np.ndarray:
+    """
+    Build per-particle RGBA colors from a shared RGB color and per-particle alpha.
+    
+    Args:
+        rgb: RGB color
+        alpha: Alpha values (0-255)
+    
+    Returns:
+        (N, 4) uint8 array
+    """
+    colors = np.empty((len(alpha), 4), dtype=np.uint8)
+    colors[:, :3] = rgb
+    colors[:, 3] = alpha
+    return colors
 
 
 class RainOverlay(BaseOverlay):
     """Animated rain particles overlay."""
     
+    max_particles = 200
+    particle_fields = {
+        'x': np.float32, 'y': np.float32, 'speed': np.float32,
+        'length': np.float32, 'thickness': np.int32, 'opacity': np.float32,
+    }
+    
     def __init__(self, width: int, height: int, settings: Dict[str, Any]):
         """Initialize rain overlay."""
         super().__init__(width, height, settings)
-        self.max_particles = 200
         self.spawn_rate = 5  # particles per frame
     
-    def update(self, frame_number: int) -> None:
+    def _update(self, frame_number: int, rng: np.random.Generator) -> None:
         """Update rain particles."""
         # Spawn new raindrops
-        for _ in range(self.spawn_rate):
-            if len(self.particles) < self.max_particles:
-                self.particles.append({
-                    'x': random.uniform(0, self.width),
-                    'y': -10,
-                    'speed': random.uniform(15, 25),
-                    'length': random.uniform(10, 20),
-                    'thickness': random.randint(1, 2),
-                    'opacity': random.uniform(0.3, 0.8)
-                })
+        n = self._spawn_count()
+        self.particles.spawn(
+            x=rng.uniform(0, self.width, n),
+            y=np.full(n, -10.0),
+            speed=rng.uniform(15, 25, n),
+            length=rng.uniform(10, 20, n),
+            thickness=rng.integers(1, 3, n),
+            opacity=rng.uniform(0.3, 0.8, n)
+        )
         
         # Update existing particles
-        new_particles = []
-        for particle in self.particles:
-            particle['y'] += particle['speed']
-            
-            # Keep particle if still in view
-            if particle['y'] < self.height + 10:
-                new_particles.append(particle)
+        p = self.particles
+        p['y'] += p['speed']
         
-        self.particles = new_particles
+        # Keep particles still in view
+        p.cull(p['y'] < self.height + 10)
     
-    def render(self) -> Image.Image:
-        """Render rain effect."""
-        img = Image.new('RGBA', (self.width, self.height), (0, 0, 0, 0))
-        draw = ImageDraw.Draw(img)
-        
-        for particle in self.particles:
-            x = particle['x']
-            y = particle['y']
-            length = particle['length']
-            
-            # Draw raindrop as a line
-            alpha = int(255 * particle['opacity'])
-            color = (200, 200, 255, alpha)
-            
-            draw.line([(x, y), (x, y + length)], fill=color, width=particle['thickness'])
-        
-        return img
+    def _reach(self) -> np.ndarray:
+        """Raindrops extend down by their length."""
+        return self.particles['length'].astype(np.intp) + self.particles['thickness']
+    
+    def _draw(self, pixels: np.ndarray, origin: Tuple[int, int]) -> None:
+        """Draw raindrops as lines."""
+        p = self.particles
+        alpha = (255 * p['opacity']).astype(np.uint8)
+        shapes = np.stack([p['length'].astype(np.intp), p['thickness']], axis=1)
+        splat(pixels, p['x'], p['y'], _rgba((200, 200, 255), alpha), shapes, vline_stamp, origin)
 
 
 class SnowOverlay(BaseOverlay):
     """Animated snowflakes overlay."""
     
+    max_particles = 150
+    particle_fields = {
+        'x': np.float32, 'y': np.float32, 'speed': np.float32, 'drift': np.float32,
+        'size': np.float32, 'opacity': np.float32,
+        'swing': np.float32,  # Phase for swing
+        'swing_speed': np.float32,
+    }
+    
     def __init__(self, width: int, height: int, settings: Dict[str, Any]):
         """Initialize snow overlay."""
         super().__init__(width, height, settings)
-        self.max_particles = 150
         self.spawn_rate = 3
     
-    def update(self, frame_number: int) -> None:
+    def _update(self, frame_number: int, rng: np.random.Generator) -> None:
         """Update snowflakes."""
         # Spawn new snowflakes
-        for _ in range(self.spawn_rate):
-            if len(self.particles) < self.max_particles:
-                self.particles.append({
-                    'x': random.uniform(0, self.width),
-                    'y': -10,
-                    'speed': random.uniform(2, 5),
-                    'drift': random.uniform(-1, 1),
-                    'size': random.uniform(2, 6),
-                    'opacity': random.uniform(0.4, 0.9),
-                    'swing': random.uniform(0, 6.28),  # Random phase for swing
-                    'swing_speed': random.uniform(0.05, 0.15)
-                })
+        n = self._spawn_count()
+        self.particles.spawn(
+            x=rng.uniform(0, self.width, n),
+            y=np.full(n, -10.0),
+            speed=rng.uniform(2, 5, n),
+            drift=rng.uniform(-1, 1, n),
+            size=rng.uniform(2, 6, n),
+            opacity=rng.uniform(0.4, 0.9, n),
+            swing=rng.uniform(0, 6.28, n),
+            swing_speed=rng.uniform(0.05, 0.15, n)
+        )
         
         # Update existing particles
-        new_particles = []
-        for particle in self.particles:
-            particle['y'] += particle['speed']
-            particle['swing'] += particle['swing_speed']
-            particle['x'] += np.sin(particle['swing']) * 2 + particle['drift']
-            
-            # Keep particle if still in view
-            if particle['y'] < self.height + 10 and 0 <= particle['x'] <= self.width:
-                new_particles.append(particle)
+        p = self.particles
+        p['y'] += p['speed']
+        p['swing'] += p['swing_speed']
+        p['x'] += np.sin(p['swing']) * 2 + p['drift']
         
-        self.particles = new_particles
+        # Keep particles still in view
+        x = p['x']
+        p.cull((p['y'] < self.height + 10) & (x >= 0) & (x <= self.width))
     
-    def render(self) -> Image.Image:
-        """Render snow effect."""
-        img = Image.new('RGBA', (self.width, self.height), (0, 0, 0, 0))
-        draw = ImageDraw.Draw(img)
-        
-        for particle in self.particles:
-            x = int(particle['x'])
-            y = int(particle['y'])
-            size = int(particle['size'])
-            
-            alpha = int(255 * particle['opacity'])
-            color = (255, 255, 255, alpha)
-            
-            # Draw snowflake as a circle
-            draw.ellipse([x - size, y - size, x + size, y + size], fill=color)
-        
-        return img
+    def _reach(self) -> np.ndarray:
+        """Snowflakes extend by their radius."""
+        return self.particles['size'].astype(np.intp)
+    
+    def _draw(self, pixels: np.ndarray, origin: Tuple[int, int]) -> None:
+        """Draw snowflakes as circles."""
+        p = self.particles
+        alpha = (255 * p['opacity']).astype(np.uint8)
+        splat(pixels, p['x'], p['y'], _rgba((255, 255, 255), alpha),
+              p['size'].astype(np.intp), disc_stamp, origin)
 
 
 class SparklesOverlay(BaseOverlay):
     """Twinkling sparkle particles overlay."""
     
+    max_particles = 100
+    particle_fields = {
+        'x': np.float32, 'y': np.float32, 'life': np.float32, 'decay': np.float32,
+        'size': np.float32, 'color': (np.uint8, 3),
+        'twinkle_phase': np.float32, 'twinkle_speed': np.float32,
+    }
+    
     def __init__(self, width: int, height: int, settings: Dict[str, Any]):
         """Initialize sparkles overlay."""
         super().__init__(width, height, settings)
-        self.max_particles = 100
         self.spawn_rate = 2
     
-    def update(self, frame_number: int) -> None:
+    def _update(self, frame_number: int, rng: np.random.Generator) -> None:
         """Update sparkles."""
         # Spawn new sparkles
-        for _ in range(self.spawn_rate):
-            if len(self.particles) < self.max_particles:
-                self.particles.append({
-                    'x': random.uniform(0, self.width),
-                    'y': random.uniform(0, self.height),
-                    'life': 1.0,
-                    'decay': random.uniform(0.02, 0.05),
-                    'size': random.uniform(2, 5),
-                    'color': (
-                        random.randint(200, 255),
-                        random.randint(200, 255),
-                        random.randint(150, 255)
-                    ),
-                    'twinkle_phase': random.uniform(0, 6.28),
-                    'twinkle_speed': random.uniform(0.1, 0.3)
-                })
+        n = self._spawn_count()
+        self.particles.spawn(
+            x=rng.uniform(0, self.width, n),
+            y=rng.uniform(0, self.height, n),
+            life=np.ones(n),
+            decay=rng.uniform(0.02, 0.05, n),
+            size=rng.uniform(2, 5, n),
+            color=rng.integers([200, 200, 150], 256, (n, 3)),
+            twinkle_phase=rng.uniform(0, 6.28, n),
+            twinkle_speed=rng.uniform(0.1, 0.3, n)
+        )
         
         # Update existing particles
-        new_particles = []
-        for particle in self.particles:
-            particle['life'] -= particle['decay']
-            particle['twinkle_phase'] += particle['twinkle_speed']
-            
-            if particle['life'] > 0:
-                new_particles.append(particle)
+        p = self.particles
+        p['life'] -= p['decay']
+        p['twinkle_phase'] += p['twinkle_speed']
         
-        self.particles = new_particles
+        p.cull(p['life'] > 0)
     
-    def render(self) -> Image.Image:
-        """Render sparkles effect."""
-        img = Image.new('RGBA', (self.width, self.height), (0, 0, 0, 0))
-        draw = ImageDraw.Draw(img)
+    def _reach(self) -> np.ndarray:
+        """Sparkle cross arms extend by twice the full size."""
+        return self.particles['size'].astype(np.intp) * 2
+    
+    def _draw(self, pixels: np.ndarray, origin: Tuple[int, int]) -> None:
+        """Draw sparkles with a cross pattern."""
+        p = self.particles
         
-        for particle in self.particles:
-            x = int(particle['x'])
-            y = int(particle['y'])
-            
-            # Twinkling effect
-            twinkle = (np.sin(particle['twinkle_phase']) + 1) / 2
-            size = int(particle['size'] * twinkle)
-            
-            alpha = int(255 * particle['life'] * twinkle)
-            color = (*particle['color'], alpha)
-            
-            # Draw sparkle with a cross pattern
-            draw.ellipse([x - size, y - size, x + size, y + size], fill=color)
-            
-            # Add cross lines for sparkle effect
-            if size > 2:
-                line_color = (*particle['color'], alpha // 2)
-                draw.line([(x - size * 2, y), (x + size * 2, y)], fill=line_color, width=1)
-                draw.line([(x, y - size * 2), (x, y + size * 2)], fill=line_color, width=1)
+        # Twinkling effect
+        twinkle = (np.sin(p['twinkle_phase']) + 1) / 2
+        size = (p['size'] * twinkle).astype(np.intp)
         
-        return img
+        colors = np.empty((len(p), 4), dtype=np.uint8)
+        colors[:, :3] = p['color']
+        colors[:, 3] = (255 * p['life'] * twinkle).astype(np.uint8)
+        splat(pixels, p['x'], p['y'], colors, size, disc_stamp, origin)
+        
+        # Add cross lines for sparkle effect
+        crossed = size > 2
+        colors[:, 3] //= 2
+        splat(pixels, p['x'][crossed], p['y'][crossed], colors[crossed], size[crossed] * 2,
+              cross_stamp, origin)
 
 
 class BubblesOverlay(BaseOverlay):
     """Rising bubbles effect overlay."""
     
+    max_particles = 80
+    particle_fields = {
+        'x': np.float32, 'y': np.float32, 'speed': np.float32, 'drift': np.float32,
+        'size': np.float32, 'opacity': np.float32,
+        'wobble': np.float32, 'wobble_speed': np.float32,
+    }
+    
     def __init__(self, width: int, height: int, settings: Dict[str, Any]):
         """Initialize bubbles overlay."""
         super().__init__(width, height, settings)
-        self.max_particles = 80
         self.spawn_rate = 2
     
-    def update(self, frame_number: int) -> None:
+    def _update(self, frame_number: int, rng: np.random.Generator) -> None:
         """Update bubbles."""
         # Spawn new bubbles from bottom
-        for _ in range(self.spawn_rate):
-            if len(self.particles) < self.max_particles:
-                self.particles.append({
-                    'x': random.uniform(0, self.width),
-                    'y': self.height + 10,
-                    'speed': random.uniform(1, 3),
-                    'drift': random.uniform(-0.5, 0.5),
-                    'size': random.uniform(5, 15),
-                    'opacity': random.uniform(0.2, 0.5),
-                    'wobble': random.uniform(0, 6.28),
-                    'wobble_speed': random.uniform(0.05, 0.1)
-                })
+        n = self._spawn_count()
+        self.particles.spawn(
+            x=rng.uniform(0, self.width, n),
+            y=np.full(n, self.height + 10.0),
+            speed=rng.uniform(1, 3, n),
+            drift=rng.uniform(-0.5, 0.5, n),
+            size=rng.uniform(5, 15, n),
+            opacity=rng.uniform(0.2, 0.5, n),
+            wobble=rng.uniform(0, 6.28, n),
+            wobble_speed=rng.uniform(0.05, 0.1, n)
+        )
         
         # Update existing particles
-        new_particles = []
-        for particle in self.particles:
-            particle['y'] -= particle['speed']
-            particle['wobble'] += particle['wobble_speed']
-            particle['x'] += np.sin(particle['wobble']) * 1 + particle['drift']
-            
-            # Keep particle if still in view
-            if particle['y'] > -20 and 0 <= particle['x'] <= self.width:
-                new_particles.append(particle)
+        p = self.particles
+        p['y'] -= p['speed']
+        p['wobble'] += p['wobble_speed']
+        p['x'] += np.sin(p['wobble']) * 1 + p['drift']
         
-        self.particles = new_particles
+        # Keep particles still in view
+        x = p['x']
+        p.cull((p['y'] > -20) & (x >= 0) & (x <= self.width))
     
-    def render(self) -> Image.Image:
-        """Render bubbles effect."""
-        img = Image.new('RGBA', (self.width, self.height), (0, 0, 0, 0))
-        draw = ImageDraw.Draw(img)
+    def _reach(self) -> np.ndarray:
+        """Bubbles extend by their radius."""
+        return self.particles['size'].astype(np.intp)
+    
+    def _draw(self, pixels: np.ndarray, origin: Tuple[int, int]) -> None:
+        """Draw bubble outlines with a highlight."""
+        p = self.particles
+        x = p['x'].astype(np.intp)
+        y = p['y'].astype(np.intp)
+        size = p['size'].astype(np.intp)
+        alpha = (255 * p['opacity']).astype(np.uint8)
         
-        for particle in self.particles:
-            x = int(particle['x'])
-            y = int(particle['y'])
-            size = int(particle['size'])
-            
-            alpha = int(255 * particle['opacity'])
-            
-            # Draw bubble outline
-            outline_color = (200, 230, 255, alpha)
-            draw.ellipse([x - size, y - size, x + size, y + size], outline=outline_color, width=2)
-            
-            # Add highlight
-            highlight_alpha = int(alpha * 0.6)
-            highlight_color = (255, 255, 255, highlight_alpha)
-            highlight_size = size // 3
-            draw.ellipse([
-                x - size // 2, y - size // 2,
-                x - size // 2 + highlight_size, y - size // 2 + highlight_size
-            ], fill=highlight_color)
+        # Draw bubble outline
+        shapes = np.stack([size, np.full_like(size, 2)], axis=1)
+        splat(pixels, x, y, _rgba((200, 230, 255), alpha), shapes, ring_stamp, origin)
         
-        return img
+        # Add highlight in the upper-left of the bubble
+        highlight_radius = size // 6
+        offset = size // 2 - highlight_radius
+        splat(pixels, x - offset, y - offset, _rgba((255, 255, 255), (alpha * 0.6).astype(np.uint8)),
+              highlight_radius, disc_stamp, origin)
 
 
 class OverlayFactory:
     """Factory for creating overlay effects."""
     
+    # Overlay names accepted by create() ('none' creates no overlay)
+    TYPES = ('rain', 'snow', 'sparkles', 'bubbles')
+    
     @staticmethod
     def create(overlay_type: str, width: int, height: int, settings: Dict[str, Any]) -> Optional[BaseOverlay]:
         """
@@ -302,7 +386,7 @@ class OverlayFactory:
             width: Image width
             height: Image height
             settings: Settings dictionary
-            
+        
         Returns:
             Overlay instance or None
         """
@@ -0,0 +1,161 @@
+"""
+Parallel frame rendering module for MP3 Spectrum Visualizer.
+Renders contiguous frame ranges in worker processes that each own a VideoGenerator.
+"""
+
+import os
+import shutil
+import tempfile
+from collections import deque
+from multiprocessing import get_context
+from typing import Any, Dict, Iterator, List, Optional, Tuple
+
+import numpy as np
+
+from core.logger import get_logger
+
+
+# Smallest per-worker cache budget; still holds a few processed full-HD backgrounds
+MIN_WORKER_CACHE_MB = 64
+
+# Per-process state created by _init_worker
+_worker_generator = None
+
+
+def _init_worker(settings: Dict[str, Any], plan, features: Dict[str, Any],
+                 array_paths: Dict[str, str]) -> None:
+    """
+    Build this worker's VideoGenerator from settings and shared analysis arrays.
+    
+    Args:
+        settings: Settings dictionary
+        plan: The parent generator's RenderPlan
+        features: Scalar/small analysis results from AudioProcessor.export_features()
+        array_paths: Mapping of feature name to .npy file opened read-only via mmap
+    """
+    global _worker_generator
+    
+    from core.audio_processor import AudioProcessor
+    from core.video_generator import VideoGenerator
+    
+    arrays = {name: np.load(path, mmap_mode='r') for name, path in array_paths.items()}
+    
+    # Shared band matrix primes the processor's cache, so workers skip the matmul
+    audio_processor = AudioProcessor.from_features({**features, **arrays})
+    _worker_generator = VideoGenerator(audio_processor, settings, plan=plan)
+
+
+def _render_chunk(task: Tuple[int, int, Optional[str], str]) -> Tuple[int, int, List[bytes]]:
+    """
+    Render a contiguous frame range in a worker.
+    
+    Args:
+        task: (start_frame, end_frame, output_dir, pix_fmt); with an output_dir
+              frames are saved as PNG, otherwise raw frames in pix_fmt are returned
+    
+    Returns:
+        (start_frame, end_frame, frames) where frames is empty in PNG mode
+    """
+    start_frame, end_frame, output_dir, pix_fmt = task
+    generator = _worker_generator
+    
+    # Replay stateful visualizers/overlays so the chunk joins seamlessly
+    generator.seek(start_frame)
+    
+    frames = []
+    for frame_num in range(start_frame, end_frame):
+        if output_dir:
+            frame = generator.generate_frame(frame_num)
+            generator.save_frame(frame, os.path.join(output_dir, f'frame_{frame_num:06d}.png'))
+        else:
+            frames.append(generator.render_frame(frame_num, pix_fmt).tobytes())
+    
+    return start_frame, end_frame, frames
+
+
+class ParallelFrameRenderer:
+    """Distributes frame ranges over a process pool and returns results in order."""
+    
+    def __init__(self, video_generator, num_workers: int, chunk_frames: int = 48):
+        """
+        Initialize parallel renderer.
+        
+        Args:
+            video_generator: VideoGenerator whose settings and analysis are shared
+            num_workers: Number of worker processes
+            chunk_frames: Frames per contiguous chunk handed to a worker
+        """
+        self.video_generator = video_generator
+        self.num_workers = max(1, num_workers)
+        self.chunk_frames = max(1, chunk_frames)
+        # Bound in-flight chunks so finished frames never pile up in memory
+        self.max_pending = self.num_workers * 2
+    
+    def iter_chunks(self, start_frame: int, end_frame: int,
+                    output_dir: Optional[str] = None,
+                    pix_fmt: str = 'rgb24') -> Iterator[Tuple[int, int, List[bytes]]]:
+        """
+        Render frames in parallel, yielding chunks in frame order.
+        
+        Args:
+            start_frame: Starting frame number
+            end_frame: Ending frame number (exclusive)
+            output_dir: Directory to save PNG frames (None returns raw frame bytes)
+            pix_fmt: Raw frame format: 'rgb24', 'yuv420p' or 'nv12'
+        
+        Yields:
+            (chunk_start, chunk_end, frames) tuples in ascending frame order
+        """
+        logger = get_logger()
+        generator = self.video_generator
+        settings = dict(generator.settings)
+        # Each worker holds its own cache: split the budget so a short video
+        # background that would be cached whole streams through the decode-ahead
+        # reader instead of being decoded once per worker
+        budget_mb = int(settings.get('cache_budget_mb', 512))
+        settings['cache_budget_mb'] = max(budget_mb // self.num_workers, MIN_WORKER_CACHE_MB)
+        
+        include_beats = generator.needs_beat_analysis()
+        features = generator.audio_processor.export_features(
+            frame_rate=generator.frame_rate, include_beats=include_beats
+        )
+        bands = generator.get_feature_table().bands
+        # Workers look bands up under the generator's layout
+        features['band_layout'] = generator.band_layout
+        
+        # Large arrays go through read-only memory-mapped files shared by all workers
+        array_dir = tempfile.mkdtemp(prefix='spectrum_viz_features_')
+        try:
+            array_paths = {}
+            for name, array in (('spectrum', features.pop('spectrum')), ('bands', bands)):
+                path = os.path.join(array_dir, f'{name}.npy')
+                np.save(path, np.ascontiguousarray(array))
+                array_paths[name] = path
+            
+            tasks = [
+                (chunk_start, min(chunk_start + self.chunk_frames, end_frame), output_dir, pix_fmt)
+                for chunk_start in range(start_frame, end_frame, self.chunk_frames)
+            ]
+            logger.info(f"Rendering {end_frame - start_frame} frames in {len(tasks)} chunks "
+                        f"on {self.num_workers} worker processes")
+            
+            # Spawned workers avoid inheriting GUI threads and open video handles
+            context = get_context('spawn')
+            with context.Pool(self.num_workers, initializer=_init_worker,
+                              initargs=(settings, generator.plan, features, array_paths)) as pool:
+                pending = deque()
+                task_iter = iter(tasks)
+                
+                for task in task_iter:
+                    pending.append(pool.apply_async(_render_chunk, (task,)))
+                    if len(pending) >= self.max_pending:
+                        break
+                
+                while pending:
+                    result = pending.popleft().get()
+                    next_task = next(task_iter, None)
+                    if next_task is not None:
+                        pending.append(pool.apply_async(_render_chunk, (next_task,)))
+                    yield result
+        finally:
+            shutil.rmtree(array_dir, ignore_errors=True)
@@ -0,0 +1,255 @@
+"""
+Particle system module for MP3 Spectrum Visualizer.
+Stores particles as contiguous NumPy arrays (structure of arrays) and splats
+them onto RGBA layers with batched stamp rasterization.
+"""
+
+from functools import lru_cache
+from typing import Any, Callable, Dict, Optional, Tuple
+
+import numpy as np
+
+
+class ParticleSystem:
+    """
+    Fixed-capacity particle pool with one contiguous array per field.
+    
+    Live particles occupy the first len(system) slots, so integration is plain
+    array arithmetic on system['field'] views and culling is a single compaction.
+    """
+    
+    def __init__(self, capacity: int, fields: Dict[str, Any]):
+        """
+        Initialize particle pool.
+        
+        Args:
+            capacity: Maximum number of live particles
+            fields: Field name -> dtype, or (dtype, width) for vector fields
+                    such as RGB colors
+        """
+        self.capacity = max(int(capacity), 0)
+        self.count = 0
+        self._arrays: Dict[str, np.ndarray] = {}
+        for name, spec in fields.items():
+            if isinstance(spec, tuple):
+                dtype, width = spec
+                shape = (self.capacity, width)
+            else:
+                dtype, shape = spec, (self.capacity,)
+            self._arrays[name] = np.zeros(shape, dtype=dtype)
+    
+    def __len__(self) -> int:
+        """Number of live particles."""
+        return self.count
+    
+    def __getitem__(self, name: str) -> np.ndarray:
+        """Writable view of a field for the live particles."""
+        return self._arrays[name][:self.count]
+    
+    def __setitem__(self, name: str, values: Any) -> None:
+        """
+        Assign a field of the live particles.
+        
+        Augmented assignment (system['y'] += system['vy']) updates the view in
+        place and then assigns it back; that write-back is skipped.
+        
+        Args:
+            name: Field name
+            values: Array with one row per live particle, or a scalar
+        """
+        view = self._arrays[name][:self.count]
+        if isinstance(values, np.ndarray) and values.base is self._arrays[name] \
+                and values.shape == view.shape and values.ctypes.data == view.ctypes.data:
+            return
+        view[...] = values
+    
+    @property
+    def free(self) -> int:
+        """Number of particles that can still be spawned."""
+        return self.capacity - self.count
+    
+    def spawn(self, **values: Any) -> int:
+        """
+        Append particles.
+        
+        Every field must be given, as an array with one row per particle or a
+        scalar shared by all of them. Particles beyond the capacity are dropped.
+        
+        Args:
+            **values: Field name -> values
+        
+        Returns:
+            Number of particles spawned
+        """
+        lengths = [len(v) for v in values.values() if np.ndim(v) > 0]
+        n = min(min(lengths) if lengths else 0, self.free)
+        if n <= 0:
+            return 0
+        
+        start, end = self.count, self.count + n
+        for name, array in self._arrays.items():
+            value = values[name]
+            array[start:end] = value[:n] if np.ndim(value) > 0 else value
+        self.count = end
+        return n
+    
+    def cull(self, keep: np.ndarray) -> None:
+        """
+        Remove particles, preserving the order of the survivors.
+        
+        Args:
+            keep: Boolean mask over the live particles
+        """
+        survivors = int(np.count_nonzero(keep))
+        if survivors == self.count:
+            return
+        for array in self._arrays.values():
+            array[:survivors] = array[:self.count][keep]
+        self.count = survivors
+    
+    def reset(self) -> None:
+        """Remove all particles."""
+        self.count = 0
+
+
+@lru_cache(maxsize=256)
+def disc_stamp(radius: int) -> Tuple[np.ndarray, np.ndarray]:
+    """
+    Pixel offsets of a filled disc (matches ImageDraw.ellipse on a 2r+1 box).
+    
+    Args:
+        radius: Disc radius in pixels
+    
+    Returns:
+        (dy, dx) offset arrays
+    """
+    radius = max(int(radius), 0)
+    dy, dx = np.mgrid[-radius:radius + 1, -radius:radius + 1]
+    inside = dy * dy + dx * dx <= radius * radius + radius
+    return _readonly(dy[inside]), _readonly(dx[inside])
+
+
+@lru_cache(maxsize=256)
+def ring_stamp(radius: int, width: int) -> Tuple[np.ndarray, np.ndarray]:
+    """
+    Pixel offsets of a circle outline.
+    
+    Args:
+        radius: Outer radius in pixels
+        width: Outline width in pixels
+    
+    Returns:
+        (dy, dx) offset arrays
+    """
+    radius = max(int(radius), 0)
+    inner = radius - max(int(width), 1)
+    dy, dx = np.mgrid[-radius:radius + 1, -radius:radius + 1]
+    dist2 = dy * dy + dx * dx
+    inside = (dist2 <= radius * radius + radius) & (dist2 > inner * inner + inner)
+    return _readonly(dy[inside]), _readonly(dx[inside])
+
+
+@lru_cache(maxsize=256)
+def vline_stamp(length: int, thickness: int) -> Tuple[np.ndarray, np.ndarray]:
+    """
+    Pixel offsets of a vertical line starting at the particle and going down.
+    
+    Args:
+        length: Line length in pixels
+        thickness: Line width in pixels
+    
+    Returns:
+        (dy, dx) offset arrays
+    """
+    thickness = max(int(thickness), 1)
+    dy, dx = np.mgrid[0:max(int(length), 0) + 1, -(thickness // 2):thickness - thickness // 2]
+    return _readonly(dy.ravel()), _readonly(dx.ravel())
+
+
+@lru_cache(maxsize=256)
+def cross_stamp(arm: int) -> Tuple[np.ndarray, np.ndarray]:
+    """
+    Pixel offsets of a one-pixel "+" with arms of the given length.
+    
+    Args:
+        arm: Arm length in pixels
+    
+    Returns:
+        (dy, dx) offset arrays
+    """
+    span = np.arange(-max(int(arm), 0), max(int(arm), 0) + 1)
+    zeros = np.zeros_like(span)
+    return _readonly(np.concatenate([zeros, span])), _readonly(np.concatenate([span, zeros]))
+
+
+def _readonly(array: np.ndarray) -> np.ndarray:
+    """Mark a cached stamp array read-only."""
+    array.flags.writeable = False
+    return array
+
+
+def particle_box(x: np.ndarray, y: np.ndarray, reach) -> Optional[Tuple[int, int, int, int]]:
+    """
+    Get the box that particles can draw into.
+    
+    Args:
+        x: Particle x positions (pixels)
+        y: Particle y positions (pixels)
+        reach: Largest stamp offset from the particle position, scalar or per particle
+    
+    Returns:
+        Unclipped (left, top, right, bottom) box, or None when there are no particles
+    """
+    if len(x) == 0:
+        return None
+    xi = np.asarray(x).astype(np.intp)
+    yi = np.asarray(y).astype(np.intp)
+    reach = np.asarray(reach, dtype=np.intp)
+    return (int(np.min(xi - reach)), int(np.min(yi - reach)),
+            int(np.max(xi + reach)) + 1, int(np.max(yi + reach)) + 1)
+
+
+def splat(pixels: np.ndarray, x: np.ndarray, y: np.ndarray, colors: np.ndarray,
+          shapes: np.ndarray, stamp: Callable[..., Tuple[np.ndarray, np.ndarray]],
+          origin: Tuple[int, int] = (0, 0)) -> None:
+    """
+    Draw many particles onto an RGBA array in one batched scatter per stamp shape.
+    
+    Pixels are replaced, not blended, like ImageDraw fills on an RGBA image.
+    Particles sharing a shape are written together; later particles win where
+    they overlap.
+    
+    Args:
+        pixels: (height, width, 4) uint8 array, modified in place
+        x: Particle x positions (pixels)
+        y: Particle y positions (pixels)
+        colors: (N, 4) RGBA colors
+        shapes: (N,) or (N, k) integer stamp parameters, e.g. disc radii
+        stamp: Function(*shape) returning (dy, dx) offsets, e.g. disc_stamp
+        origin: Frame position of pixels[0, 0] when drawing into a region
+    """
+    if len(x) == 0:
+        return
+    
+    height, width = pixels.shape[:2]
+    xi = np.asarray(x).astype(np.intp) - origin[0]
+    yi = np.asarray(y).astype(np.intp) - origin[1]
+    colors = np.asarray(colors, dtype=np.uint8)
+    shapes = np.asarray(shapes, dtype=np.intp)
+    if shapes.ndim == 1:
+        shapes = shapes[:, None]
+    
+    unique_shapes, groups = np.unique(shapes, axis=0, return_inverse=True)
+    groups = groups.reshape(-1)
+    for group, shape in enumerate(unique_shapes):
+        members = np.flatnonzero(groups == group)
+        dy, dx = stamp(*shape.tolist())
+        
+        py = yi[members, None] + dy[None, :]
+        px = xi[members, None] + dx[None, :]
+        visible = (py >= 0) & (py < height) & (px >= 0) & (px < width)
+        if not visible.any():
+            continue
+        
+        member_colors = np.broadcast_to(colors[members, None, :], py.shape + (4,))
+        pixels[py[visible], px[visible]] = member_colors[visible]
@@ -0,0 +1,317 @@
+"""
+Render pipeline module for MP3 Spectrum Visualizer.
+Runs frame preparation, background decode, rendering and encoder feed as
+threaded stages connected by bounded queues, with recycled frame buffers.
+"""
+
+import queue
+import threading
+import time
+from typing import Any, Callable, Dict, Iterable, Iterator, List, Optional
+
+import numpy as np
+
+from core.logger import get_logger
+
+
+# Marks the end of a stream in a stage queue
+_END = object()
+
+
+class PipelineAborted(Exception):
+    """Raised inside stages when another stage failed or the consumer stopped."""
+
+
+class StageQueue:
+    """Bounded FIFO between two stages that tracks its depth."""
+    
+    def __init__(self, name: str, capacity: int, abort: threading.Event):
+        """
+        Initialize queue.
+        
+        Args:
+            name: Name of the stage that fills the queue
+            capacity: Maximum queued items; a full queue blocks the producer
+            abort: Event set when the pipeline is shutting down
+        """
+        self.name = name
+        self.capacity = max(int(capacity), 1)
+        self._queue = queue.Queue(maxsize=self.capacity)
+        self._abort = abort
+        self.peak_depth = 0
+    
+    def put(self, item: Any) -> None:
+        """Queue an item, blocking while the queue is full (backpressure)."""
+        while True:
+            if self._abort.is_set():
+                raise PipelineAborted()
+            try:
+                self._queue.put(item, timeout=0.1)
+            except queue.Full:
+                continue
+            self.peak_depth = max(self.peak_depth, self._queue.qsize())
+            return
+    
+    def get(self) -> Any:
+        """Take the next item, blocking while the queue is empty."""
+        while True:
+            if self._abort.is_set():
+                raise PipelineAborted()
+            try:
+                return self._queue.get(timeout=0.1)
+            except queue.Empty:
+                continue
+    
+    def depth(self) -> int:
+        """Number of items currently queued."""
+        return self._queue.qsize()
+
+
+class FramePool:
+    """
+    Fixed set of reusable frame buffers.
+    
+    The render stage copies each finished frame into a pooled buffer and the
+    encoder stage returns it once written, so at most `count` frames are in
+    flight and a slow encoder stalls rendering instead of growing memory.
+    """
+    
+    def __init__(self, frame_bytes: int, count: int, abort: threading.Event):
+        """
+        Initialize pool.
+        
+        Args:
+            frame_bytes: Size of one raw frame
+            count: Number of buffers
+            abort: Event set when the pipeline is shutting down
+        """
+        self._free = StageQueue('frame_pool', count, abort)
+        for _ in range(max(int(count), 1)):
+            self._free.put(np.empty(frame_bytes, dtype=np.uint8))
+    
+    def acquire(self) -> np.ndarray:
+        """Take a free buffer, blocking until the encoder releases one."""
+        return self._free.get()
+    
+    def release(self, buffer: np.ndarray) -> None:
+        """Return a buffer to the pool."""
+        self._free.put(buffer)
+    
+    def available(self) -> int:
+        """Number of free buffers."""
+        return self._free.depth()
+
+
+class StageStats:
+    """Throughput counters of one stage."""
+    
+    def __init__(self, name: str):
+        """
+        Initialize counters.
+        
+        Args:
+            name: Stage name
+        """
+        self.name = name
+        self.items = 0
+        self.busy_seconds = 0.0  # Time spent working, excluding waits on queues
+    
+    def record(self, seconds: float) -> None:
+        """Count one processed item."""
+        self.items += 1
+        self.busy_seconds += seconds
+
+
+class RenderPipeline:
+    """
+    Connects frame stages into a threaded pipeline.
+    
+    Every stage but the last runs in its own thread, taking items from the
+    previous stage's queue and putting results on its own bounded queue. The
+    last stage (the encoder feed) runs in the calling thread, so backpressure
+    propagates from the encoder up to the first stage.
+    
+    Stages must be safe to run concurrently with each other; each stage is run
+    by a single thread, so it may keep per-stage state.
+    """
+    
+    def __init__(self, queue_size: int = 4):
+        """
+        Initialize pipeline.
+        
+        Args:
+            queue_size: Capacity of each queue between stages
+        """
+        self.queue_size = max(int(queue_size), 1)
+        self._abort = threading.Event()
+        self._stages: List[tuple] = []
+        self._queues: List[StageQueue] = []
+        self._stats: Dict[str, StageStats] = {}
+        self._errors: List[BaseException] = []
+        self._threads: List[threading.Thread] = []
+        self._start_time = 0.0
+        self.pool: Optional[FramePool] = None
+    
+    def set_frame_pool(self, frame_bytes: int, count: int) -> FramePool:
+        """
+        Create the recycled frame buffer pool shared by the render and encode stages.
+        
+        Args:
+            frame_bytes: Size of one raw frame
+            count: Number of buffers (frames in flight)
+        
+        Returns:
+            The pool
+        """
+        self.pool = FramePool(frame_bytes, count, self._abort)
+        return self.pool
+    
+    def source(self, name: str, items: Iterable[Any]) -> 'RenderPipeline':
+        """
+        Set the first stage: an iterable producing the pipeline's items.
+        
+        Args:
+            name: Stage name
+            items: Items to feed, consumed in the stage thread
+        
+        Returns:
+            self, for chaining
+        """
+        self._stages.append((name, None, items))
+        self._stats[name] = StageStats(name)
+        return self
+    
+    def stage(self, name: str, function: Callable[[Any], Any]) -> 'RenderPipeline':
+        """
+        Append a stage that maps each item.
+        
+        Args:
+            name: Stage name
+            function: Function(item) -> item for the next stage
+        
+        Returns:
+            self, for chaining
+        """
+        self._stages.append((name, function, None))
+        self._stats[name] = StageStats(name)
+        return self
+    
+    def run(self, sink_name: str, sink: Callable[[Any], None]) -> None:
+        """
+        Run the pipeline to completion, feeding every item to sink in order.
+        
+        Args:
+            sink_name: Name of the final stage
+            sink: Function(item) run in the calling thread (e.g. the encoder feed)
+        
+        Raises:
+            Exception: The first error raised by any stage
+        """
+        self._stats[sink_name] = StageStats(sink_name)
+        self._start_time = time.perf_counter()
+        self._queues = [StageQueue(name, self.queue_size, self._abort) for name, _, _ in self._stages]
+        
+        for index, (name, function, items) in enumerate(self._stages):
+            inbox = self._queues[index - 1] if index > 0 else None
+            thread = threading.Thread(
+                target=self._run_stage, args=(name, function, items, inbox, self._queues[index]),
+                name=f'pipeline-{name}', daemon=True
+            )
+            self._threads.append(thread)
+            thread.start()
+        
+        stats = self._stats[sink_name]
+        outbox = self._queues[-1]
+        try:
+            while True:
+                item = outbox.get()
+                if item is _END:
+                    break
+                started = time.perf_counter()
+                sink(item)
+                stats.record(time.perf_counter() - started)
+        except PipelineAborted:
+            pass
+        except BaseException as e:
+            self._errors.append(e)
+        finally:
+            self._abort.set()
+            for thread in self._threads:
+                thread.join()
+        
+        if self._errors:
+            raise self._errors[0]
+    
+    def _run_stage(self, name: str, function: Optional[Callable[[Any], Any]],
+                   items: Optional[Iterable[Any]], inbox: Optional[StageQueue],
+                   outbox: StageQueue) -> None:
+        """Thread body of one stage."""
+        stats = self._stats[name]
+        iterator: Optional[Iterator[Any]] = None
+        try:
+            if items is not None:
+                iterator = iter(items)
+                while True:
+                    started = time.perf_counter()
+                    item = next(iterator, _END)
+                    if item is _END:
+                        break
+                    stats.record(time.perf_counter() - started)
+                    outbox.put(item)
+            else:
+                while True:
+                    item = inbox.get()
+                    if item is _END:
+                        break
+                    started = time.perf_counter()
+                    result = function(item)
+                    stats.record(time.perf_counter() - started)
+                    outbox.put(result)
+            outbox.put(_END)
+        except PipelineAborted:
+            pass
+        except BaseException as e:
+            get_logger().error(f"Pipeline stage '{name}' failed: {e}", exc_info=True)
+            self._errors.append(e)
+            self._abort.set()
+        finally:
+            # Let generator sources release what they hold (e.g. a worker pool)
+            close = getattr(iterator, 'close', None)
+            if close is not None:
+                close()
+    
+    def snapshot(self) -> Dict[str, Dict[str, Any]]:
+        """
+        Get per-stage statistics.
+        
+        A stage whose output queue is usually full is waiting on a later stage;
+        the stage with the highest utilization is the bottleneck.
+        
+        Returns:
+            Stage name -> {'items', 'fps', 'utilization', 'queue_depth', 'queue_capacity',
+            'queue_peak'}
+            (the final stage has no output queue)
+        """
+        elapsed = max(time.perf_counter() - self._start_time, 1e-6)
+        queues = {q.name: q for q in self._queues}
+        result = {}
+        for name, stats in self._stats.items():
+            entry = {
+                'items': stats.items,
+                'fps': stats.items / elapsed,
+                # Fraction of wall time spent working (1.0 = never waiting)
+                'utilization': min(stats.busy_seconds / elapsed, 1.0),
+            }
+            if name in queues:
+                entry['queue_depth'] = queues[name].depth()
+                entry['queue_capacity'] = queues[name].capacity
+                entry['queue_peak'] = queues[name].peak_depth
+            result[name] = entry
+        if self.pool is not None:
+            result['frame_pool'] = {'free_buffers': self.pool.available()}
+        return result
+    
+    def bottleneck(self) -> Optional[str]:
+        """Get the name of the stage with the highest utilization."""
+        stages = [(s.busy_seconds, name) for name, s in self._stats.items()]
+        return max(stages)[1] if stages else None
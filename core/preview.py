@@ -0,0 +1,300 @@
+"""
+Preview rendering module for MP3 Spectrum Visualizer.
+Renders preview frames at display resolution, refines them progressively and
+caches rendered layers keyed by the settings that affect each layer, so
+settings changes only re-render the layers they touch.
+"""
+
+import threading
+from typing import Any, Callable, Dict, Iterator, List, Optional, Sequence, Tuple
+
+import numpy as np
+from PIL import Image
+
+from core.audio_processor import AudioProcessor
+from core.compositor import FrameCompositor
+from core.layers import Layer, LayerSnapshot
+from core.logger import get_logger
+
+
+# Settings that change what each cached layer looks like. Everything else
+# (opacities, text, logo, flash and strobe colors) only changes compositing.
+LAYER_SETTINGS = {
+    'background': (
+        'background_type', 'background_color', 'background_path', 'background_paths',
+        'background_fit', 'video_background_path', 'video_background_paths', 'background_blur',
+        'background_bw', 'vignette_intensity', 'background_animation', 'slideshow_enabled',
+        'slideshow_interval', 'slideshow_transition', 'transition_duration', 'auto_adjust_slideshow',
+        'background_beat_shake_enabled', 'background_beat_shake_intensity',
+        # Beat pulse/zoom is folded into the cached background transform
+        'beat_sync_enabled', 'beat_effect_type', 'random_seed', 'frame_rate',
+    ),
+    'visualizer': (
+        'visualizer_enabled', 'visualizer_style', 'band_layout', 'color_gradient',
+        'custom_color_start', 'custom_color_end', 'monochrome_color', 'random_seed', 'frame_rate',
+    ),
+    'overlay': (
+        'overlay_effect_type', 'overlay_video_path', 'random_seed', 'frame_rate',
+    ),
+}
+
+# Settings that require a new generator instead of updating the current one
+_STRUCTURAL_SETTINGS = tuple(sorted({key for keys in LAYER_SETTINGS.values() for key in keys}))
+
+
+def preview_size(output_size: Tuple[int, int], display_size: Tuple[int, int]) -> Tuple[int, int]:
+    """
+    Get the largest size with the output aspect ratio that fits the display.
+    
+    Args:
+        output_size: Output video (width, height)
+        display_size: Preview widget (width, height)
+    
+    Returns:
+        (width, height), even and never larger than the output
+    """
+    out_width, out_height = output_size
+    scale = min(display_size[0] / out_width, display_size[1] / out_height, 1.0)
+    width = max(int(out_width * scale) // 2 * 2, 2)
+    height = max(int(out_height * scale) // 2 * 2, 2)
+    return width, height
+
+
+def _settings_key(settings: Dict[str, Any], keys: Sequence[str]) -> Tuple:
+    """Hashable snapshot of the given settings."""
+    return tuple(repr(settings.get(key)) for key in keys)
+
+
+class PreviewEngine:
+    """
+    Progressive preview renderer with per-layer caches.
+    
+    Each pass renders every preview frame at a resolution; the first pass is
+    coarse so something appears quickly, later passes refine it. For every
+    resolution the background, visualizer and overlay layers of each frame are
+    cached under a key of their LAYER_SETTINGS, and a new render only redraws
+    the layers whose key changed before recompositing.
+    
+    One render runs at a time; cancel() stops it between frames.
+    """
+    
+    # Fractions of the display size rendered by successive passes
+    PASS_SCALES = (0.5, 1.0)
+    
+    def __init__(self, audio_processor: AudioProcessor, cache_budget_mb: int = 256):
+        """
+        Initialize preview engine.
+        
+        Args:
+            audio_processor: AudioProcessor with the loaded track
+            cache_budget_mb: Memory for cached layers across all resolutions
+        """
+        self.audio_processor = audio_processor
+        self.cache_budget = int(cache_budget_mb) * 1024 * 1024
+        self._cancel = threading.Event()
+        self._lock = threading.Lock()
+        # (layer, size) -> (settings key, {frame_number: cached layer})
+        self._layers: Dict[Tuple[str, Tuple[int, int]], Tuple[Tuple, Dict[int, Any]]] = {}
+        # size -> (structural settings key, VideoGenerator)
+        self._generators: Dict[Tuple[int, int], Tuple[Tuple, Any]] = {}
+        self._compositors: Dict[Tuple[int, int], FrameCompositor] = {}
+    
+    def cancel(self) -> None:
+        """Stop the running render after its current frame."""
+        self._cancel.set()
+    
+    def render(self, settings: Dict[str, Any], display_size: Tuple[int, int],
+               frame_numbers: Sequence[int],
+               pass_callback: Optional[Callable[[int, List[np.ndarray]], None]] = None,
+               frame_callback: Optional[Callable[[int, int, np.ndarray], None]] = None) -> List[np.ndarray]:
+        """
+        Render preview frames progressively.
+        
+        Args:
+            settings: Settings dictionary of the output render
+            display_size: Preview widget (width, height)
+            frame_numbers: Output frame numbers to preview, ascending
+            pass_callback: Called with (pass index, frames) after each finished pass
+            frame_callback: Called with (pass index, frame index, frame) per frame
+        
+        Returns:
+            (height, width, 3) RGB frames of the last finished pass (empty if
+            cancelled before the first)
+        """
+        with self._lock:
+            self._cancel.clear()
+            output_size = (settings.get('video_width', 1920), settings.get('video_height', 1080))
+            sizes = []
+            for scale in self.PASS_SCALES:
+                size = preview_size(output_size, (display_size[0] * scale, display_size[1] * scale))
+                if size not in sizes:
+                    sizes.append(size)
+            
+            finished: List[np.ndarray] = []
+            for pass_index, size in enumerate(sizes):
+                frames = []
+                for _, frame in self._iter_pass(settings, size, frame_numbers):
+                    frames.append(frame)
+                    if frame_callback:
+                        frame_callback(pass_index, len(frames) - 1, frame)
+                if self._cancel.is_set() or not frames:
+                    break
+                finished = frames
+                if pass_callback:
+                    pass_callback(pass_index, frames)
+            self._trim_cache()
+            return finished
+    
+    def stream(self, settings: Dict[str, Any], display_size: Tuple[int, int],
+               frame_numbers: Sequence[int]) -> Iterator[Tuple[int, np.ndarray]]:
+        """
+        Render frames one at a time at display size, for streamed playback.
+        
+        Layers are not cached, so memory stays flat however long the track is.
+        The engine is held until the iterator is exhausted or closed.
+        
+        Args:
+            settings: Settings dictionary of the output render
+            display_size: Preview widget (width, height)
+            frame_numbers: Output frame numbers to render, ascending
+        
+        Yields:
+            (frame number, (height, width, 3) RGB frame)
+        """
+        with self._lock:
+            self._cancel.clear()
+            output_size = (settings.get('video_width', 1920), settings.get('video_height', 1080))
+            size = preview_size(output_size, display_size)
+            yield from self._iter_pass(settings, size, frame_numbers, cache_layers=False)
+    
+    def _iter_pass(self, settings: Dict[str, Any], size: Tuple[int, int],
+                   frame_numbers: Sequence[int],
+                   cache_layers: bool = True) -> Iterator[Tuple[int, np.ndarray]]:
+        """Render frames at one size, stopping early when cancelled or on an error."""
+        generator = self._get_generator(settings, size)
+        compositor = self._compositors.get(size)
+        if compositor is None:
+            compositor = FrameCompositor(*size)
+            self._compositors[size] = compositor
+        
+        if cache_layers:
+            caches = {name: self._layer_cache(name, size, settings) for name in LAYER_SETTINGS}
+            # A layer is reused only when every frame is cached; otherwise it is redrawn
+            # in order, so stateful visualizers/overlays see the same frame sequence
+            redraw = {name: not all(n in cache for n in frame_numbers) for name, cache in caches.items()}
+        else:
+            # Nothing is kept: a streamed track would grow the caches without bound
+            caches = {name: {} for name in LAYER_SETTINGS}
+            redraw = dict.fromkeys(LAYER_SETTINGS, True)
+        if frame_numbers and (redraw['visualizer'] or redraw['overlay']):
+            generator.seek(frame_numbers[0])
+        
+        for frame_number in frame_numbers:
+            if self._cancel.is_set():
+                return
+            try:
+                job = generator._prepare_frame(frame_number)
+                
+                background = caches['background'].get(frame_number)
+                if redraw['background'] or background is None:
+                    loaded = generator._load_frame_background(job)
+                    background = (loaded.background, loaded.background_transform)
+                    if cache_layers:
+                        caches['background'][frame_number] = background
+                job = job._replace(background=background[0], background_transform=background[1])
+                
+                visualizer_layer = caches['visualizer'].get(frame_number)
+                if redraw['visualizer']:
+                    visualizer_layer = generator.render_visualizer_layer(job)
+                    if cache_layers:
+                        visualizer_layer = self._freeze(visualizer_layer)
+                        caches['visualizer'][frame_number] = visualizer_layer
+                
+                overlay_layer = caches['overlay'].get(frame_number)
+                if redraw['overlay']:
+                    overlay_layer = generator.render_overlay_layer(job)
+                    if cache_layers:
+                        overlay_layer = self._freeze(overlay_layer)
+                        caches['overlay'][frame_number] = overlay_layer
+                
+                generator.composite_layers(compositor, job, visualizer_layer or None, overlay_layer or None)
+                # Copied out of the reused canvas buffer so the caller may keep it
+                frame = compositor.to_rgb().copy()
+            except Exception as e:
+                get_logger().error(f"Error rendering preview frame {frame_number}: {e}", exc_info=True)
+                return
+            
+            yield frame_number, frame
+    
+    @staticmethod
+    def _freeze(layer):
+        """Copy a reusable layer so it can be cached (False marks 'no layer')."""
+        if layer is None:
+            return False
+        if isinstance(layer, Layer):
+            return layer.snapshot()
+        return layer
+    
+    def _get_generator(self, settings: Dict[str, Any], size: Tuple[int, int]):
+        """Get the generator for a preview size, rebuilding it when layer settings changed."""
+        from core.video_generator import VideoGenerator
+        
+        key = _settings_key(settings, _STRUCTURAL_SETTINGS)
+        entry = self._generators.get(size)
+        if entry is not None and entry[0] == key:
+            # Only compositing settings changed: the generator recompiles its render plan
+            generator = entry[1]
+            generator.update_settings(self._preview_settings(settings, size))
+            return generator
+        
+        generator = VideoGenerator(self.audio_processor, self._preview_settings(settings, size))
+        self._generators[size] = (key, generator)
+        return generator
+    
+    @staticmethod
+    def _preview_settings(settings: Dict[str, Any], size: Tuple[int, int]) -> Dict[str, Any]:
+        """Settings of a preview generator: the output settings at the preview size."""
+        preview_settings = dict(settings)
+        preview_settings['video_width'], preview_settings['video_height'] = size
+        # Preview frames are composited on the CPU at small sizes
+        preview_settings['render_backend'] = 'cpu'
+        return preview_settings
+    
+    def _layer_cache(self, name: str, size: Tuple[int, int], settings: Dict[str, Any]) -> Dict[int, Any]:
+        """Get the frame cache of a layer, emptied when its settings changed."""
+        key = _settings_key(settings, LAYER_SETTINGS[name])
+        entry = self._layers.get((name, size))
+        if entry is None or entry[0] != key:
+            entry = (key, {})
+            self._layers[(name, size)] = entry
+        return entry[1]
+    
+    def _trim_cache(self) -> None:
+        """Drop cached layers of smaller sizes first while over the memory budget."""
+        def entry_bytes(frames: Dict[int, Any]) -> int:
+            # Static backgrounds are one image shared by every frame: count it once
+            images = {}
+            total = 0
+            for value in frames.values():
+                if isinstance(value, tuple):
+                    value = value[0]
+                if isinstance(value, LayerSnapshot):
+                    total += value.nbytes
+                elif isinstance(value, Image.Image):
+                    images[id(value)] = value.width * value.height * len(value.getbands())
+            return total + sum(images.values())
+        
+        sizes = {key: entry_bytes(entry[1]) for key, entry in self._layers.items()}
+        total = sum(sizes.values())
+        for key in sorted(sizes, key=lambda k: k[1][0] * k[1][1]):
+            if total <= self.cache_budget:
+                break
+            total -= sizes[key]
+            del self._layers[key]
+    
+    def clear(self) -> None:
+        """Drop all cached layers and generators (e.g. when a new track is loaded)."""
+        with self._lock:
+            self._layers.clear()
+            self._generators.clear()
+            self._compositors.clear()
@@ -0,0 +1,324 @@
+"""
+Profiling module for MP3 Spectrum Visualizer.
+Times named stages of the render and analysis hot paths into per-stage
+histograms and optionally records a Chrome/Perfetto trace.
+"""
+
+import json
+import os
+import threading
+import time
+from typing import Any, Dict, List, Optional
+
+from core.logger import get_logger
+
+
+# Histogram buckets are powers of two in microseconds: bucket i holds [2^(i-1), 2^i) us
+HISTOGRAM_BUCKETS = 32
+
+# Trace events kept before further events are dropped (about 100 bytes each)
+MAX_TRACE_EVENTS = 2_000_000
+
+
+class _NullSpan:
+    """Span returned while profiling is disabled; does nothing."""
+    
+    __slots__ = ()
+    
+    def __enter__(self):
+        return self
+    
+    def __exit__(self, exc_type, exc_value, traceback):
+        return False
+
+
+_NULL_SPAN = _NullSpan()
+
+
+class _Span:
+    """Times one execution of a stage and records it on exit."""
+    
+    __slots__ = ('_profiler', '_name', '_start')
+    
+    def __init__(self, profiler: 'Profiler', name: str):
+        self._profiler = profiler
+        self._name = name
+        self._start = 0
+    
+    def __enter__(self):
+        self._start = time.perf_counter_ns()
+        return self
+    
+    def __exit__(self, exc_type, exc_value, traceback):
+        self._profiler.record(self._name, self._start, time.perf_counter_ns() - self._start)
+        return False
+
+
+class StageStats:
+    """Duration histogram of one stage."""
+    
+    __slots__ = ('count', 'total_ns', 'min_ns', 'max_ns', 'buckets')
+    
+    def __init__(self):
+        self.count = 0
+        self.total_ns = 0
+        self.min_ns = 0
+        self.max_ns = 0
+        self.buckets = [0] * HISTOGRAM_BUCKETS
+    
+    def add(self, duration_ns: int) -> None:
+        """Add one duration."""
+        if self.count == 0 or duration_ns < self.min_ns:
+            self.min_ns = duration_ns
+        if duration_ns > self.max_ns:
+            self.max_ns = duration_ns
+        self.count += 1
+        self.total_ns += duration_ns
+        bucket = (duration_ns // 1000).bit_length()
+        self.buckets[min(bucket, HISTOGRAM_BUCKETS - 1)] += 1
+    
+    def percentile(self, fraction: float) -> float:
+        """
+        Estimate a percentile from the histogram.
+        
+        Args:
+            fraction: Percentile as a fraction (0.95 = p95)
+        
+        Returns:
+            Duration in nanoseconds, interpolated within the bucket holding the
+            percentile and clamped to the observed range
+        """
+        target = fraction * self.count
+        seen = 0
+        for bucket, count in enumerate(self.buckets):
+            if count and seen + count >= target:
+                lower = (1 << bucket >> 1) * 1000
+                upper = (1 << bucket) * 1000
+                estimate = lower + (upper - lower) * (target - seen) / count
+                return float(min(max(estimate, self.min_ns), self.max_ns))
+            seen += count
+        return float(self.max_ns)
+    
+    def to_dict(self) -> Dict[str, Any]:
+        """Summary in milliseconds plus the non-empty buckets keyed by their upper edge in us."""
+        return {
+            'count': self.count,
+            'total_ms': self.total_ns / 1e6,
+            'mean_ms': self.total_ns / self.count / 1e6 if self.count else 0.0,
+            'min_ms': self.min_ns / 1e6,
+            'p50_ms': self.percentile(0.5) / 1e6,
+            'p95_ms': self.percentile(0.95) / 1e6,
+            'max_ms': self.max_ns / 1e6,
+            'histogram': {1 << bucket: count for bucket, count in enumerate(self.buckets) if count},
+        }
+
+
+class Profiler:
+    """
+    Collects stage timings from every thread of this process.
+    
+    Spans may nest (e.g. 'background' around 'background.video_seek'); each
+    records its own wall time, so nested stages are counted in their parents.
+    """
+    
+    def __init__(self, trace: bool = False, max_trace_events: int = MAX_TRACE_EVENTS):
+        """
+        Initialize profiler.
+        
+        Args:
+            trace: Also keep every span as a trace event for export_trace()
+            max_trace_events: Trace events kept before further ones are dropped
+        """
+        self.trace = trace
+        self.max_trace_events = max_trace_events
+        self._lock = threading.Lock()
+        self._stages: Dict[str, StageStats] = {}
+        self._events: List[tuple] = []
+        self._threads: Dict[int, str] = {}
+        self.dropped_events = 0
+        self._origin_ns = time.perf_counter_ns()
+    
+    def span(self, name: str) -> _Span:
+        """Get a context manager that times the enclosed block as stage name."""
+        return _Span(self, name)
+    
+    def record(self, name: str, start_ns: int, duration_ns: int) -> None:
+        """
+        Record one execution of a stage.
+        
+        Args:
+            name: Stage name
+            start_ns: time.perf_counter_ns() at the start
+            duration_ns: Duration in nanoseconds
+        """
+        with self._lock:
+            stats = self._stages.get(name)
+            if stats is None:
+                stats = self._stages[name] = StageStats()
+            stats.add(duration_ns)
+            
+            if self.trace:
+                if len(self._events) >= self.max_trace_events:
+                    self.dropped_events += 1
+                    return
+                thread_id = threading.get_ident()
+                if thread_id not in self._threads:
+                    self._threads[thread_id] = threading.current_thread().name
+                self._events.append((name, start_ns, duration_ns, thread_id))
+    
+    def reset(self) -> None:
+        """Forget all timings and trace events."""
+        with self._lock:
+            self._stages.clear()
+            self._events.clear()
+            self._threads.clear()
+            self.dropped_events = 0
+            self._origin_ns = time.perf_counter_ns()
+    
+    def snapshot(self) -> Dict[str, Dict[str, Any]]:
+        """
+        Get the statistics of every stage.
+        
+        Returns:
+            Stage name -> {'count', 'total_ms', 'mean_ms', 'min_ms', 'p50_ms',
+            'p95_ms', 'max_ms', 'histogram'} sorted by name
+        """
+        with self._lock:
+            return {name: self._stages[name].to_dict() for name in sorted(self._stages)}
+    
+    def summary_lines(self) -> List[str]:
+        """Get one human readable line per stage, slowest total first."""
+        stages = self.snapshot()
+        lines = []
+        for name, stats in sorted(stages.items(), key=lambda item: item[1]['total_ms'], reverse=True):
+            lines.append(f"{name:<28} {stats['count']:>7} calls  total {stats['total_ms'] / 1000:8.2f}s  "
+                         f"mean {stats['mean_ms']:8.3f}ms  p50 {stats['p50_ms']:8.3f}ms  "
+                         f"p95 {stats['p95_ms']:8.3f}ms  max {stats['max_ms']:8.3f}ms")
+        return lines
+    
+    def log_summary(self, title: str) -> None:
+        """
+        Log summary_lines() under a title.
+        
+        Args:
+            title: First line, e.g. "Stage timings:"
+        """
+        logger = get_logger()
+        logger.info(title)
+        for line in self.summary_lines():
+            logger.info(f"  {line}")
+    
+    def export_trace(self, path: str) -> bool:
+        """
+        Write the recorded spans as a Chrome trace (chrome://tracing, ui.perfetto.dev).
+        
+        Args:
+            path: Output JSON path
+        
+        Returns:
+            True if a trace was written
+        """
+        with self._lock:
+            events = list(self._events)
+            threads = dict(self._threads)
+            origin_ns = self._origin_ns
+        if not self.trace:
+            get_logger().warning("Profiler was started without tracing; no trace to export")
+            return False
+        
+        pid = os.getpid()
+        trace_events = [{'name': 'thread_name', 'ph': 'M', 'pid': pid, 'tid': thread_id,
+                         'args': {'name': thread_name}} for thread_id, thread_name in threads.items()]
+        for name, start_ns, duration_ns, thread_id in events:
+            trace_events.append({
+                'name': name,
+                'cat': name.split('.', 1)[0],
+                'ph': 'X',
+                'ts': (start_ns - origin_ns) / 1000.0,
+                'dur': duration_ns / 1000.0,
+                'pid': pid,
+                'tid': thread_id,
+            })
+        try:
+            with open(path, 'w') as f:
+                json.dump({'traceEvents': trace_events, 'displayTimeUnit': 'ms'}, f)
+        except OSError as e:
+            get_logger().error(f"Error writing trace {path}: {e}")
+            return False
+        if self.dropped_events:
+            get_logger().warning(f"Trace is missing {self.dropped_events} events past the "
+                                 f"{self.max_trace_events} event limit")
+        return True
+
+
+# Profiler receiving spans, None while profiling is disabled
+_active: Optional[Profiler] = None
+
+
+def span(name: str):
+    """
+    Time the enclosed block as a stage of the active profiler.
+    
+    While profiling is disabled this returns a shared no-op context, so an
+    instrumented stage costs one function call.
+    
+    Args:
+        name: Stage name; dots group stages ('background.video_seek')
+    
+    Returns:
+        Context manager
+    """
+    profiler = _active
+    if profiler is None:
+        return _NULL_SPAN
+    return _Span(profiler, name)
+
+
+def enable(trace: bool = False) -> Profiler:
+    """
+    Start profiling, keeping the timings collected so far if already enabled.
+    
+    Args:
+        trace: Record trace events for export_trace()
+    
+    Returns:
+        Active profiler
+    """
+    global _active
+    if _active is None:
+        _active = Profiler(trace=trace)
+    elif trace:
+        _active.trace = True
+    return _active
+
+
+def disable() -> None:
+    """Stop profiling; spans become no-ops."""
+    global _active
+    _active = None
+
+
+def get_profiler() -> Optional[Profiler]:
+    """Get the active profiler, or None while profiling is disabled."""
+    return _active
+
+
+def configure(settings: Dict[str, Any]) -> Optional[Profiler]:
+    """
+    Enable or disable profiling to match the profiling_enabled setting.
+    
+    Tracing follows profile_trace_path each time, so a later render without
+    a trace path stops recording trace events.
+    
+    Args:
+        settings: Settings dictionary
+    
+    Returns:
+        Active profiler, or None when profiling is off
+    """
+    if not settings.get('profiling_enabled', False):
+        disable()
+        return None
+    active = enable()
+    active.trace = bool(settings.get('profile_trace_path', ''))
+    return active
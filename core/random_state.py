@@ -0,0 +1,25 @@
+"""
+Deterministic random state module for MP3 Spectrum Visualizer.
+Derives independent random generators from (seed, stream, frame number) so that
+any frame can be rendered in any process and still produce identical output.
+"""
+
+import zlib
+
+import numpy as np
+
+
+def frame_rng(seed: int, frame_number: int, stream: str) -> np.random.Generator:
+    """
+    Get the random generator for one frame of one random stream.
+
+    Args:
+        seed: Render seed (from settings)
+        frame_number: Frame number (0-indexed)
+        stream: Name of the consumer (e.g. 'snow_overlay'), keeps streams independent
+
+    Returns:
+        NumPy random Generator seeded for this frame
+    """
+    stream_id = zlib.crc32(stream.encode('utf-8'))
+    return np.random.default_rng([int(seed) & 0xFFFFFFFF, stream_id, max(0, int(frame_number))])
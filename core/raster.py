@@ -0,0 +1,337 @@
+"""
+Raster kernel module for MP3 Spectrum Visualizer.
+Draws whole arrays of anti-aliased rectangles, rounded rectangles, discs and
+thick lines straight into RGBA NumPy buffers, compiled with numba.
+
+Shapes use pixel edge coordinates: pixel (x, y) covers [x, x + 1) x [y, y + 1),
+so the ImageDraw box [x0, y0, x1, y1] is (x0, y0, x1 + 1, y1 + 1) here and a
+line through pixel (x, y) passes through (x + 0.5, y + 0.5). Edge coverage falls
+off over one pixel of signed distance, so rectangles on whole pixels come out
+exactly like ImageDraw fills while curves and diagonals are smoothed.
+"""
+
+from typing import Optional, Tuple
+
+import numpy as np
+
+from core.layers import Box
+
+try:
+    import numba
+except ImportError:  # Same kernels as vectorized NumPy per shape, slower
+    numba = None
+
+# Kernels are compiled to machine code
+JIT = numba is not None
+
+
+def _jit(function):
+    """Compile a kernel with numba when it is installed."""
+    if numba is None:
+        return function
+    return numba.njit(cache=True, nogil=True)(function)
+
+
+@_jit
+def _span(low, high, origin, size):
+    """Pixel index range [start, stop) of a buffer touched by [low, high] in frame coordinates."""
+    start = max(int(np.floor(low)) - origin, 0)
+    stop = min(int(np.ceil(high)) - origin, size)
+    return start, stop
+
+
+@_jit
+def _rect_coverage(u, v, left, top, right, bottom, top_radius, bottom_radius):
+    """Coverage of pixels centered at (u, v) by a rectangle with rounded top/bottom corners."""
+    half_width = (right - left) * 0.5
+    half_height = (bottom - top) * 0.5
+    center_x = left + half_width
+    center_y = top + half_height
+    radius = bottom_radius + (top_radius - bottom_radius) * (v < center_y)
+    radius = np.minimum(radius, np.minimum(half_width, half_height))
+    
+    # Signed distance to the rounded box
+    qx = np.abs(u - center_x) - (half_width - radius)
+    qy = np.abs(v - center_y) - (half_height - radius)
+    outside_x = np.maximum(qx, 0.0)
+    outside_y = np.maximum(qy, 0.0)
+    distance = (np.sqrt(outside_x * outside_x + outside_y * outside_y)
+                + np.minimum(np.maximum(qx, qy), 0.0) - radius)
+    return np.minimum(np.maximum(0.5 - distance, 0.0), 1.0)
+
+
+@_jit
+def _segment_coverage(u, v, x0, y0, x1, y1, half_width):
+    """Coverage of pixels centered at (u, v) by a line segment with round caps."""
+    dx = x1 - x0
+    dy = y1 - y0
+    length2 = np.maximum(dx * dx + dy * dy, 1e-12)
+    t = np.minimum(np.maximum(((u - x0) * dx + (v - y0) * dy) / length2, 0.0), 1.0)
+    ex = u - x0 - t * dx
+    ey = v - y0 - t * dy
+    distance = np.sqrt(ex * ex + ey * ey) - half_width
+    return np.minimum(np.maximum(0.5 - distance, 0.0), 1.0)
+
+
+@_jit
+def _over(source_alpha, destination_alpha, coverage):
+    """
+    Source-over weights of straight (non-premultiplied) alpha.
+    
+    Returns:
+        (output alpha 0-255, source color weight, destination color weight)
+    """
+    sa = source_alpha * coverage / 255.0
+    da = destination_alpha / 255.0
+    out = sa + da * (1.0 - sa)
+    safe = np.maximum(out, 1e-6)
+    return out * 255.0, sa / safe, da * (1.0 - sa) / safe
+
+
+@_jit
+def _blend_pixel(pixels, y, x, color, coverage):
+    """Blend a color over one pixel."""
+    if coverage >= 1.0 and color[3] == 255:
+        for c in range(4):
+            pixels[y, x, c] = color[c]
+        return
+    alpha, source_weight, destination_weight = _over(color[3], pixels[y, x, 3], coverage)
+    for c in range(3):
+        pixels[y, x, c] = int(color[c] * source_weight + pixels[y, x, c] * destination_weight + 0.5)
+    pixels[y, x, 3] = int(alpha + 0.5)
+
+
+def _blend_numpy(pixels, py, px, color, coverage):
+    """Blend a color over the pixels at (py, px) (no index may repeat)."""
+    destination = pixels[py, px].astype(np.float64)
+    alpha, source_weight, destination_weight = _over(float(color[3]), destination[:, 3], coverage)
+    destination[:, :3] = (color[:3].astype(np.float64)[None, :] * source_weight[:, None]
+                          + destination[:, :3] * destination_weight[:, None])
+    destination[:, 3] = alpha
+    pixels[py, px] = (destination + 0.5).astype(np.uint8)
+
+
+@_jit
+def _fill_rects_kernel(pixels, boxes, top_radius, bottom_radius, colors, origin_x, origin_y):
+    """Compiled fill_rects(): one pass over the pixels of every box."""
+    height = pixels.shape[0]
+    width = pixels.shape[1]
+    for i in range(boxes.shape[0]):
+        left, top, right, bottom = boxes[i, 0], boxes[i, 1], boxes[i, 2], boxes[i, 3]
+        x_start, x_stop = _span(left, right, origin_x, width)
+        y_start, y_stop = _span(top, bottom, origin_y, height)
+        for y in range(y_start, y_stop):
+            v = y + origin_y + 0.5
+            for x in range(x_start, x_stop):
+                coverage = _rect_coverage(x + origin_x + 0.5, v, left, top, right, bottom,
+                                          top_radius[i], bottom_radius[i])
+                if coverage > 0.0:
+                    _blend_pixel(pixels, y, x, colors[i], coverage)
+
+
+def _fill_rects_numpy(pixels, boxes, top_radius, bottom_radius, colors, origin_x, origin_y):
+    """NumPy fill_rects(): one vectorized pass per box."""
+    height, width = pixels.shape[:2]
+    for i in range(boxes.shape[0]):
+        left, top, right, bottom = boxes[i]
+        x_start, x_stop = _span(left, right, origin_x, width)
+        y_start, y_stop = _span(top, bottom, origin_y, height)
+        if x_start >= x_stop or y_start >= y_stop:
+            continue
+        u = np.arange(x_start, x_stop) + origin_x + 0.5
+        v = np.arange(y_start, y_stop) + origin_y + 0.5
+        coverage = _rect_coverage(u[None, :], v[:, None], left, top, right, bottom,
+                                  top_radius[i], bottom_radius[i])
+        py, px = np.nonzero(coverage > 0.0)
+        _blend_numpy(pixels, py + y_start, px + x_start, colors[i], coverage[py, px])
+
+
+@_jit
+def _draw_lines_kernel(pixels, segments, half_width, colors, origin_x, origin_y):
+    """
+    Compiled draw_lines(): walks each segment along its major axis and covers
+    only the band of pixels around it, so cost grows with length times width.
+    """
+    reach = half_width + 1.0
+    for i in range(segments.shape[0]):
+        x0, y0, x1, y1 = segments[i, 0], segments[i, 1], segments[i, 2], segments[i, 3]
+        steep = abs(y1 - y0) > abs(x1 - x0)
+        if steep:
+            a0, b0, a1, b1 = y0, x0, y1, x1
+            major_origin, minor_origin = origin_y, origin_x
+            major_size, minor_size = pixels.shape[0], pixels.shape[1]
+        else:
+            a0, b0, a1, b1 = x0, y0, x1, y1
+            major_origin, minor_origin = origin_x, origin_y
+            major_size, minor_size = pixels.shape[1], pixels.shape[0]
+        da = a1 - a0
+        db = b1 - b0
+        length = np.sqrt(da * da + db * db)
+        # Minor-axis half extent of the line band, at least the cap radius
+        extent = reach * max(length / max(abs(da), 1e-12), 1.0)
+        
+        a_start, a_stop = _span(min(a0, a1) - reach, max(a0, a1) + reach, major_origin, major_size)
+        for a in range(a_start, a_stop):
+            ua = a + major_origin + 0.5
+            t = (ua - a0) / da if abs(da) > 1e-12 else 0.0
+            center = b0 + min(max(t, 0.0), 1.0) * db
+            b_start, b_stop = _span(center - extent, center + extent, minor_origin, minor_size)
+            for b in range(b_start, b_stop):
+                coverage = _segment_coverage(ua, b + minor_origin + 0.5, a0, b0, a1, b1, half_width)
+                if coverage > 0.0:
+                    if steep:
+                        _blend_pixel(pixels, a, b, colors[i], coverage)
+                    else:
+                        _blend_pixel(pixels, b, a, colors[i], coverage)
+
+
+def _draw_lines_numpy(pixels, segments, half_width, colors, origin_x, origin_y):
+    """NumPy draw_lines(): the same major-axis walk, vectorized per segment."""
+    reach = half_width + 1.0
+    for i in range(segments.shape[0]):
+        x0, y0, x1, y1 = segments[i]
+        steep = abs(y1 - y0) > abs(x1 - x0)
+        if steep:
+            a0, b0, a1, b1 = y0, x0, y1, x1
+            major_origin, minor_origin = origin_y, origin_x
+            major_size, minor_size = pixels.shape[0], pixels.shape[1]
+        else:
+            a0, b0, a1, b1 = x0, y0, x1, y1
+            major_origin, minor_origin = origin_x, origin_y
+            major_size, minor_size = pixels.shape[1], pixels.shape[0]
+        da = a1 - a0
+        db = b1 - b0
+        length = np.sqrt(da * da + db * db)
+        extent = reach * max(length / max(abs(da), 1e-12), 1.0)
+        
+        a_start, a_stop = _span(min(a0, a1) - reach, max(a0, a1) + reach, major_origin, major_size)
+        if a_start >= a_stop:
+            continue
+        a = np.arange(a_start, a_stop)
+        ua = a + major_origin + 0.5
+        t = (ua - a0) / da if abs(da) > 1e-12 else np.zeros_like(ua)
+        center = b0 + np.clip(t, 0.0, 1.0) * db
+        
+        # (len(a), k) grid of the minor-axis pixels around the center line
+        b = (np.floor(center - extent).astype(np.intp) - minor_origin)[:, None] + \
+            np.arange(int(np.ceil(2 * extent)) + 2)[None, :]
+        coverage = _segment_coverage(ua[:, None], b + minor_origin + 0.5, a0, b0, a1, b1, half_width)
+        visible = (b >= 0) & (b < minor_size) & (coverage > 0.0)
+        major = np.broadcast_to(a[:, None], b.shape)[visible]
+        minor = b[visible]
+        if steep:
+            _blend_numpy(pixels, major, minor, colors[i], coverage[visible])
+        else:
+            _blend_numpy(pixels, minor, major, colors[i], coverage[visible])
+
+
+def _per_shape(values, count: int, dtype, columns: int = 0) -> np.ndarray:
+    """Broadcast a scalar/single value or per-shape array to one contiguous row per shape."""
+    values = np.asarray(values, dtype=dtype)
+    shape = (count, columns) if columns else (count,)
+    if columns:
+        values = values.reshape(-1, columns)
+    return np.ascontiguousarray(np.broadcast_to(values, shape))
+
+
+def fill_rects(pixels: np.ndarray, boxes: np.ndarray, colors: np.ndarray,
+               top_radius=0.0, bottom_radius=0.0, origin: Tuple[int, int] = (0, 0)) -> None:
+    """
+    Fill many rectangles, optionally with rounded corners, in one kernel call.
+    
+    Colors are blended source-over, so later rectangles cover earlier ones.
+    
+    Args:
+        pixels: (height, width, 4) uint8 RGBA array, modified in place
+        boxes: (N, 4) left, top, right, bottom pixel edge coordinates
+        colors: (N, 4) or (4,) RGBA colors
+        top_radius: Radius of the two top corners, scalar or per rectangle
+        bottom_radius: Radius of the two bottom corners, scalar or per rectangle
+        origin: Frame position of pixels[0, 0] when drawing into a region
+    """
+    boxes = np.ascontiguousarray(boxes, dtype=np.float64).reshape(-1, 4)
+    count = len(boxes)
+    if count == 0:
+        return
+    kernel = _fill_rects_kernel if JIT else _fill_rects_numpy
+    kernel(pixels, boxes, _per_shape(top_radius, count, np.float64),
+           _per_shape(bottom_radius, count, np.float64), _per_shape(colors, count, np.uint8, 4),
+           int(origin[0]), int(origin[1]))
+
+
+def fill_discs(pixels: np.ndarray, x: np.ndarray, y: np.ndarray, radii, colors: np.ndarray,
+               origin: Tuple[int, int] = (0, 0)) -> None:
+    """
+    Fill many discs in one kernel call.
+    
+    Args:
+        pixels: (height, width, 4) uint8 RGBA array, modified in place
+        x: Center x positions (pixel edge coordinates)
+        y: Center y positions (pixel edge coordinates)
+        radii: Radius, scalar or per disc
+        colors: (N, 4) or (4,) RGBA colors
+        origin: Frame position of pixels[0, 0] when drawing into a region
+    """
+    x = np.asarray(x, dtype=np.float64)
+    y = np.asarray(y, dtype=np.float64)
+    radii = _per_shape(radii, len(x), np.float64)
+    fill_rects(pixels, np.stack([x - radii, y - radii, x + radii, y + radii], axis=1), colors,
+               top_radius=radii, bottom_radius=radii, origin=origin)
+
+
+def draw_lines(pixels: np.ndarray, segments: np.ndarray, width: float, colors: np.ndarray,
+               origin: Tuple[int, int] = (0, 0)) -> None:
+    """
+    Draw many thick line segments with round caps in one kernel call.
+    
+    Args:
+        pixels: (height, width, 4) uint8 RGBA array, modified in place
+        segments: (N, 4) x0, y0, x1, y1 pixel edge coordinates
+        width: Line width in pixels
+        colors: (N, 4) or (4,) RGBA colors
+        origin: Frame position of pixels[0, 0] when drawing into a region
+    """
+    segments = np.ascontiguousarray(segments, dtype=np.float64).reshape(-1, 4)
+    count = len(segments)
+    if count == 0:
+        return
+    kernel = _draw_lines_kernel if JIT else _draw_lines_numpy
+    kernel(pixels, segments, float(width) * 0.5, _per_shape(colors, count, np.uint8, 4),
+           int(origin[0]), int(origin[1]))
+
+
+def rects_box(boxes: np.ndarray, margin: float = 0.0) -> Optional[Box]:
+    """
+    Get the box that rectangles can draw into.
+    
+    Args:
+        boxes: (N, 4) left, top, right, bottom pixel edge coordinates
+        margin: Extra pixels around every rectangle
+    
+    Returns:
+        Unclipped (left, top, right, bottom) box, or None when there are no rectangles
+    """
+    boxes = np.asarray(boxes, dtype=np.float64).reshape(-1, 4)
+    if len(boxes) == 0:
+        return None
+    return (int(np.floor(boxes[:, 0].min() - margin)), int(np.floor(boxes[:, 1].min() - margin)),
+            int(np.ceil(boxes[:, 2].max() + margin)), int(np.ceil(boxes[:, 3].max() + margin)))
+
+
+def lines_box(segments: np.ndarray, width: float) -> Optional[Box]:
+    """
+    Get the box that line segments can draw into.
+    
+    Args:
+        segments: (N, 4) x0, y0, x1, y1 pixel edge coordinates
+        width: Line width in pixels
+    
+    Returns:
+        Unclipped (left, top, right, bottom) box, or None when there are no segments
+    """
+    segments = np.asarray(segments, dtype=np.float64).reshape(-1, 4)
+    if len(segments) == 0:
+        return None
+    xs = segments[:, 0::2]
+    ys = segments[:, 1::2]
+    return rects_box([[xs.min(), ys.min(), xs.max(), ys.max()]], margin=float(width) * 0.5 + 1.0)
@@ -0,0 +1,167 @@
+"""
+Render plan module for MP3 Spectrum Visualizer.
+Compiles the settings of a render once into an immutable plan: the ordered
+frame stages that can change the output, their resolved parameters and
+whether each one yields the same result for every frame.
+"""
+
+import os
+from dataclasses import dataclass
+from typing import Any, Dict, Optional, Tuple
+
+Color = Tuple[int, int, int]
+
+# Beat effects that move the layers / blend a color over the frame
+BEAT_TRANSFORMS = ('pulse', 'zoom')
+BEAT_COLOR_FLASHES = ('flash', 'strobe')
+
+# Background animations apply_background_animation() implements
+BACKGROUND_ANIMATIONS = ('fade_in',)
+
+
+@dataclass(frozen=True)
+class Stage:
+    """One active stage of a frame, in compositing order."""
+    name: str  # 'background', 'visualizer', 'color_flash', 'overlay', 'text' or 'logo'
+    static: bool  # Same output for every frame
+
+
+@dataclass(frozen=True)
+class RenderPlan:
+    """
+    Settings of a render resolved for the frame loop.
+    
+    Stages that cannot change a frame (no text, zero opacity, strobe without
+    a color source, ...) are left out of stages. The plan is hashable and
+    small, so worker processes receive it pickled instead of recompiling it.
+    """
+    random_seed: int
+    beat_effect: Optional[str]  # 'pulse', 'zoom', 'flash' or 'strobe'; None without beat sync
+    beat_color: Color  # Color of the 'flash'/'strobe' beat effect
+    background_static: bool  # The loaded background image is the same for every frame
+    background_bw: bool  # Video background effects
+    background_blur: float
+    vignette_intensity: float
+    shake_intensity: int  # Background beat shake; 0 when off
+    background_animation: Optional[str]  # One of BACKGROUND_ANIMATIONS, or None
+    background_opacity: int
+    visualizer_enabled: bool  # Visualizer layer is rendered (synced with the preview's layer cache)
+    visualizer_opacity: int
+    audio_strobe_color: Optional[Color]  # Spectrum-driven strobe without beat sync
+    overlay_opacity: int
+    text: Optional[Tuple[str, str, Color]]  # (text, position, color)
+    logo_path: str  # Logo image path ('' for a text logo)
+    yuv_full_range: bool
+    stages: Tuple[Stage, ...]
+    
+    @classmethod
+    def from_settings(cls, settings: Dict[str, Any], background_static: bool,
+                      has_overlay: bool) -> 'RenderPlan':
+        """
+        Compile a plan from settings.
+        
+        Args:
+            settings: Settings dictionary
+            background_static: Whether the background source yields one image
+                               (no video, no slideshow)
+            has_overlay: Whether an overlay effect (rain, snow, ...) was created
+        
+        Returns:
+            Render plan
+        """
+        beat_effect = None
+        beat_color = (255, 255, 255)
+        if settings.get('beat_sync_enabled', False):
+            effect = settings.get('beat_effect_type', 'pulse')
+            if effect in BEAT_TRANSFORMS or effect in BEAT_COLOR_FLASHES:
+                beat_effect = effect
+            if effect == 'flash':
+                beat_color = tuple(settings.get('beat_flash_color', [255, 255, 255]))
+            elif effect == 'strobe':
+                beat_color = tuple(settings.get('beat_strobe_color', [255, 255, 255]))
+        
+        shake_intensity = 0
+        if settings.get('background_beat_shake_enabled', False):
+            shake_intensity = int(settings.get('background_beat_shake_intensity', 50))
+        
+        animation = settings.get('background_animation', 'none')
+        if animation not in BACKGROUND_ANIMATIONS:
+            animation = None
+        
+        audio_strobe_color = None
+        if settings.get('strobe_enabled', False) and not settings.get('beat_sync_enabled', False):
+            audio_strobe_color = tuple(settings.get('strobe_color', [255, 255, 255]))
+        
+        text = None
+        text_overlay = settings.get('text_overlay', '')
+        if text_overlay and settings.get('text_opacity', 100) > 0:
+            text = (text_overlay, settings.get('text_position', 'center'),
+                    tuple(settings.get('text_color', [255, 255, 255])))
+        
+        logo_path = settings.get('logo_path', '')
+        has_logo = settings.get('logo_opacity', 100) > 0 and (
+            bool(settings.get('logo_text', '')) or bool(logo_path and os.path.exists(logo_path)))
+        
+        background_static = background_static and shake_intensity == 0
+        visualizer_enabled = settings.get('visualizer_enabled', True)
+        visualizer_opacity = settings.get('visualizer_opacity', 100)
+        overlay_opacity = settings.get('overlay_opacity', 100)
+        
+        # Ordered like the compositor applies them
+        stages = [Stage('background', background_static and animation is None and
+                        beat_effect not in BEAT_TRANSFORMS)]
+        if visualizer_enabled and visualizer_opacity > 0:
+            stages.append(Stage('visualizer', False))
+        if beat_effect in BEAT_COLOR_FLASHES or audio_strobe_color is not None:
+            stages.append(Stage('color_flash', False))
+        if has_overlay and overlay_opacity > 0:
+            stages.append(Stage('overlay', False))
+        if text is not None:
+            stages.append(Stage('text', True))
+        if has_logo:
+            stages.append(Stage('logo', True))
+        
+        return cls(
+            random_seed=settings.get('random_seed', 0),
+            beat_effect=beat_effect,
+            beat_color=beat_color,
+            background_static=background_static,
+            background_bw=bool(settings.get('background_bw', False)),
+            background_blur=settings.get('background_blur', 0),
+            vignette_intensity=settings.get('vignette_intensity', 0),
+            shake_intensity=shake_intensity,
+            background_animation=animation,
+            background_opacity=settings.get('background_opacity', 100),
+            visualizer_enabled=visualizer_enabled,
+            visualizer_opacity=visualizer_opacity,
+            audio_strobe_color=audio_strobe_color,
+            overlay_opacity=overlay_opacity,
+            text=text,
+            logo_path=logo_path if has_logo else '',
+            yuv_full_range=settings.get('yuv_range', 'limited') == 'full',
+            stages=tuple(stages),
+        )
+    
+    @property
+    def folded_stages(self) -> int:
+        """
+        Number of leading static stages that fold into one cached base frame.
+        
+        Every frame starts from the base instead of running them again; 0 when
+        the background changes between frames.
+        """
+        count = 0
+        for stage in self.stages:
+            if not stage.static:
+                break
+            count += 1
+        return count
+    
+    @property
+    def needs_beats(self) -> bool:
+        """Whether any stage reads the per-frame beat strength."""
+        return self.beat_effect is not None or self.shake_intensity > 0
+    
+    def has_stage(self, name: str) -> bool:
+        """Check whether a stage is active."""
+        return any(stage.name == name for stage in self.stages)
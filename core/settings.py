@@ -36,14 +36,36 @@ class SettingsManager:
         'frame_rate': 30,
         'visualizer_enabled': True,
         'visualizer_style': 'filled_waveform',
+        'band_layout': 'squared_log',  # frequency band spacing: squared_log, linear, log, mel
         'color_gradient': 'pitch_rainbow',
         'orientation': 'landscape_16_9',
         'resolution': '1080p',
         # Performance settings
         'quality_preset': 'fast',  # fast, balanced, high
         'use_hardware_acceleration': True,
+        'hardware_encoder': 'auto',  # auto (first working of nvenc, qsv, vaapi, videotoolbox), or one of them
+        'video_codec': 'h264',  # h264, hevc, av1
+        'vaapi_device': '/dev/dri/renderD128',  # DRM render node used by the VAAPI encoder
+        'yuv_range': 'limited',  # BT.709 range of streamed frames: limited (16-235, players expect this), full (0-255)
         'encoding_preset': 'ultrafast',  # ultrafast, fast, medium, slow
         'use_multiprocessing': True,
+        'render_workers': 0,  # worker processes for parallel rendering (0 = auto)
+        'parallel_chunk_frames': 48,  # contiguous frames rendered per worker task
+        'random_seed': 0,  # seed for particles/overlays/shake; same seed = identical renders
+        'output_mode': 'pipe',  # pipe (stream raw frames to ffmpeg), png (debug: temp PNG frames)
+        'render_backend': 'cpu',  # cpu (PIL/NumPy reference), gpu (OpenGL offscreen via moderngl, falls back to cpu)
+        'analysis_cache_enabled': True,  # reuse spectrum/beat analysis of previously rendered tracks
+        'analysis_cache_dir': '',  # empty = ~/.cache/mp3tovideo/analysis
+        'streaming_analysis_seconds': 1200,  # analyze longer tracks in blocks while rendering starts (0 = never)
+        'batch_workers': 0,  # jobs rendered at once by main.py --batch (0 = half the CPU cores)
+        'distributed_nodes': [],  # commands starting main.py on worker nodes (empty = local processes)
+        'segment_seconds': 60,  # length of the segments of a distributed render
+        'segment_gop_frames': 0,  # keyframe interval of segments (0 = 2 seconds)
+        'cache_budget_mb': 512,  # memory shared by cached backgrounds, logo and video frames
+        'video_decode_ahead_frames': 16,  # decoded video background frames buffered ahead of rendering
+        'pipeline_queue_size': 4,  # frames queued between streaming pipeline stages (bounds memory, sets backpressure)
+        'profiling_enabled': False,  # time each render/analysis stage and log per-stage histograms
+        'profile_trace_path': '',  # also write a Chrome/Perfetto trace of the stages here (empty = no trace)
         'beat_sync_enabled': False,
         'video_background_path': '',
         'background_type': 'solid_color',
@@ -62,6 +84,7 @@ class SettingsManager:
         'slideshow_transition': 'fade',
         'transition_duration': 1.0,
         'auto_adjust_slideshow': False,
+        'slideshow_prefetch_enabled': True,  # load the next slide on a background thread while the current one is shown
         # Beat shake
         'background_beat_shake_enabled': False,
         'background_beat_shake_intensity': 50,
@@ -69,7 +92,8 @@ class SettingsManager:
         'overlay_effect_type': 'none',  # none, rain, snow, sparkles, bubbles
         'overlay_video_path': '',
         # Preview settings
-        'fast_preview': True  # Enable fast preview mode by default (3s preview)
+        'fast_preview': True,  # Enable fast preview mode by default (3s preview)
+        'preview_buffer_frames': 60  # Frames rendered ahead of the playhead in the streamed full preview
     }
     
     def __init__(self, settings_file: str = 'settings.json'):
@@ -0,0 +1,238 @@
+"""
+Slideshow module for MP3 Spectrum Visualizer.
+Schedules slideshow backgrounds on the render timeline: the next slide is
+loaded and processed on a background thread while the current one is shown,
+only the slides on screen stay decoded, and transitions blend into reused
+buffers.
+"""
+
+import threading
+from typing import Callable, Dict, List, NamedTuple, Optional, Tuple
+
+import cv2
+import numpy as np
+from PIL import Image
+
+from core.effects import scale_matrix, warp_affine
+from core.logger import get_logger
+from core import profiler
+
+
+class Slide(NamedTuple):
+    """A decoded slide at output resolution."""
+    image: Image.Image  # Returned as is while the slide is shown alone
+    pixels: np.ndarray  # (height, width, 3) uint8 copy transitions blend from
+
+
+class SlideshowScheduler:
+    """
+    Maps frames to slides and keeps the current and next slide decoded.
+    
+    Slide i is shown for slideshow_interval seconds, then blends into slide
+    i + 1 for transition_duration seconds. When a slide comes on screen the
+    following one is queued for the prefetch thread, so sequential rendering
+    never waits for a decode; random access (preview scrubbing) loads the
+    requested slides directly.
+    """
+    
+    def __init__(self, paths: List[str], load: Callable[[str], Image.Image], frame_rate: int,
+                 interval: float, transition_duration: float, transition_type: str,
+                 size: Tuple[int, int], prefetch: bool = True):
+        """
+        Initialize scheduler.
+        
+        Args:
+            paths: Slide image paths in display order
+            load: Function loading a path as a processed RGB image of the output size
+            frame_rate: Frame rate
+            interval: Seconds each slide is shown alone
+            transition_duration: Seconds of each transition
+            transition_type: 'fade', 'crossfade', 'slide', 'zoom' or 'instant'
+            size: Output size (width, height)
+            prefetch: Load the next slide on a background thread
+        """
+        self.paths = list(paths)
+        self.frame_rate = frame_rate
+        self.interval = interval
+        self.transition_duration = transition_duration
+        self.transition_type = transition_type
+        self.size = tuple(size)
+        self.prefetch = prefetch
+        self._load = load
+        self._slides: Dict[int, Slide] = {}  # At most the current and next slide
+        self._keep: Tuple[int, ...] = ()
+        self._queued: Optional[int] = None  # Slide waiting for the prefetch thread
+        self._loading: Optional[int] = None  # Slide the prefetch thread is loading
+        self._stopped = False
+        self._cond = threading.Condition()
+        self._thread: Optional[threading.Thread] = None
+        width, height = self.size
+        self._blend = np.empty((height, width, 3), dtype=np.uint8)  # Reused transition buffers
+        self._zoom = np.empty((height, width, 3), dtype=np.uint8)
+    
+    def slide_at(self, frame_number: int) -> Tuple[int, int, Optional[float]]:
+        """
+        Locate a frame on the slideshow timeline.
+        
+        Args:
+            frame_number: Frame number
+        
+        Returns:
+            (slide index, next slide index, transition progress 0.0-1.0 or None
+            while the slide is shown alone)
+        """
+        time_seconds = frame_number / self.frame_rate
+        total_interval = self.interval + self.transition_duration
+        cycle_position = time_seconds % total_interval
+        
+        index = int(time_seconds / total_interval) % len(self.paths)
+        next_index = (index + 1) % len(self.paths)
+        if cycle_position >= self.interval:
+            return index, next_index, (cycle_position - self.interval) / self.transition_duration
+        return index, next_index, None
+    
+    def frame(self, frame_number: int) -> Image.Image:
+        """
+        Get the background of a frame.
+        
+        Args:
+            frame_number: Frame number
+        
+        Returns:
+            The current slide's image (shared; consumers derive new images from
+            it) or a new image mid-transition
+        """
+        index, next_index, progress = self.slide_at(frame_number)
+        current = self._get(index, (index, next_index))
+        if self.prefetch:
+            self._queue(next_index)
+        if progress is None:
+            return current.image
+        
+        upcoming = self._get(next_index, (index, next_index))
+        with profiler.span('background.transition'):
+            return self._transition(current, upcoming, progress)
+    
+    def close(self) -> None:
+        """Stop the prefetch thread and release the decoded slides."""
+        with self._cond:
+            self._stopped = True
+            self._slides.clear()
+            self._cond.notify_all()
+        if self._thread is not None:
+            self._thread.join(timeout=5)
+            self._thread = None
+    
+    def _get(self, index: int, keep: Tuple[int, ...]) -> Slide:
+        """
+        Get a decoded slide, evicting slides outside keep.
+        
+        Args:
+            index: Slide index
+            keep: Slide indices that stay decoded
+        
+        Returns:
+            Slide
+        """
+        with self._cond:
+            if keep != self._keep:
+                self._keep = keep
+                for stale in [i for i in self._slides if i not in keep]:
+                    del self._slides[stale]
+            if index not in self._slides and index == self._loading:
+                # Prefetch is running behind; finishing it beats starting over
+                with profiler.span('background.slide_wait'):
+                    self._cond.wait_for(lambda: index != self._loading or self._stopped)
+            slide = self._slides.get(index)
+            if slide is not None:
+                return slide
+            if self._queued == index:
+                self._queued = None
+        
+        slide = self._decode(index)
+        with self._cond:
+            if index in self._keep and not self._stopped:
+                self._slides[index] = slide
+        return slide
+    
+    def _queue(self, index: int) -> None:
+        """Hand a slide to the prefetch thread unless it is decoded or loading."""
+        with self._cond:
+            if self._stopped or index in self._slides or index in (self._loading, self._queued):
+                return
+            self._queued = index
+            if self._thread is None:
+                self._thread = threading.Thread(target=self._prefetch_loop, name='slideshow-prefetch',
+                                                daemon=True)
+                self._thread.start()
+            self._cond.notify_all()
+    
+    def _prefetch_loop(self) -> None:
+        """Prefetch thread: load queued slides until closed."""
+        while True:
+            with self._cond:
+                self._cond.wait_for(lambda: self._queued is not None or self._stopped)
+                if self._stopped:
+                    return
+                index = self._queued
+                self._queued = None
+                self._loading = index
+            
+            slide = None
+            try:
+                slide = self._decode(index)
+            except Exception as e:
+                get_logger().error(f"Error prefetching slide {self.paths[index]}: {e}", exc_info=True)
+            finally:
+                with self._cond:
+                    # A slide the timeline moved past is dropped right away
+                    if slide is not None and index in self._keep and not self._stopped:
+                        self._slides[index] = slide
+                    self._loading = None
+                    self._cond.notify_all()
+    
+    def _decode(self, index: int) -> Slide:
+        """Load and process a slide at output resolution."""
+        with profiler.span('background.slide_decode'):
+            image = self._load(self.paths[index])
+            if image.mode != 'RGB':
+                image = image.convert('RGB')
+            if image.size != self.size:
+                image = image.resize(self.size, Image.Resampling.LANCZOS)
+            return Slide(image, np.array(image))
+    
+    def _transition(self, current: Slide, upcoming: Slide, progress: float) -> Image.Image:
+        """
+        Blend two slides into the reused buffer.
+        
+        Args:
+            current: Slide being left
+            upcoming: Slide coming in
+            progress: Transition progress (0.0 to 1.0)
+        
+        Returns:
+            Transitioned image
+        """
+        if progress <= 0:
+            return current.image
+        if progress >= 1:
+            return upcoming.image
+        
+        out = self._blend
+        if self.transition_type == 'slide':
+            # Slide left: the upcoming slide pushes the current one out
+            offset = int(self.size[0] * progress)
+            out[:, :self.size[0] - offset] = current.pixels[:, offset:]
+            out[:, self.size[0] - offset:] = upcoming.pixels[:, :offset]
+        elif self.transition_type == 'zoom':
+            # Current slide enlarges about the center while the upcoming one fades in
+            zoomed = warp_affine(current.pixels, scale_matrix(self.size, 1.0 + progress), self.size,
+                                 out=self._zoom)
+            cv2.addWeighted(zoomed, 1.0 - progress, upcoming.pixels, progress, 0.0, dst=out)
+        elif self.transition_type == 'instant':
+            return upcoming.image if progress > 0.5 else current.image
+        else:
+            # 'fade', 'crossfade' and unknown types crossfade
+            cv2.addWeighted(current.pixels, 1.0 - progress, upcoming.pixels, progress, 0.0, dst=out)
+        # The image owns a copy, so the buffer is free for the next frame
+        return Image.fromarray(out)
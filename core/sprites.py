@@ -0,0 +1,132 @@
+"""
+Overlay sprite module for MP3 Spectrum Visualizer.
+Pre-renders static overlays (text, logos) into cropped premultiplied sprites
+that are blended onto each frame over their bounding box only.
+"""
+
+from functools import lru_cache
+from typing import Tuple
+
+import numpy as np
+from PIL import Image, ImageFont
+
+
+@lru_cache(maxsize=16)
+def load_font(size: int) -> ImageFont.ImageFont:
+    """
+    Load the overlay font at a size, falling back to PIL's default font.
+    
+    Args:
+        size: Font size in pixels
+    
+    Returns:
+        PIL font (cached per size)
+    """
+    try:
+        return ImageFont.truetype("/System/Library/Fonts/Helvetica.ttc", size)
+    except Exception:
+        try:
+            return ImageFont.truetype("arial.ttf", size)
+        except Exception:
+            return ImageFont.load_default()
+
+
+class Sprite:
+    """Cropped RGBA overlay stored premultiplied, ready to blend at a fixed position."""
+    
+    def __init__(self, image: Image.Image, position: Tuple[int, int] = (0, 0)):
+        """
+        Build a sprite from an RGBA image, cropped to its visible pixels.
+        
+        Args:
+            image: RGBA image (a full-canvas layer or a smaller image)
+            position: Top-left position of the image on the frame
+        """
+        image = image.convert('RGBA') if image.mode != 'RGBA' else image
+        bbox = image.getchannel('A').getbbox()
+        
+        self.empty = bbox is None
+        if self.empty:
+            self.box = (0, 0, 0, 0)
+            self.premultiplied = np.zeros((0, 0, 3), dtype=np.float32)
+            self.alpha = np.zeros((0, 0, 1), dtype=np.float32)
+            return
+        
+        pixels = np.asarray(image.crop(bbox), dtype=np.float32)
+        self.alpha = pixels[:, :, 3:4] / 255.0
+        self.premultiplied = pixels[:, :, :3] * self.alpha
+        left, top = position[0] + bbox[0], position[1] + bbox[1]
+        self.box = (left, top, left + pixels.shape[1], top + pixels.shape[0])
+    
+    @property
+    def nbytes(self) -> int:
+        """Memory held by the sprite."""
+        return self.premultiplied.nbytes + self.alpha.nbytes
+    
+    def _clip(self, width: int, height: int):
+        """
+        Clip the sprite box to a frame.
+        
+        Args:
+            width: Frame width
+            height: Frame height
+            
+        Returns:
+            (frame_box, sprite_rows, sprite_cols) or None when nothing is visible
+        """
+        if self.empty:
+            return None
+        
+        left, top, right, bottom = self.box
+        clip_left, clip_top = max(left, 0), max(top, 0)
+        clip_right, clip_bottom = min(right, width), min(bottom, height)
+        if clip_left >= clip_right or clip_top >= clip_bottom:
+            return None
+        
+        rows = slice(clip_top - top, clip_bottom - top)
+        cols = slice(clip_left - left, clip_right - left)
+        return (clip_left, clip_top, clip_right, clip_bottom), rows, cols
+    
+    def blend_into(self, canvas: np.ndarray) -> None:
+        """
+        Blend the sprite over an opaque float32 RGB canvas in place.
+        
+        Args:
+            canvas: (height, width, 3) float32 array
+        """
+        clipped = self._clip(canvas.shape[1], canvas.shape[0])
+        if clipped is None:
+            return
+        
+        (left, top, right, bottom), rows, cols = clipped
+        region = canvas[top:bottom, left:right]
+        region *= 1.0 - self.alpha[rows, cols]
+        region += self.premultiplied[rows, cols]
+    
+    def composite(self, image: Image.Image) -> Image.Image:
+        """
+        Blend the sprite over an image in place ("over" operator on the bounding box).
+        
+        Args:
+            image: RGB or RGBA frame (modified in place)
+        
+        Returns:
+            The same image
+        """
+        clipped = self._clip(image.width, image.height)
+        if clipped is None:
+            return image
+        
+        box, rows, cols = clipped
+        alpha = self.alpha[rows, cols]
+        inv_alpha = 1.0 - alpha
+        
+        region = np.asarray(image.crop(box), dtype=np.float32)
+        blended = np.empty_like(region)
+        blended[:, :, :3] = self.premultiplied[rows, cols] + region[:, :, :3] * inv_alpha
+        if region.shape[2] == 4:
+            blended[:, :, 3:4] = alpha * 255.0 + region[:, :, 3:4] * inv_alpha
+        
+        blended += 0.5
+        image.paste(Image.fromarray(blended.astype(np.uint8), image.mode), box)
+        return image
@@ -0,0 +1,420 @@
+"""
+Streaming audio analysis module for MP3 Spectrum Visualizer.
+Decodes a track in blocks and computes per-frame spectrum, bands, intensity
+and onset strength incrementally into memory-mapped analysis cache files, so
+memory stays bounded for any track length and rendering can start while the
+analysis is still running.
+"""
+
+import subprocess
+import threading
+import time
+from typing import Any, Callable, Dict, Iterator, NamedTuple, Optional, Tuple
+
+import ffmpeg
+import librosa
+import numpy as np
+import scipy.fft
+import soundfile as sf
+
+from core import profiler
+from core.audio_processor import AudioProcessor
+from core.frequency_bands import build_band_matrix
+from core.logger import get_logger
+
+
+# Seconds of audio decoded per block
+DECODE_BLOCK_SECONDS = 5
+
+# Onset strength parameters of librosa.onset.onset_strength (and beat_track)
+ONSET_N_FFT = 2048
+ONSET_HOP_LENGTH = 512
+ONSET_TOP_DB = 80.0
+
+# Frames whose intensity needs this many following frames (get_intensity_timeline's window)
+INTENSITY_WINDOW = 10
+
+
+class AudioInfo(NamedTuple):
+    """Stream parameters of an audio file, read without decoding it."""
+    sample_rate: int
+    channels: int
+    num_samples: int  # Exact for soundfile formats, estimated from the duration otherwise
+    reader: str  # 'soundfile' or 'ffmpeg'
+
+
+def probe_audio(path: str) -> Optional[AudioInfo]:
+    """
+    Read sample rate, channels and length of an audio file.
+    
+    Args:
+        path: Audio file path
+    
+    Returns:
+        AudioInfo, or None if neither soundfile nor ffprobe can read the file
+    """
+    try:
+        with sf.SoundFile(path) as f:
+            if f.frames > 0:
+                return AudioInfo(int(f.samplerate), int(f.channels), int(f.frames), 'soundfile')
+    except (RuntimeError, OSError):
+        pass
+    
+    try:
+        probe = ffmpeg.probe(path)
+        stream = next(s for s in probe['streams'] if s.get('codec_type') == 'audio')
+        sample_rate = int(stream['sample_rate'])
+        duration = float(stream.get('duration') or probe['format']['duration'])
+        return AudioInfo(sample_rate, int(stream.get('channels', 1)), int(duration * sample_rate), 'ffmpeg')
+    except (ffmpeg.Error, OSError, StopIteration, KeyError, ValueError) as e:
+        get_logger().warning(f"Cannot probe {path}: {e}")
+        return None
+
+
+def iter_audio_blocks(path: str, info: AudioInfo, block_samples: int) -> Iterator[np.ndarray]:
+    """
+    Decode a file in blocks of mono float32 samples at its native sample rate.
+    
+    Channels are averaged like librosa.load(mono=True).
+    
+    Args:
+        path: Audio file path
+        info: AudioInfo from probe_audio()
+        block_samples: Samples per block (the last block may be shorter)
+    
+    Yields:
+        (samples,) float32 arrays
+    """
+    if info.reader == 'soundfile':
+        with sf.SoundFile(path) as f:
+            while True:
+                block = f.read(block_samples, dtype='float32', always_2d=True)
+                if len(block) == 0:
+                    return
+                yield block.mean(axis=1, dtype=np.float32) if info.channels > 1 else block[:, 0]
+        return
+    
+    command = ['ffmpeg', '-hide_banner', '-loglevel', 'error', '-i', path, '-vn',
+               '-f', 'f32le', '-acodec', 'pcm_f32le', '-ar', str(info.sample_rate), '-']
+    process = subprocess.Popen(command, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    block_bytes = block_samples * info.channels * 4
+    try:
+        while True:
+            data = process.stdout.read(block_bytes)
+            usable = len(data) - len(data) % (info.channels * 4)
+            if usable <= 0:
+                break
+            block = np.frombuffer(data[:usable], dtype=np.float32).reshape(-1, info.channels)
+            yield block.mean(axis=1, dtype=np.float32) if info.channels > 1 else block[:, 0].copy()
+    finally:
+        process.stdout.close()
+        stderr = process.stderr.read().decode(errors='replace')
+        process.stderr.close()
+        if process.wait() != 0 and stderr:
+            get_logger().warning(f"ffmpeg decode of {path}: {stderr.strip()}")
+
+
+class StreamingSTFT:
+    """
+    Centered Hann-window STFT magnitudes over audio fed in blocks.
+    
+    Column i uses the window centered on sample centers(i) of the zero-padded
+    signal, the layout of AudioProcessor's in-memory STFT and of librosa's
+    center=True. Only the samples still needed by later windows are kept.
+    """
+    
+    def __init__(self, n_fft: int, num_columns: int, centers: Callable[[int, int], np.ndarray],
+                 batch_columns: int = 512):
+        """
+        Initialize STFT.
+        
+        Args:
+            n_fft: Window length
+            num_columns: Columns to compute
+            centers: Function(first, last) -> center samples of columns [first, last), non-decreasing
+            batch_columns: Columns per FFT batch (bounds temporary memory)
+        """
+        self.n_fft = n_fft
+        self.num_columns = num_columns
+        self.next_column = 0
+        self._centers = centers
+        self._batch_columns = batch_columns
+        self._window = (0.5 - 0.5 * np.cos(2 * np.pi * np.arange(n_fft) / n_fft)).astype(np.float32)
+        self._offsets = np.arange(n_fft)
+        # Window starts in padded coordinates equal center samples; the pad is n_fft // 2 zeros
+        self._buffer = np.zeros(n_fft // 2, dtype=np.float32)
+        self._buffer_start = 0
+    
+    def feed(self, samples: np.ndarray) -> Iterator[Tuple[int, np.ndarray]]:
+        """
+        Add samples and compute every column whose window is now complete.
+        
+        Args:
+            samples: Next mono float32 samples
+        
+        Yields:
+            (first column, (columns, n_fft // 2 + 1) float32 magnitudes)
+        """
+        if self.next_column >= self.num_columns:
+            return
+        self._buffer = np.concatenate((self._buffer, samples))
+        yield from self._columns()
+    
+    def finish(self) -> Iterator[Tuple[int, np.ndarray]]:
+        """
+        Pad the end of the signal with zeros and compute the remaining columns.
+        
+        Yields:
+            Like feed()
+        """
+        if self.next_column >= self.num_columns:
+            return
+        last_center = int(self._centers(self.num_columns - 1, self.num_columns)[0])
+        missing = last_center + self.n_fft - (self._buffer_start + len(self._buffer))
+        if missing > 0:
+            self._buffer = np.concatenate((self._buffer, np.zeros(missing, dtype=np.float32)))
+        yield from self._columns()
+    
+    def _columns(self) -> Iterator[Tuple[int, np.ndarray]]:
+        buffer_end = self._buffer_start + len(self._buffer)
+        while self.next_column < self.num_columns:
+            first = self.next_column
+            centers = self._centers(first, min(first + self._batch_columns, self.num_columns))
+            available = int(np.searchsorted(centers + self.n_fft, buffer_end, side='right'))
+            if available == 0:
+                break
+            centers = centers[:available]
+            windows = self._buffer[(centers - self._buffer_start)[:, None] + self._offsets]
+            windows *= self._window
+            self.next_column = first + available
+            yield first, np.abs(scipy.fft.rfft(windows, axis=1))
+        
+        # Drop samples before the next window
+        if self.next_column < self.num_columns:
+            keep_from = int(self._centers(self.next_column, self.next_column + 1)[0])
+        else:
+            keep_from = buffer_end
+        if keep_from > self._buffer_start:
+            self._buffer = self._buffer[keep_from - self._buffer_start:]
+            self._buffer_start = keep_from
+
+
+class StreamingAnalysis:
+    """
+    Analyzes a track block by block on a background thread.
+    
+    Spectrum and bands are written straight into memory-mapped files of a
+    pending analysis cache entry; intensity and onset strength are small
+    per-frame columns kept in memory. Frames become readable in order
+    (wait(frame)), so a render can follow the analysis. Beat tracking needs
+    the whole onset envelope and runs when decoding is done.
+    
+    The onset envelope matches librosa.onset.onset_strength except that its
+    80 dB floor is taken below the loudest mel bin seen so far instead of the
+    loudest of the whole track.
+    """
+    
+    def __init__(self, audio_path: str, info: AudioInfo, writer, frame_rate: int,
+                 n_fft: int, num_bands: int, band_layout: str, batch_frames: int = 512):
+        """
+        Initialize analysis; start() runs it.
+        
+        Args:
+            audio_path: Audio file path
+            info: AudioInfo from probe_audio()
+            writer: AnalysisCache entry writer receiving the arrays
+            frame_rate: Video frame rate
+            n_fft: FFT points of the per-frame spectrum
+            num_bands: Number of frequency bands
+            band_layout: Band layout name
+            batch_frames: STFT columns per FFT batch
+        """
+        self.audio_path = audio_path
+        self.info = info
+        self.frame_rate = frame_rate
+        self.n_fft = n_fft
+        self.num_bands = num_bands
+        self.band_layout = band_layout
+        self.sample_rate = info.sample_rate
+        self.duration = info.num_samples / info.sample_rate
+        self.num_frames = int(self.duration * frame_rate)
+        self._writer = writer
+        self._batch_frames = batch_frames
+        
+        n_bins = n_fft // 2 + 1
+        self.spectrum = writer.array('spectrum', (self.num_frames, n_bins), np.float32)
+        self._band_matrix = build_band_matrix(n_bins, num_bands, band_layout, self.sample_rate)
+        self.bands = writer.array('bands', (self.num_frames, num_bands), self._band_matrix.dtype)
+        self.intensity = np.zeros(self.num_frames, dtype=np.float32)
+        self.intensity_window = INTENSITY_WINDOW
+        # Running sum of per-frame band means, as in get_intensity_timeline()
+        self._frame_energy = np.zeros(self.num_frames + 1, dtype=np.float64)
+        
+        self.num_onset_frames = 1 + info.num_samples // ONSET_HOP_LENGTH
+        self._onset_mean = np.zeros(self.num_onset_frames, dtype=np.float32)
+        self._onset_median = np.zeros(self.num_onset_frames, dtype=np.float32)
+        self._mel_basis = librosa.filters.mel(sr=self.sample_rate, n_fft=ONSET_N_FFT)
+        self._previous_db: Optional[np.ndarray] = None
+        self._db_max = -np.inf
+        
+        # Frames [0, frames_ready) have spectrum, bands and intensity
+        self.frames_ready = 0
+        self.done = False
+        self.error: Optional[str] = None
+        self.results: Dict[str, Any] = {}
+        self._frames_analyzed = 0
+        self._condition = threading.Condition()
+        self._thread: Optional[threading.Thread] = None
+    
+    def covers(self, num_bands: int, frame_rate: int, band_layout: str) -> bool:
+        """Check whether the streamed bands are the ones a render asks for."""
+        return (num_bands, frame_rate, band_layout) == (self.num_bands, self.frame_rate, self.band_layout)
+    
+    def start(self) -> None:
+        """Run the analysis on a background thread."""
+        self._thread = threading.Thread(target=self._run, name='streaming-analysis', daemon=True)
+        self._thread.start()
+    
+    def wait(self, frame_number: Optional[int] = None) -> None:
+        """
+        Block until a frame (or, with None, the whole analysis) is done.
+        
+        Args:
+            frame_number: Frame whose features are needed (None waits for beats too)
+        
+        Raises:
+            RuntimeError: If the analysis failed
+        """
+        if frame_number is not None and frame_number < self.frames_ready:
+            return
+        with self._condition:
+            while not self.done and (frame_number is None or frame_number >= self.frames_ready):
+                self._condition.wait()
+        if self.error is not None:
+            raise RuntimeError(f"Streaming audio analysis failed: {self.error}")
+    
+    def _run(self) -> None:
+        logger = get_logger()
+        started = time.perf_counter()
+        try:
+            sr = self.sample_rate
+            frame_stft = StreamingSTFT(
+                self.n_fft, self.num_frames,
+                lambda first, last: np.minimum(np.round(np.arange(first, last) * (sr / self.frame_rate)),
+                                               self.info.num_samples - 1).astype(np.int64),
+                self._batch_frames
+            )
+            onset_stft = StreamingSTFT(
+                ONSET_N_FFT, self.num_onset_frames,
+                lambda first, last: np.arange(first, last, dtype=np.int64) * ONSET_HOP_LENGTH,
+                self._batch_frames
+            )
+            
+            blocks = iter_audio_blocks(self.audio_path, self.info, DECODE_BLOCK_SECONDS * sr)
+            while True:
+                with profiler.span('audio.decode'):
+                    block = next(blocks, None)
+                if block is None:
+                    break
+                self._consume(frame_stft.feed(block), onset_stft.feed(block))
+            self._consume(frame_stft.finish(), onset_stft.finish())
+            
+            with profiler.span('audio.beats'):
+                tempo, beat_frames = librosa.beat.beat_track(onset_envelope=self._onset_median, sr=sr,
+                                                             hop_length=ONSET_HOP_LENGTH)
+            tempo = AudioProcessor.tempo_value(tempo)
+            beat_times = librosa.frames_to_time(beat_frames, sr=sr, hop_length=ONSET_HOP_LENGTH)
+            self.results = {
+                'tempo': tempo,
+                'beat_frames': beat_frames,
+                'beat_times': beat_times,
+                'onset_envelope': self._onset_mean,
+            }
+            self._writer.commit(
+                scalars={
+                    'sample_rate': int(sr),
+                    'duration': float(self.duration),
+                    'tempo': tempo,
+                },
+                arrays={
+                    'beat_frames': beat_frames,
+                    'beat_times': beat_times,
+                    'onset_envelope': self._onset_mean,
+                }
+            )
+            logger.info(f"Streaming analysis of {self.num_frames} frames finished in "
+                        f"{time.perf_counter() - started:.1f}s")
+        except Exception as e:
+            logger.error(f"Streaming audio analysis failed: {e}", exc_info=True)
+            self.error = str(e)
+            self._writer.abort()
+        finally:
+            with self._condition:
+                self.done = True
+                if self.error is None:
+                    self.frames_ready = self.num_frames
+                self._condition.notify_all()
+    
+    def _consume(self, frame_columns, onset_columns) -> None:
+        """Store the columns produced by one block."""
+        for first, magnitude in frame_columns:
+            with profiler.span('audio.stft'):
+                self._add_frames(first, magnitude)
+        for first, magnitude in onset_columns:
+            with profiler.span('audio.onset'):
+                self._add_onset_columns(first, magnitude)
+        
+        ready = self._intensity_ready(self._frames_analyzed)
+        if ready > self.frames_ready:
+            self._update_intensity(self.frames_ready, ready)
+            with self._condition:
+                self.frames_ready = ready
+                self._condition.notify_all()
+    
+    def _add_frames(self, first: int, magnitude: np.ndarray) -> None:
+        last = first + len(magnitude)
+        self.spectrum[first:last] = magnitude
+        bands = magnitude @ self._band_matrix
+        self.bands[first:last] = bands
+        # Continue the running sum sequentially so it equals one cumsum over the track
+        self._frame_energy[first:last + 1] = np.cumsum(
+            np.concatenate(([self._frame_energy[first]], bands.mean(axis=1, dtype=np.float64)))
+        )
+        self._frames_analyzed = last
+    
+    def _intensity_ready(self, frames_analyzed: int) -> int:
+        """Frames whose intensity window is covered by the analyzed frames."""
+        if frames_analyzed >= self.num_frames:
+            return self.num_frames
+        return max(0, frames_analyzed - INTENSITY_WINDOW // 2 + 1)
+    
+    def _update_intensity(self, first: int, last: int) -> None:
+        frames = np.arange(first, last)
+        self.intensity[first:last] = AudioProcessor.intensity_from_energy(
+            self._frame_energy, frames, self.num_frames, INTENSITY_WINDOW
+        )
+    
+    def _add_onset_columns(self, first: int, magnitude: np.ndarray) -> None:
+        """Mel power in dB, positive differences between columns, mean/median over mel bins."""
+        mel = (magnitude * magnitude) @ self._mel_basis.T
+        mel_db = 10.0 * np.log10(np.maximum(1e-10, mel))
+        self._db_max = max(self._db_max, float(mel_db.max()))
+        floor = self._db_max - ONSET_TOP_DB
+        np.maximum(mel_db, floor, out=mel_db)
+        
+        if self._previous_db is None:
+            columns = mel_db
+            first_diff = first + 1
+        else:
+            columns = np.vstack((np.maximum(self._previous_db, floor)[None], mel_db))
+            first_diff = first
+        self._previous_db = mel_db[-1].copy()
+        
+        diff = np.maximum(0.0, np.diff(columns, axis=0))
+        # Difference d lands on envelope frame d + 2, librosa's lag + n_fft // (2 * hop) shift
+        start = first_diff + 2
+        end = min(start + len(diff), self.num_onset_frames)
+        if end > start:
+            diff = diff[:end - start]
+            self._onset_mean[start:end] = diff.mean(axis=1)
+            self._onset_median[start:end] = np.median(diff, axis=1)
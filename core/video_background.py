@@ -3,23 +3,190 @@ Video background processing module.
 Handles loading, caching, and processing of video backgrounds.
 """
 
+import threading
+from collections import OrderedDict
 import cv2
 import numpy as np
 from PIL import Image
-from typing import Optional, List
+from typing import Optional, List, Tuple
 import os
 
+from core.cache_manager import CacheManager
+
+
+def resize_frame(frame: np.ndarray, target_size: Tuple[int, int]) -> np.ndarray:
+    """
+    Resize a decoded frame to the output size.
+    
+    Args:
+        frame: (height, width, 3) uint8 frame
+        target_size: Target size (width, height)
+    
+    Returns:
+        Resized frame (the input itself if it already has the target size)
+    """
+    height, width = frame.shape[:2]
+    if (width, height) == tuple(target_size):
+        return frame
+    # Area averaging when shrinking avoids aliasing; cubic when enlarging
+    shrinking = target_size[0] * target_size[1] < width * height
+    interpolation = cv2.INTER_AREA if shrinking else cv2.INTER_CUBIC
+    return cv2.resize(frame, tuple(target_size), interpolation=interpolation)
+
+
+class DecodeAheadReader:
+    """
+    Decodes a video sequentially on a background thread into a bounded ring buffer.
+    
+    Frames are addressed by a virtual index (loop * total_frames + source frame),
+    so looping playback is one continuous sequence. The reader only seeks when asked
+    for a frame it has already dropped or one far ahead of its position.
+    """
+    
+    def __init__(self, video_path: str, total_frames: int, target_size: Tuple[int, int],
+                 capacity: int = 16):
+        """
+        Initialize and start the decode-ahead reader.
+        
+        Args:
+            video_path: Path to video file
+            total_frames: Number of frames in the video
+            target_size: Output size (width, height) frames are resized to
+            capacity: Number of decoded frames kept in the ring buffer
+        """
+        self.video_path = video_path
+        self.total_frames = max(1, total_frames)
+        self.target_size = tuple(target_size)
+        self.capacity = max(2, capacity)
+        self.seek_count = 0
+        self._buffer: 'OrderedDict[int, np.ndarray]' = OrderedDict()
+        self._next_index = 0
+        self._seek_to: Optional[int] = None
+        self._consumer_index = 0
+        self._stopped = False
+        self._failed = False
+        self._cond = threading.Condition()
+        self._thread = threading.Thread(target=self._decode_loop, daemon=True)
+        self._thread.start()
+    
+    def get(self, virtual_index: int, timeout: float = 10.0) -> Optional[np.ndarray]:
+        """
+        Get a decoded frame, waiting for the decoder if it is about to reach it.
+        
+        Args:
+            virtual_index: loop * total_frames + source frame number
+            timeout: Seconds to wait for the frame
+        
+        Returns:
+            (height, width, 3) RGB frame (read-only; shared with the buffer) or None
+        """
+        with self._cond:
+            self._consumer_index = virtual_index
+            frame = self._buffer.get(virtual_index)
+            if frame is None:
+                oldest = next(iter(self._buffer)) if self._buffer else self._next_index
+                behind = virtual_index < oldest
+                far_ahead = virtual_index >= self._next_index + self.capacity
+                if behind or far_ahead:
+                    # Real random access (e.g. preview scrubbing): restart decoding there
+                    self._buffer.clear()
+                    self._seek_to = virtual_index
+                    self._next_index = virtual_index
+            
+            # Frames before the consumer can be dropped now
+            self._cond.notify_all()
+            if frame is not None:
+                return frame
+            
+            self._cond.wait_for(
+                lambda: virtual_index in self._buffer or self._stopped or self._failed,
+                timeout=timeout
+            )
+            return self._buffer.get(virtual_index)
+    
+    def stop(self) -> None:
+        """Stop the decoder thread and release the buffer."""
+        with self._cond:
+            self._stopped = True
+            self._buffer.clear()
+            self._cond.notify_all()
+        self._thread.join(timeout=5)
+    
+    def _has_room(self) -> bool:
+        """Drop frames the consumer has passed and check for space (caller holds the lock)."""
+        while len(self._buffer) >= self.capacity:
+            oldest = next(iter(self._buffer))
+            if oldest >= self._consumer_index:
+                return False
+            del self._buffer[oldest]
+        return True
+    
+    def _decode_loop(self) -> None:
+        """Decoder thread: read frames in order, resize them and fill the buffer."""
+        capture = cv2.VideoCapture(self.video_path)
+        if not capture.isOpened():
+            with self._cond:
+                self._failed = True
+                self._cond.notify_all()
+            return
+        
+        position = 0
+        last_frame: Optional[np.ndarray] = None
+        try:
+            while True:
+                with self._cond:
+                    self._cond.wait_for(
+                        lambda: self._stopped or self._seek_to is not None or self._has_room()
+                    )
+                    if self._stopped:
+                        break
+                    if self._seek_to is not None:
+                        self._seek_to = None
+                    virtual_index = self._next_index
+                
+                source_index = virtual_index % self.total_frames
+                if source_index != position:
+                    # Loop rewind to frame 0 or a random-access jump
+                    capture.set(cv2.CAP_PROP_POS_FRAMES, source_index)
+                    position = source_index
+                    self.seek_count += 1
+                
+                ret, raw = capture.read()
+                position += 1
+                if ret:
+                    frame = resize_frame(cv2.cvtColor(raw, cv2.COLOR_BGR2RGB), self.target_size)
+                    frame.flags.writeable = False
+                    last_frame = frame
+                else:
+                    # Frame count overestimated by the container: hold the last frame
+                    if last_frame is None:
+                        last_frame = np.zeros((self.target_size[1], self.target_size[0], 3),
+                                              dtype=np.uint8)
+                    frame = last_frame
+                
+                with self._cond:
+                    # A seek requested while decoding makes this frame stale
+                    if self._seek_to is None and virtual_index == self._next_index:
+                        self._buffer[virtual_index] = frame
+                        self._next_index = virtual_index + 1
+                        self._cond.notify_all()
+        finally:
+            capture.release()
+
 
 class VideoBackground:
     """Handles video background loading and frame extraction."""
     
-    def __init__(self, video_path: str, target_fps: int = 30):
+    def __init__(self, video_path: str, target_fps: int = 30, cache: Optional[CacheManager] = None,
+                 decode_ahead_frames: int = 16):
         """
         Initialize video background processor.
         
         Args:
             video_path: Path to video file
             target_fps: Target frame rate for output video
+            cache: Shared cache holding decoded frames (a private one if None)
+            decode_ahead_frames: Ring buffer size of the decode-ahead reader
         """
         self.video_path = video_path
         self.target_fps = target_fps
@@ -27,8 +194,12 @@ class VideoBackground:
         self.video_fps = None
         self.total_frames = None
         self.duration = None
-        self.frame_cache = []
+        self.cache = cache if cache is not None else CacheManager()
+        self.cached_frame_count = 0
         self.cache_loaded = False
+        self.cached_size: Optional[Tuple[int, int]] = None
+        self.decode_ahead_frames = decode_ahead_frames
+        self.reader: Optional[DecodeAheadReader] = None
         
     def load_video(self) -> bool:
         """
@@ -58,12 +229,42 @@ class VideoBackground:
         """Get video duration in seconds."""
         return self.duration if self.duration else 0.0
     
-    def cache_frames(self, max_frames: Optional[int] = None) -> bool:
+    def prepare(self, target_size: Tuple[int, int]) -> None:
+        """
+        Set up frame access for rendering at target_size.
+        
+        Clips whose resized frames fit in the cache budget are decoded once and kept;
+        longer clips are streamed through the decode-ahead ring buffer, as are
+        cached clips once other cache entries evict some of their frames.
+        
+        Args:
+            target_size: Output size (width, height)
+        """
+        if not self.total_frames:
+            return
+        
+        frame_bytes = target_size[0] * target_size[1] * 3
+        if self.total_frames * frame_bytes <= self.cache.available_bytes():
+            if self.cache_frames(target_size=target_size) and self.cached_frame_count >= self.total_frames:
+                return
+            self._release_cached_frames()
+            self.cache_loaded = False
+        
+        self.reader = DecodeAheadReader(
+            self.video_path, self.total_frames, target_size, self.decode_ahead_frames
+        )
+    
+    def cache_frames(self, max_frames: Optional[int] = None,
+                     target_size: Optional[Tuple[int, int]] = None) -> bool:
         """
         Cache video frames in memory for faster access.
         
+        Frames are added until the shared cache budget is full; they never evict
+        other entries, and frames past that point are read from the file.
+        
         Args:
             max_frames: Maximum number of frames to cache (None for all)
+            target_size: Resize frames to this size before caching (None keeps source size)
             
         Returns:
             True if successful, False otherwise
@@ -73,7 +274,7 @@ class VideoBackground:
                 return False
         
         try:
-            self.frame_cache = []
+            self._release_cached_frames()
             self.video_capture.set(cv2.CAP_PROP_POS_FRAMES, 0)
             
             frame_count = 0
@@ -86,11 +287,17 @@ class VideoBackground:
                     
                 # Convert BGR to RGB
                 frame_rgb = cv2.cvtColor(frame, cv2.COLOR_BGR2RGB)
+                if target_size:
+                    frame_rgb = resize_frame(frame_rgb, target_size)
                 # Convert to PIL Image
                 pil_image = Image.fromarray(frame_rgb)
-                self.frame_cache.append(pil_image)
+                if not self.cache.put('video_frame', (self.video_path, frame_count), pil_image,
+                                      evict=False):
+                    break
                 frame_count += 1
             
+            self.cached_frame_count = frame_count
+            self.cached_size = tuple(target_size) if target_size else None
             self.cache_loaded = True
             return True
             
@@ -113,15 +320,34 @@ class VideoBackground:
             return None
         
         # Loop video if time exceeds duration
+        loop_index = int(time_seconds // self.duration)
         looped_time = time_seconds % self.duration
         
         # Calculate frame number
         frame_number = int(looped_time * self.video_fps)
         
-        if self.cache_loaded and frame_number < len(self.frame_cache):
+        frame = None
+        if self.cache_loaded and frame_number < self.cached_frame_count:
             # Get from cache
-            frame = self.frame_cache[frame_number]
-        else:
+            frame = self.cache.get('video_frame', (self.video_path, frame_number))
+            if frame is not None and self.cached_size == tuple(target_size):
+                return frame
+            if frame is None and self.cached_size is not None and self.reader is None:
+                # Later cache entries evicted part of the clip: stream it like a long
+                # clip from now on instead of seeking and resizing per frame
+                self._release_cached_frames()
+                self.cache_loaded = False
+                self.reader = DecodeAheadReader(
+                    self.video_path, self.total_frames, self.cached_size, self.decode_ahead_frames
+                )
+        
+        if frame is None and self.reader is not None and self.reader.target_size == tuple(target_size):
+            # Sequential playback: already decoded and resized on the reader thread
+            decoded = self.reader.get(loop_index * self.total_frames + frame_number)
+            if decoded is not None:
+                return Image.fromarray(decoded)
+        
+        if frame is None:
             # Read from video file
             frame = self._read_frame_from_video(frame_number)
             
@@ -131,7 +357,7 @@ class VideoBackground:
         
         return None
     
-    def get_frame_at_frame_number(self, frame_number: int, audio_duration: float, 
+    def get_frame_at_frame_number(self, frame_number: int, audio_duration: float,
                                    target_size: tuple) -> Optional[Image.Image]:
         """
         Get video frame for a specific output frame number with looping.
@@ -179,17 +405,21 @@ class VideoBackground:
     
     def close(self):
         """Release video resources."""
+        if self.reader:
+            self.reader.stop()
+            self.reader = None
         if self.video_capture:
             self.video_capture.release()
             self.video_capture = None
-        self.frame_cache = []
+        self._release_cached_frames()
         self.cache_loaded = False
     
+    def _release_cached_frames(self) -> None:
+        """Remove this video's frames from the shared cache."""
+        for frame_number in range(self.cached_frame_count):
+            self.cache.invalidate('video_frame', (self.video_path, frame_number))
+        self.cached_frame_count = 0
+    
     def __del__(self):
         """Cleanup on deletion."""
         self.close()
-
-
-
-
-
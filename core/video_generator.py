@@ -7,30 +7,59 @@ import os
 import numpy as np
 from PIL import Image, ImageDraw, ImageFont
 import ffmpeg
-from typing import Tuple, Optional, Dict, Any, List
+from typing import Tuple, Optional, Dict, Any, List, NamedTuple, Union
 import tempfile
 import shutil
-from multiprocessing import Pool, cpu_count
+from multiprocessing import cpu_count
 import time
+from functools import lru_cache
 
-from core.audio_processor import AudioProcessor
+from core.audio_processor import AudioProcessor, FeatureTable, FrameFeatures
+from core.cache_manager import CacheManager
+from core.sprites import Sprite, load_font
+from core.compositor import YUV_FORMATS, create_compositor, yuv420_frame_size
 from core.effects import (
     apply_blur, apply_vignette, apply_bw, fit_background,
-    apply_strobe, apply_background_animation,
-    apply_beat_pulse, apply_beat_flash, apply_beat_strobe, apply_beat_zoom,
-    apply_fade_transition, apply_crossfade_transition, apply_slide_transition,
-    apply_zoom_transition, apply_beat_shake
+    apply_background_animation, strobe_amount,
+    beat_pulse_matrix, beat_zoom_matrix, beat_shake_matrix,
+    beat_flash_amount, beat_strobe_amount
 )
 from core.video_background import VideoBackground
+from core.encoders import EncoderConfig, fixed_gop_args, select_encoder
+from core.layers import Layer
+from core.ffmpeg_pipe import FFmpegPipeWriter
+from core.parallel_renderer import ParallelFrameRenderer
+from core.pipeline import RenderPipeline
+from core.random_state import frame_rng
+from core.render_plan import RenderPlan, Stage
+from core.slideshow import SlideshowScheduler
 from core.visualizers import VisualizerFactory
 from core.overlay_effects import OverlayFactory
 from core.logger import get_logger
+from core import profiler
+
+
+class FrameJob(NamedTuple):
+    """A frame moving through the render stages."""
+    frame_number: int
+    features: FrameFeatures
+    beat_transform: Optional[np.ndarray]  # Beat pulse/zoom matrix for all layers
+    color_flash: Optional[Tuple[Tuple[int, int, int], float]]  # Beat flash/strobe (color, amount)
+    background: Optional[Image.Image]  # Set by the background stage
+    background_transform: Optional[np.ndarray]  # Beat transform with shake folded in
+
+
+@lru_cache(maxsize=32)
+def _opacity_lut(opacity: int) -> List[int]:
+    """Alpha lookup table scaling 0-255 by opacity percent."""
+    return [int(p * opacity / 100) for p in range(256)]
 
 
 class BackgroundManager:
     """Manages multiple backgrounds with slideshow and transitions."""
     
-    def __init__(self, settings: Dict[str, Any], frame_rate: int, width: int, height: int):
+    def __init__(self, settings: Dict[str, Any], frame_rate: int, width: int, height: int,
+                 cache: Optional[CacheManager] = None):
         """
         Initialize background manager.
         
@@ -39,6 +68,7 @@ class BackgroundManager:
             frame_rate: Frame rate
             width: Video width
             height: Video height
+            cache: Shared cache for processed backgrounds (a private one if None)
         """
         self.settings = settings
         self.frame_rate = frame_rate
@@ -52,11 +82,20 @@ class BackgroundManager:
             self.background_paths = self.video_background_paths
         
         self.current_background_index = 0
-        self.cached_backgrounds = {}
+        # The single background lives in the shared byte-budgeted cache
+        self.cache = cache if cache is not None else CacheManager()
         self.slideshow_enabled = settings.get('slideshow_enabled', False)
         self.slideshow_interval = settings.get('slideshow_interval', 10)  # seconds
         self.transition_duration = settings.get('transition_duration', 1.0)  # seconds
         self.transition_type = settings.get('slideshow_transition', 'fade')
+        # Slides bypass the cache: only the current and next one stay decoded
+        self.slideshow: Optional[SlideshowScheduler] = None
+        if self.background_paths and self.slideshow_enabled:
+            self.slideshow = SlideshowScheduler(
+                self.background_paths, self._load_and_process_background, frame_rate,
+                self.slideshow_interval, self.transition_duration, self.transition_type,
+                (width, height), prefetch=settings.get('slideshow_prefetch_enabled', True)
+            )
         
     def get_background_for_frame(self, frame_number: int) -> Optional[Image.Image]:
         """
@@ -69,68 +108,36 @@ class BackgroundManager:
             PIL Image background
         """
         # If no backgrounds or slideshow disabled, use single background
-        if not self.background_paths or not self.slideshow_enabled:
+        if self.slideshow is None:
             return self._load_single_background()
         
-        # Calculate which background should be shown
-        time_seconds = frame_number / self.frame_rate
-        total_interval = self.slideshow_interval + self.transition_duration
-        cycle_position = time_seconds % total_interval
-        
-        # Determine current and next background indices
-        slide_index = int(time_seconds / total_interval) % len(self.background_paths)
-        next_slide_index = (slide_index + 1) % len(self.background_paths)
-        
-        # Check if in transition
-        if cycle_position >= self.slideshow_interval:
-            # In transition
-            transition_progress = (cycle_position - self.slideshow_interval) / self.transition_duration
-            
-            bg1 = self._load_background_by_index(slide_index)
-            bg2 = self._load_background_by_index(next_slide_index)
-            
-            # Apply transition
-            return self._apply_transition(bg1, bg2, transition_progress)
-        else:
-            # Show current background
-            return self._load_background_by_index(slide_index)
+        return self.slideshow.frame(frame_number)
+    
+    def is_static(self) -> bool:
+        """Check whether every frame gets the same background (no slideshow)."""
+        return self.slideshow is None
+    
+    def close(self) -> None:
+        """Stop slideshow prefetching and release the decoded slides."""
+        if self.slideshow is not None:
+            self.slideshow.close()
+    
+    def __del__(self):
+        """Cleanup on deletion."""
+        self.close()
     
     def _load_single_background(self) -> Optional[Image.Image]:
-        """Load single background from settings."""
+        """Load single background from settings (processed once, then cached)."""
         bg_path = self.settings.get('background_path', '')
         if not bg_path or not os.path.exists(bg_path):
             # Create default black background
-            return Image.new('RGB', (self.width, self.height), (0, 0, 0))
-        
-        return self._load_and_process_background(bg_path)
-    
-    def _load_background_by_index(self, index: int) -> Image.Image:
-        """
-        Load background by index from paths list.
-        
-        Args:
-            index: Background index
-            
-        Returns:
-            PIL Image
-        """
-        if not self.background_paths or index >= len(self.background_paths):
-            return Image.new('RGB', (self.width, self.height), (0, 0, 0))
-        
-        bg_path = self.background_paths[index]
-        
-        # Check cache
-        if bg_path in self.cached_backgrounds:
-            return self.cached_backgrounds[bg_path].copy()
-        
-        # Load and cache
-        bg = self._load_and_process_background(bg_path)
-        
-        # Cache if reasonable number of backgrounds
-        if len(self.background_paths) <= 10:
-            self.cached_backgrounds[bg_path] = bg.copy()
+            return self.cache.get_or_create(
+                'background', None, lambda: Image.new('RGB', (self.width, self.height), (0, 0, 0))
+            )
         
-        return bg
+        return self.cache.get_or_create(
+            'background', bg_path, lambda: self._load_and_process_background(bg_path)
+        )
     
     def _load_and_process_background(self, bg_path: str) -> Image.Image:
         """
@@ -164,58 +171,68 @@ class BackgroundManager:
             logger = get_logger()
             logger.error(f"Error loading background {bg_path}: {e}", exc_info=True)
             return Image.new('RGB', (self.width, self.height), (0, 0, 0))
-    
-    def _apply_transition(self, image1: Image.Image, image2: Image.Image, progress: float) -> Image.Image:
-        """
-        Apply transition between two images.
-        
-        Args:
-            image1: First image
-            image2: Second image
-            progress: Transition progress (0.0 to 1.0)
-            
-        Returns:
-            Transitioned image
-        """
-        if self.transition_type == 'fade' or self.transition_type == 'crossfade':
-            return apply_crossfade_transition(image1, image2, progress)
-        elif self.transition_type == 'slide':
-            return apply_slide_transition(image1, image2, progress, 'left')
-        elif self.transition_type == 'zoom':
-            return apply_zoom_transition(image1, image2, progress)
-        elif self.transition_type == 'instant':
-            return image2 if progress > 0.5 else image1
-        else:
-            return apply_fade_transition(image1, image2, progress)
 
 
 class VideoGenerator:
     """Generates video files with spectrum visualization."""
     
-    def __init__(self, audio_processor: AudioProcessor, settings: Dict[str, Any]):
+    def __init__(self, audio_processor: AudioProcessor, settings: Dict[str, Any],
+                 plan: Optional[RenderPlan] = None):
         """
         Initialize video generator.
         
         Args:
             audio_processor: AudioProcessor instance
             settings: Settings dictionary
+            plan: Render plan compiled from the same settings (e.g. by the parent of
+                  a worker process); compiled here when None
         """
         self.audio_processor = audio_processor
         self.settings = settings
         self.width = settings.get('video_width', 1920)
         self.height = settings.get('video_height', 1080)
         self.frame_rate = settings.get('frame_rate', 30)
+        self.band_layout = settings.get('band_layout', 'squared_log')
+        self._feature_table = None
         self.temp_dir = None
+        # One memory budget for backgrounds, logo and video frames
+        self.cache = CacheManager(int(settings.get('cache_budget_mb', 512)) * 1024 * 1024)
         self.video_background = None
         self._init_video_background()
         self.visualizer = None
         self._init_visualizer()
         self.overlay_effect = None
         self._init_overlay_effect()
-        self.background_manager = BackgroundManager(settings, self.frame_rate, self.width, self.height)
-        # Caching
-        self._cached_logo = None
-        self._cached_logo_path = None
+        self.background_manager = BackgroundManager(settings, self.frame_rate, self.width, self.height,
+                                                    cache=self.cache)
+        self._encoder: Optional[EncoderConfig] = None  # Chosen on first encode
+        self._pipeline: Optional[RenderPipeline] = None  # Pipeline of the current/last stream
+        self.compositor = create_compositor(self.width, self.height,
+                                            self.settings.get('render_backend', 'cpu'))
+        self._audio_duration: Optional[float] = None  # Video backgrounds map frames by it
+        self.plan = plan if plan is not None else self._compile_plan()
+        self._stage_sprites: Dict[str, Optional[Sprite]] = {}  # Text/logo sprites of the plan
+    
+    def _compile_plan(self) -> RenderPlan:
+        """Compile the current settings into a render plan."""
+        return RenderPlan.from_settings(
+            self.settings,
+            background_static=self.video_background is None and self.background_manager.is_static(),
+            has_overlay=self.overlay_effect is not None
+        )
+    
+    def update_settings(self, settings: Dict[str, Any]) -> None:
+        """
+        Replace settings that do not change the generator's layers (opacity, text,
+        logo, strobe, ...) and recompile the render plan.
+        
+        Args:
+            settings: New settings dictionary
+        """
+        self.settings.clear()
+        self.settings.update(settings)
+        self.plan = self._compile_plan()
+        self._stage_sprites = {}
     
     def _create_temp_dir(self) -> str:
         """Create temporary directory for frames."""
@@ -234,11 +251,13 @@ class VideoGenerator:
         video_bg_path = self.settings.get('video_background_path', '')
         if video_bg_path and os.path.exists(video_bg_path):
             try:
-                self.video_background = VideoBackground(video_bg_path, self.frame_rate)
+                self.video_background = VideoBackground(
+                    video_bg_path, self.frame_rate, cache=self.cache,
+                    decode_ahead_frames=self.settings.get('video_decode_ahead_frames', 16)
+                )
                 if self.video_background.load_video():
-                    # Cache frames for videos shorter than 30 seconds
-                    if self.video_background.get_duration() < 30:
-                        self.video_background.cache_frames()
+                    # Keep short clips resized in the cache, stream longer ones
+                    self.video_background.prepare((self.width, self.height))
                 else:
                     self.video_background = None
             except Exception as e:
@@ -334,22 +353,24 @@ class VideoGenerator:
         # Check if video background is available
         if self.video_background:
             try:
-                audio_duration = self.audio_processor.get_duration()
-                bg = self.video_background.get_frame_at_frame_number(
-                    frame_number, audio_duration, (self.width, self.height)
-                )
+                if self._audio_duration is None:
+                    self._audio_duration = self.audio_processor.get_duration()
+                with profiler.span('background.video_seek'):
+                    bg = self.video_background.get_frame_at_frame_number(
+                        frame_number, self._audio_duration, (self.width, self.height)
+                    )
                 if bg:
                     # Apply effects to video frame
-                    if self.settings.get('background_bw', False):
-                        bg = apply_bw(bg)
-                    
-                    blur_intensity = self.settings.get('background_blur', 0)
-                    if blur_intensity > 0:
-                        bg = apply_blur(bg, blur_intensity)
-                    
-                    vignette_intensity = self.settings.get('vignette_intensity', 0)
-                    if vignette_intensity > 0:
-                        bg = apply_vignette(bg, vignette_intensity)
+                    plan = self.plan
+                    with profiler.span('background.effects'):
+                        if plan.background_bw:
+                            bg = apply_bw(bg)
+                        
+                        if plan.background_blur > 0:
+                            bg = apply_blur(bg, plan.background_blur)
+                        
+                        if plan.vignette_intensity > 0:
+                            bg = apply_vignette(bg, plan.vignette_intensity)
                     
                     return bg
             except Exception as e:
@@ -357,7 +378,8 @@ class VideoGenerator:
                 logger.error(f"Error loading video background frame: {e}", exc_info=True)
         
         # Use BackgroundManager for slideshow and transitions
-        bg = self.background_manager.get_background_for_frame(frame_number)
+        with profiler.span('background.image'):
+            bg = self.background_manager.get_background_for_frame(frame_number)
         
         if bg is None:
             return Image.new('RGB', (self.width, self.height), (0, 0, 0))
@@ -369,8 +391,11 @@ class VideoGenerator:
         """
         Add text overlay to image.
         
+        The text is rendered once into a cached sprite; each frame only blends
+        the sprite's bounding box.
+        
         Args:
-            image: Base image
+            image: Base image (modified in place)
             text: Text to add
             position: Position ('center', 'top', 'bottom', etc.)
             color: Text color (RGB)
@@ -381,19 +406,48 @@ class VideoGenerator:
         if not text:
             return image
         
+        return self._get_text_overlay_sprite(text, position, color).composite(image)
+    
+    def _get_text_overlay_sprite(self, text: str, position: str,
+                                 color: Tuple[int, int, int]) -> Sprite:
+        """
+        Get the cached text overlay sprite, rendering it on first use.
+        
+        Args:
+            text: Text to add
+            position: Position ('center', 'top', 'bottom', etc.)
+            color: Text color (RGB)
+            
+        Returns:
+            Text sprite
+        """
+        text_opacity = self.settings.get('text_opacity', 100)
+        cache_key = (text, tuple(color), position, text_opacity, self.width, self.height)
+        return self.cache.get_or_create(
+            'overlay_sprite', ('text',) + cache_key,
+            lambda: self._render_text_overlay(text, position, color, text_opacity)
+        )
+    
+    def _render_text_overlay(self, text: str, position: str, color: Tuple[int, int, int],
+                             text_opacity: int) -> Sprite:
+        """
+        Render the text overlay into a sprite.
+        
+        Args:
+            text: Text to render
+            position: Position ('center', 'top', 'bottom', etc.)
+            color: Text color (RGB)
+            text_opacity: Text opacity (0-100)
+            
+        Returns:
+            Cropped text sprite
+        """
         # Create transparent layer for text
         text_layer = Image.new('RGBA', (self.width, self.height), (0, 0, 0, 0))
         draw = ImageDraw.Draw(text_layer)
         
         # Try to use a nice font, fallback to default
-        try:
-            font_size = min(self.height // 20, 72)
-            font = ImageFont.truetype("/System/Library/Fonts/Helvetica.ttc", font_size)
-        except:
-            try:
-                font = ImageFont.truetype("arial.ttf", min(self.height // 20, 72))
-            except:
-                font = ImageFont.load_default()
+        font = load_font(min(self.height // 20, 72))
         
         # Get text bounding box
         bbox = draw.textbbox((0, 0), text, font=font)
@@ -421,15 +475,10 @@ class VideoGenerator:
         draw.text((x, y), text, font=font, fill=(*color, 255))
         
         # Apply text opacity
-        text_opacity = self.settings.get('text_opacity', 100)
         if text_opacity < 100:
             text_layer = self._apply_opacity(text_layer, text_opacity)
         
-        # Composite text onto image
-        image = image.convert('RGBA')
-        image = Image.alpha_composite(image, text_layer)
-        
-        return image
+        return Sprite(text_layer)
     
     def _apply_opacity(self, image: Image.Image, opacity: int) -> Image.Image:
         """
@@ -450,8 +499,8 @@ class VideoGenerator:
             image = image.convert('RGBA')
         
         # Apply opacity
-        alpha = image.split()[3]
-        alpha = alpha.point(lambda p: int(p * opacity / 100))
+        alpha = image.getchannel('A')
+        alpha = alpha.point(_opacity_lut(opacity))
         image.putalpha(alpha)
         
         return image
@@ -467,72 +516,122 @@ class VideoGenerator:
         Returns:
             Image with logo overlay
         """
+        sprite = self._get_logo_sprite(logo_path)
+        return sprite.composite(image) if sprite else image
+    
+    def _get_logo_sprite(self, logo_path: str) -> Optional[Sprite]:
+        """
+        Get the cached logo sprite (image or text-as-logo), rendering it on first use.
+        
+        Args:
+            logo_path: Path to logo image
+            
+        Returns:
+            Logo sprite, or None when there is no usable logo
+        """
         # Check for text-as-logo
         logo_text = self.settings.get('logo_text', '')
         if logo_text:
-            return self._add_text_logo(image, logo_text)
+            return self._get_text_logo_sprite(logo_text)
         
         if not logo_path or not os.path.exists(logo_path):
-            return image
+            return None
         
         try:
-            # Check cache
-            if self._cached_logo_path == logo_path and self._cached_logo is not None:
-                logo = self._cached_logo.copy()
-            else:
-                logo = Image.open(logo_path).convert('RGBA')
-                
-                # Get logo size setting (5-20% of height)
-                logo_scale = self.settings.get('logo_scale', 10) / 100
-                logo_size = int(self.height * logo_scale)
-                logo.thumbnail((logo_size, logo_size), Image.Resampling.LANCZOS)
-                
-                # Cache the logo
-                self._cached_logo = logo.copy()
-                self._cached_logo_path = logo_path
-            
-            # Apply logo opacity
+            # Cache the final (scaled, opacity-applied, positioned) logo sprite
+            logo_scale = self.settings.get('logo_scale', 10)
             logo_opacity = self.settings.get('logo_opacity', 100)
-            if logo_opacity < 100:
-                logo = self._apply_opacity(logo, logo_opacity)
-            
-            # Get logo position
             position = self.settings.get('logo_position', 'top-right')
-            x, y = self._calculate_logo_position(logo.width, logo.height, position)
-            
-            # Paste with alpha
-            image = image.convert('RGBA')
-            image.paste(logo, (x, y), logo)
-            return image
+            cache_key = (logo_path, os.path.getmtime(logo_path), logo_scale, logo_opacity,
+                         position, self.width, self.height)
+            return self.cache.get_or_create(
+                'overlay_sprite', ('logo',) + cache_key,
+                lambda: self._render_logo(logo_path, logo_scale, logo_opacity, position)
+            )
         except Exception as e:
             logger = get_logger()
             logger.error(f"Error adding logo: {e}", exc_info=True)
-            return image
+            return None
+    
+    def _render_logo(self, logo_path: str, logo_scale: int, logo_opacity: int,
+                     position: str) -> Sprite:
+        """
+        Load a logo image scaled to the frame with its opacity applied.
+        
+        Args:
+            logo_path: Path to logo image
+            logo_scale: Logo size as a percentage of frame height
+            logo_opacity: Logo opacity (0-100)
+            position: Logo position name
+            
+        Returns:
+            Logo sprite placed at its position
+        """
+        logo = Image.open(logo_path).convert('RGBA')
+        
+        # Get logo size setting (5-20% of height)
+        logo_size = int(self.height * logo_scale / 100)
+        logo.thumbnail((logo_size, logo_size), Image.Resampling.LANCZOS)
+        
+        # Apply logo opacity
+        if logo_opacity < 100:
+            logo = self._apply_opacity(logo, logo_opacity)
+        
+        x, y = self._calculate_logo_position(logo.width, logo.height, position)
+        return Sprite(logo, (x, y))
     
     def _add_text_logo(self, image: Image.Image, text: str) -> Image.Image:
         """
         Add text as logo.
         
         Args:
-            image: Base image
+            image: Base image (modified in place)
             text: Text to render as logo
             
         Returns:
             Image with text logo
         """
+        return self._get_text_logo_sprite(text).composite(image)
+    
+    def _get_text_logo_sprite(self, text: str) -> Sprite:
+        """
+        Get the cached text logo sprite, rendering it on first use.
+        
+        Args:
+            text: Text to render as logo
+            
+        Returns:
+            Text logo sprite
+        """
+        position = self.settings.get('logo_position', 'top-right')
+        text_color = tuple(self.settings.get('text_color', [255, 255, 255]))
+        logo_opacity = self.settings.get('logo_opacity', 100)
+        cache_key = (text, text_color, position, logo_opacity, self.width, self.height)
+        return self.cache.get_or_create(
+            'overlay_sprite', ('text_logo',) + cache_key,
+            lambda: self._render_text_logo(text, text_color, position, logo_opacity)
+        )
+    
+    def _render_text_logo(self, text: str, text_color: Tuple[int, int, int], position: str,
+                          logo_opacity: int) -> Sprite:
+        """
+        Render the text logo into a sprite.
+        
+        Args:
+            text: Text to render as logo
+            text_color: Text color (RGB)
+            position: Logo position name
+            logo_opacity: Logo opacity (0-100)
+            
+        Returns:
+            Cropped text logo sprite
+        """
         # Create text layer
         text_layer = Image.new('RGBA', (self.width, self.height), (0, 0, 0, 0))
         draw = ImageDraw.Draw(text_layer)
         
         # Load font
-        try:
-            font_size = int(self.height * 0.05)  # 5% of height
-            font = ImageFont.truetype("/System/Library/Fonts/Helvetica.ttc", font_size)
-        except:
-            try:
-                font = ImageFont.truetype("arial.ttf", int(self.height * 0.05))
-            except:
-                font = ImageFont.load_default()
+        font = load_font(int(self.height * 0.05))  # 5% of height
         
         # Get text size
         bbox = draw.textbbox((0, 0), text, font=font)
@@ -540,27 +639,20 @@ class VideoGenerator:
         text_height = bbox[3] - bbox[1]
         
         # Get position
-        position = self.settings.get('logo_position', 'top-right')
         x, y = self._calculate_logo_position(text_width, text_height, position)
         
         # Draw text with outline
         outline_color = (0, 0, 0, 255)
-        text_color = self.settings.get('text_color', [255, 255, 255])
         
         for adj in [(-1, -1), (-1, 0), (-1, 1), (0, -1), (0, 1), (1, -1), (1, 0), (1, 1)]:
             draw.text((x + adj[0], y + adj[1]), text, font=font, fill=outline_color)
         draw.text((x, y), text, font=font, fill=(*text_color, 255))
         
         # Apply opacity
-        logo_opacity = self.settings.get('logo_opacity', 100)
         if logo_opacity < 100:
             text_layer = self._apply_opacity(text_layer, logo_opacity)
         
-        # Composite
-        image = image.convert('RGBA')
-        image = Image.alpha_composite(image, text_layer)
-        
-        return image
+        return Sprite(text_layer)
     
     def _calculate_logo_position(self, logo_width: int, logo_height: int, position: str) -> Tuple[int, int]:
         """
@@ -608,102 +700,318 @@ class VideoGenerator:
         Returns:
             PIL Image for the frame
         """
-        # Load background (pass frame_number for video backgrounds)
-        frame = self._load_background(frame_number)
-        
-        # Apply beat shake to background
-        if self.settings.get('background_beat_shake_enabled', False):
-            beat_strength = self.audio_processor.get_beat_strength(frame_number, self.frame_rate)
-            shake_intensity = self.settings.get('background_beat_shake_intensity', 50)
-            frame = apply_beat_shake(frame, beat_strength, shake_intensity)
-        
-        # Apply background opacity
-        background_opacity = self.settings.get('background_opacity', 100)
-        if background_opacity < 100:
-            frame = frame.convert('RGBA')
-            frame = self._apply_opacity(frame, background_opacity)
-        
-        # Apply background animation
-        animation_type = self.settings.get('background_animation', 'none')
-        total_frames = int(self.audio_processor.get_duration() * self.frame_rate)
-        frame = apply_background_animation(frame, frame_number, animation_type, total_frames)
-        
-        # Get spectrum data
-        num_bands = 64
-        bands = self.audio_processor.get_frame_bands(frame_number, num_bands, self.frame_rate)
-        spectrum_data = self.audio_processor.get_frame_spectrum(frame_number, self.frame_rate)
-        
-        # Check if visualizer is enabled
-        if self.settings.get('visualizer_enabled', True):
-            # Use new visualizer system
-            if self.visualizer:
-                spectrum_img = self.visualizer.render(bands, spectrum_data, frame_number)
-            else:
-                # Fallback to old method
-                spectrum_img = self._draw_spectrum_bars(bands, self.width, self.height)
+        frame = self.render_frame(frame_number)
+        with profiler.span('to_image'):
+            return Image.fromarray(frame)
+    
+    def render_frame(self, frame_number: int, pix_fmt: str = 'rgb24') -> np.ndarray:
+        """
+        Render a single video frame into the compositor's output buffer.
+        
+        Args:
+            frame_number: Frame number (0-indexed)
+            pix_fmt: Output format: 'rgb24', or 'yuv420p'/'nv12' converted straight
+                     from the composite (BT.709, range from the yuv_range setting)
             
-            # Apply visualizer opacity
-            visualizer_opacity = self.settings.get('visualizer_opacity', 100)
-            if visualizer_opacity < 100:
-                spectrum_img = self._apply_opacity(spectrum_img, visualizer_opacity)
+        Returns:
+            (height, width, 3) uint8 array for RGB, flat uint8 frame for YUV;
+            overwritten by the next call
+        """
+        job = self._load_frame_background(self._prepare_frame(frame_number))
+        return self._compose_frame(job, pix_fmt)
+    
+    def _prepare_frame(self, frame_number: int) -> FrameJob:
+        """
+        Look up a frame's audio features and the beat effects they drive.
+        
+        Args:
+            frame_number: Frame number (0-indexed)
+        
+        Returns:
+            FrameJob without background
+        """
+        with profiler.span('features'):
+            features = self.get_feature_table().frame(frame_number)
             
-            # Composite spectrum over background
-            frame = Image.alpha_composite(frame.convert('RGBA'), spectrum_img)
-            frame = frame.convert('RGB')
-        else:
-            # No visualizer, just use background
-            frame = frame.convert('RGB')
-        
-        # Apply beat-synchronized effects
-        beat_sync_enabled = self.settings.get('beat_sync_enabled', False)
-        if beat_sync_enabled:
-            beat_strength = self.audio_processor.get_beat_strength(frame_number, self.frame_rate)
-            
-            beat_effect_type = self.settings.get('beat_effect_type', 'pulse')
-            
-            if beat_effect_type == 'pulse':
-                frame = apply_beat_pulse(frame, beat_strength)
-            elif beat_effect_type == 'flash':
-                flash_color = tuple(self.settings.get('beat_flash_color', [255, 255, 255]))
-                frame = apply_beat_flash(frame, beat_strength, flash_color)
-            elif beat_effect_type == 'strobe':
-                strobe_color = tuple(self.settings.get('beat_strobe_color', [255, 255, 255]))
-                frame = apply_beat_strobe(frame, beat_strength, strobe_color)
-            elif beat_effect_type == 'zoom':
-                frame = apply_beat_zoom(frame, beat_strength)
-        
-        # Apply regular strobe effect (non-beat-synced)
-        if self.settings.get('strobe_enabled', False) and not beat_sync_enabled:
-            strobe_color = tuple(self.settings.get('strobe_color', [255, 255, 255]))
-            frame = apply_strobe(frame, spectrum_data, strobe_color)
-        
-        # Add overlay effect (rain, snow, etc.)
-        if self.overlay_effect:
-            self.overlay_effect.update(frame_number)
-            overlay_img = self.overlay_effect.render()
+            # Beat pulse/zoom and shake fold into one affine transform per layer, applied
+            # while the layers are composited instead of resampling the finished frame
+            beat_transform = None
+            color_flash = None
+            beat_effect = self.plan.beat_effect
+            if beat_effect is not None:
+                beat_strength = features.beat_strength
+                
+                if beat_effect == 'pulse':
+                    beat_transform = beat_pulse_matrix((self.width, self.height), beat_strength)
+                elif beat_effect == 'zoom':
+                    beat_transform = beat_zoom_matrix((self.width, self.height), beat_strength)
+                elif beat_effect == 'flash':
+                    color_flash = (self.plan.beat_color, beat_flash_amount(beat_strength))
+                else:
+                    color_flash = (self.plan.beat_color, beat_strobe_amount(beat_strength))
             
-            # Apply overlay opacity
-            overlay_opacity = self.settings.get('overlay_opacity', 100)
-            if overlay_opacity < 100:
-                overlay_img = self._apply_opacity(overlay_img, overlay_opacity)
+            return FrameJob(frame_number, features, beat_transform, color_flash, None, beat_transform)
+    
+    def _load_frame_background(self, job: FrameJob) -> FrameJob:
+        """
+        Load, animate and position the background of a prepared frame.
+        
+        Args:
+            job: FrameJob from _prepare_frame()
+        
+        Returns:
+            FrameJob with background and background_transform set
+        """
+        with profiler.span('background'):
+            plan = self.plan
+            frame_number = job.frame_number
+            background_transform = job.beat_transform
+            if plan.background_static:
+                # Same background every frame: load and process it once
+                frame = self.cache.get_or_create(
+                    'background_stage', 'static', lambda: self._load_background(0)
+                )
+            else:
+                # Load background (pass frame_number for video backgrounds)
+                frame = self._load_background(frame_number)
+                
+                # Beat shake moves the background only, before any beat pulse/zoom
+                if plan.shake_intensity:
+                    beat_strength = job.features.beat_strength
+                    shake_rng = frame_rng(plan.random_seed, frame_number, 'beat_shake')
+                    shake = beat_shake_matrix(beat_strength, plan.shake_intensity, shake_rng)
+                    if shake is not None:
+                        background_transform = shake if job.beat_transform is None else job.beat_transform @ shake
             
-            # Composite overlay
-            frame = frame.convert('RGBA')
-            frame = Image.alpha_composite(frame, overlay_img)
+            # Apply background animation
+            if plan.background_animation is not None:
+                total_frames = self.get_feature_table().num_frames
+                with profiler.span('background.animation'):
+                    frame = apply_background_animation(frame, frame_number, plan.background_animation,
+                                                       total_frames)
+        return job._replace(background=frame, background_transform=background_transform)
+    
+    def _compose_frame(self, job: FrameJob, pix_fmt: str = 'rgb24') -> np.ndarray:
+        """
+        Render the layers of a frame and composite them over its background.
+        
+        Args:
+            job: FrameJob with background loaded
+            pix_fmt: Output format ('rgb24', 'yuv420p' or 'nv12')
         
-        # Add text overlay
-        text_overlay = self.settings.get('text_overlay', '')
-        if text_overlay:
-            text_color = tuple(self.settings.get('text_color', [255, 255, 255]))
-            text_position = self.settings.get('text_position', 'center')
-            frame = self._add_text_overlay(frame, text_overlay, text_position, text_color)
+        Returns:
+            Compositor output buffer, overwritten by the next call
+        """
+        compositor = self.compositor
+        visualizer_layer = None
+        if self.plan.has_stage('visualizer') and not compositor.supports_visualizer(self.visualizer):
+            with profiler.span('layer.visualizer'):
+                visualizer_layer = self.render_visualizer_layer(job)
+        with profiler.span('layer.overlay'):
+            overlay_layer = self.render_overlay_layer(job)
+        with profiler.span('composite'):
+            self.composite_layers(compositor, job, visualizer_layer, overlay_layer)
+        with profiler.span('convert'):
+            return compositor.to_output(pix_fmt, self.plan.yuv_full_range)
+    
+    def render_visualizer_layer(self, job: FrameJob) -> Optional[Union[Layer, Image.Image]]:
+        """
+        Render the spectrum visualizer of a frame.
         
-        # Add logo
-        logo_path = self.settings.get('logo_path', '')
-        if logo_path:
-            frame = self._add_logo(frame, logo_path)
+        Args:
+            job: FrameJob of the frame
         
-        return frame
+        Returns:
+            Visualizer layer (reused by the next call), or None when disabled
+        """
+        if not self.plan.visualizer_enabled:
+            return None
+        bands = job.features.bands
+        if self.visualizer:
+            # Use new visualizer system
+            return self.visualizer.render_layer(bands, job.features.spectrum, job.frame_number)
+        # Fallback to old method
+        return self._draw_spectrum_bars(bands, self.width, self.height)
+    
+    def render_overlay_layer(self, job: FrameJob) -> Optional[Layer]:
+        """
+        Advance and render the overlay effect (rain, snow, etc.) of a frame.
+        
+        Args:
+            job: FrameJob of the frame
+        
+        Returns:
+            Overlay layer (reused by the next call), or None without an overlay
+        """
+        if not self.overlay_effect:
+            return None
+        self.overlay_effect.update(job.frame_number)
+        return self.overlay_effect.render_layer()
+    
+    def composite_layers(self, compositor, job: FrameJob, visualizer_layer, overlay_layer) -> None:
+        """
+        Composite a frame from its background and rendered layers.
+        
+        Opacities, beat flash/strobe, text and logo are applied here, so a
+        caller holding cached layers can recomposite after changing only those.
+        
+        Args:
+            compositor: FrameCompositor to composite into
+            job: FrameJob with background loaded
+            visualizer_layer: Visualizer layer, or None (drawn by the compositor when it
+                              supports the visualizer natively)
+            overlay_layer: Overlay layer, or None
+        """
+        plan = self.plan
+        folded = plan.folded_stages
+        if folded:
+            # Leading static stages are composited once into a cached base frame
+            base = self.cache.get_or_create(
+                'background_stage', ('base', plan), lambda: self._render_base(job.background, plan.stages[:folded])
+            )
+            compositor.begin(base)
+        else:
+            # Background opacity composites the background over black
+            compositor.begin(job.background, plan.background_opacity, job.background_transform)
+        
+        for stage in plan.stages[max(folded, 1):]:
+            if stage.name == 'visualizer':
+                if visualizer_layer is not None:
+                    # Composite spectrum over background with visualizer opacity
+                    compositor.add_layer(visualizer_layer, plan.visualizer_opacity, job.beat_transform)
+                elif compositor.supports_visualizer(self.visualizer):
+                    # Drawn directly by the GPU backend from the band array
+                    compositor.add_visualizer(self.visualizer, job.features.bands, plan.visualizer_opacity,
+                                              job.beat_transform)
+            elif stage.name == 'color_flash':
+                # Beat flash/strobe and the audio strobe cover the whole composed frame
+                if job.color_flash is not None:
+                    compositor.blend_color(*job.color_flash)
+                elif plan.audio_strobe_color is not None:
+                    compositor.blend_color(plan.audio_strobe_color, strobe_amount(job.features.spectrum))
+            elif stage.name == 'overlay':
+                # Add overlay effect (rain, snow, etc.)
+                if overlay_layer is not None:
+                    compositor.add_layer(overlay_layer, plan.overlay_opacity)
+            else:
+                # Text overlay and logo
+                with profiler.span(f'composite.{stage.name}'):
+                    compositor.add_sprite(self._get_stage_sprite(stage.name))
+    
+    def _get_stage_sprite(self, name: str) -> Optional[Sprite]:
+        """
+        Get the sprite of the plan's 'text' or 'logo' stage, resolved once per plan.
+        
+        Args:
+            name: Stage name
+        
+        Returns:
+            Sprite, or None when the logo could not be loaded
+        """
+        if name not in self._stage_sprites:
+            if name == 'text':
+                text, position, color = self.plan.text
+                self._stage_sprites[name] = self._get_text_overlay_sprite(text, position, color)
+            else:
+                self._stage_sprites[name] = self._get_logo_sprite(self.plan.logo_path)
+        return self._stage_sprites[name]
+    
+    def _render_base(self, background: Image.Image, stages: Tuple[Stage, ...]) -> Image.Image:
+        """
+        Composite the static background and the static stages following it.
+        
+        Args:
+            background: Static background image
+            stages: Leading static stages of the plan, starting with the background
+        
+        Returns:
+            RGB frame every frame of the render starts from
+        """
+        base = background if background.mode == 'RGB' else background.convert('RGB')
+        opacity = self.plan.background_opacity
+        if opacity < 100:
+            # Background opacity composites the background over black
+            pixels = np.asarray(base, dtype=np.float32) * (max(opacity, 0) / 100.0) + 0.5
+            base = Image.fromarray(pixels.astype(np.uint8))
+        elif len(stages) > 1 and base is background:
+            # Sprites are blended in place; the cached background stays untouched
+            base = base.copy()
+        for stage in stages[1:]:
+            sprite = self._get_stage_sprite(stage.name)
+            if sprite is not None:
+                sprite.composite(base)
+        return base
+    
+    def _is_background_static(self) -> bool:
+        """Check whether the background stage yields the same image for every frame."""
+        return self.plan.background_static
+    
+    def needs_beat_analysis(self) -> bool:
+        """Check whether any enabled effect uses beat detection."""
+        return self.plan.needs_beats
+    
+    def get_feature_table(self) -> FeatureTable:
+        """
+        Get the per-frame audio feature table, building it on first use.
+        
+        Returns:
+            FeatureTable with bands, spectrum, beat strength and intensity per frame
+        """
+        if self._feature_table is None:
+            self._feature_table = self.audio_processor.get_feature_table(
+                num_bands=64, frame_rate=self.frame_rate, band_layout=self.band_layout,
+                include_beats=self.needs_beat_analysis()
+            )
+        return self._feature_table
+    
+    def seek(self, frame_number: int, bands: Optional[np.ndarray] = None) -> None:
+        """
+        Bring stateful visualizers and overlays to the state just before frame_number.
+        
+        Args:
+            frame_number: Frame that will be rendered next
+            bands: Optional precomputed (frames x bands) matrix for replaying state
+        """
+        if self.visualizer and self.visualizer.stateful:
+            if bands is None:
+                table = self.get_feature_table()
+                # Replaying state reads every earlier frame, which a streaming analysis may still write
+                table.wait_for(frame_number - 1)
+                bands = table.bands
+            last_frame = bands.shape[0] - 1
+            self.visualizer.seek(frame_number, lambda f: bands[min(f, last_frame)])
+        
+        if self.overlay_effect:
+            self.overlay_effect.seek(frame_number)
+    
+    def save_frame(self, frame: Image.Image, frame_path: str) -> None:
+        """
+        Save a frame as PNG using the compression level of the quality preset.
+        
+        Args:
+            frame: Frame image
+            frame_path: Output PNG path
+        """
+        quality_preset = self.settings.get('quality_preset', 'balanced')
+        with profiler.span('save_png'):
+            if quality_preset == 'fast':
+                frame.save(frame_path, optimize=False, compress_level=1)
+            elif quality_preset == 'high':
+                frame.save(frame_path, optimize=True, compress_level=9)
+            else:
+                frame.save(frame_path, optimize=True, compress_level=6)
+    
+    def _get_render_workers(self) -> int:
+        """Get number of render worker processes (0 in settings means auto)."""
+        workers = self.settings.get('render_workers', 0)
+        if workers <= 0:
+            workers = max(1, cpu_count() - 1)
+        return workers
+    
+    def _should_render_parallel(self, num_frames: int) -> bool:
+        """Check whether a frame range is worth rendering on the worker pool."""
+        use_multiprocessing = self.settings.get('use_multiprocessing', True)
+        return use_multiprocessing and num_frames > 30 and self._get_render_workers() > 1
     
     def generate_frames(self, output_dir: str, start_frame: int = 0, 
                        end_frame: Optional[int] = None, progress_callback=None) -> int:
@@ -730,23 +1038,8 @@ class VideoGenerator:
         logger = get_logger()
         logger.info(f"Generating frames {start_frame} to {end_frame} (total: {end_frame - start_frame} frames)")
         
-        # Check quality preset
-        quality_preset = self.settings.get('quality_preset', 'balanced')
-        use_multiprocessing = self.settings.get('use_multiprocessing', True)
-        
-        # Adjust settings based on quality preset
-        if quality_preset == 'fast':
-            # Fast mode: lower quality, faster generation
-            use_multiprocessing = True
-        elif quality_preset == 'balanced':
-            # Balanced mode: good quality, reasonable speed
-            use_multiprocessing = True
-        elif quality_preset == 'high':
-            # High quality mode: best quality, slower
-            use_multiprocessing = False  # Sequential for consistency
-        
         # Generate frames
-        if use_multiprocessing and (end_frame - start_frame) > 30:
+        if self._should_render_parallel(end_frame - start_frame):
             # Use multiprocessing for larger batches
             return self._generate_frames_parallel(output_dir, start_frame, end_frame, progress_callback)
         else:
@@ -756,18 +1049,12 @@ class VideoGenerator:
     def _generate_frames_sequential(self, output_dir: str, start_frame: int, 
                                     end_frame: int, progress_callback=None) -> int:
         """Generate frames sequentially."""
+        self.seek(start_frame)
+        
         for frame_num in range(start_frame, end_frame):
             frame = self.generate_frame(frame_num)
             frame_path = os.path.join(output_dir, f'frame_{frame_num:06d}.png')
-            
-            # Apply quality preset for saving
-            quality_preset = self.settings.get('quality_preset', 'balanced')
-            if quality_preset == 'fast':
-                frame.save(frame_path, optimize=False, compress_level=1)
-            elif quality_preset == 'high':
-                frame.save(frame_path, optimize=True, compress_level=9)
-            else:
-                frame.save(frame_path, optimize=True, compress_level=6)
+            self.save_frame(frame, frame_path)
             
             if progress_callback:
                 progress_callback(frame_num - start_frame + 1, end_frame - start_frame)
@@ -776,26 +1063,101 @@ class VideoGenerator:
     
     def _generate_frames_parallel(self, output_dir: str, start_frame: int,
                                   end_frame: int, progress_callback=None) -> int:
-        """Generate frames in parallel using multiprocessing."""
-        # Note: Multiprocessing with PIL and complex objects can be tricky
-        # For now, use sequential with batching for better progress reporting
-        batch_size = 30
+        """Generate frames in parallel; each worker saves its own chunk of PNGs."""
+        renderer = ParallelFrameRenderer(
+            self, self._get_render_workers(), self.settings.get('parallel_chunk_frames', 48)
+        )
         frames_generated = 0
         
-        for batch_start in range(start_frame, end_frame, batch_size):
-            batch_end = min(batch_start + batch_size, end_frame)
+        for chunk_start, chunk_end, _ in renderer.iter_chunks(start_frame, end_frame, output_dir):
+            frames_generated += chunk_end - chunk_start
             
-            for frame_num in range(batch_start, batch_end):
-                frame = self.generate_frame(frame_num)
-                frame_path = os.path.join(output_dir, f'frame_{frame_num:06d}.png')
-                frame.save(frame_path, optimize=False)
-                frames_generated += 1
-                
-                if progress_callback:
-                    progress_callback(frames_generated, end_frame - start_frame)
+            if progress_callback:
+                progress_callback(frames_generated, end_frame - start_frame)
         
         return frames_generated
     
+    def iter_frames(self, start_frame: int, end_frame: int, pix_fmt: str = 'rgb24'):
+        """
+        Render frames in order, on the worker pool when it is worthwhile.
+        
+        Args:
+            start_frame: Starting frame number
+            end_frame: Ending frame number (exclusive)
+            pix_fmt: Raw frame format: 'rgb24', 'yuv420p' or 'nv12'
+            
+        Yields:
+            Raw frames: the reused compositor buffer (sequential, consume before
+            the next frame) or bytes (parallel)
+        """
+        if self._should_render_parallel(end_frame - start_frame):
+            renderer = ParallelFrameRenderer(
+                self, self._get_render_workers(), self.settings.get('parallel_chunk_frames', 48)
+            )
+            for _, _, frames in renderer.iter_chunks(start_frame, end_frame, pix_fmt=pix_fmt):
+                yield from frames
+        else:
+            self.seek(start_frame)
+            for frame_num in range(start_frame, end_frame):
+                yield self.render_frame(frame_num, pix_fmt)
+    
+    def _get_encoder(self) -> EncoderConfig:
+        """
+        Get the video encoder for this render, probing hardware encoders on first use.
+        
+        Returns:
+            Encoder configuration
+        """
+        if self._encoder is None:
+            self._encoder = select_encoder(self.settings)
+            get_logger().info(f"Video encoder: {self._encoder.vcodec} ({self._encoder.backend})")
+        return self._encoder
+    
+    def _fall_back_to_software_encoder(self) -> bool:
+        """
+        Switch to the software encoder after a hardware encoder failed.
+        
+        Returns:
+            True if the encoder changed and encoding should be retried
+        """
+        if not self._get_encoder().hardware:
+            return False
+        get_logger().warning(f"{self._encoder.vcodec} failed, retrying with software encoding...")
+        self._encoder = select_encoder(self.settings, use_hardware=False)
+        return True
+    
+    def _yuv_full_range(self) -> bool:
+        """Whether YUV frames use full (0-255) instead of limited range."""
+        return self.plan.yuv_full_range
+    
+    def _get_output_args(self, yuv_input: bool = False,
+                         gop_frames: Optional[int] = None) -> Dict[str, Any]:
+        """
+        Build ffmpeg output arguments from encoding settings.
+        
+        Args:
+            yuv_input: Frames arrive as BT.709 YUV from the compositor; the stream
+                       is tagged accordingly
+            gop_frames: Force fixed-length closed GOPs of this many frames (segments)
+        
+        Returns:
+            Dictionary of ffmpeg output arguments
+        """
+        encoder = self._get_encoder()
+        output_args = dict(encoder.output_args)
+        if gop_frames:
+            output_args.update(fixed_gop_args(encoder, gop_frames))
+        if encoder.video_filter:
+            output_args['vf'] = encoder.video_filter
+        if yuv_input:
+            output_args.update({
+                'colorspace': 'bt709',
+                'color_primaries': 'bt709',
+                'color_trc': 'bt709',
+                'color_range': 'pc' if self._yuv_full_range() else 'tv',
+            })
+        return output_args
+    
     def assemble_video(self, frames_dir: str, output_path: str, audio_path: str) -> bool:
         """
         Assemble frames into video using ffmpeg with hardware acceleration.
@@ -818,77 +1180,223 @@ class VideoGenerator:
             # Create ffmpeg input for audio
             audio_input = ffmpeg.input(audio_path)
             
-            # Get encoding settings
-            encoding_preset = self.settings.get('encoding_preset', 'medium')
-            use_hw_accel = self.settings.get('use_hardware_acceleration', True)
-            quality_preset = self.settings.get('quality_preset', 'balanced')
-            
-            # Determine video codec and settings
-            if use_hw_accel:
-                # Try hardware acceleration (macOS VideoToolbox)
-                try:
-                    import platform
-                    if platform.system() == 'Darwin':  # macOS
-                        vcodec = 'h264_videotoolbox'
-                        # VideoToolbox doesn't use presets, use quality/bitrate instead
-                        extra_args = {'b:v': video_bitrate}
-                    else:
-                        # Fallback to software encoding
-                        vcodec = 'libx264'
-                        extra_args = {'preset': encoding_preset, 'crf': '23'}
-                except:
-                    vcodec = 'libx264'
-                    extra_args = {'preset': encoding_preset, 'crf': '23'}
-            else:
-                vcodec = 'libx264'
-                # Add CRF for better quality control
-                extra_args = {'preset': encoding_preset, 'crf': '23'}
-            
-            # Set bitrate based on quality preset
-            if quality_preset == 'fast':
-                video_bitrate = '3000k'
-                audio_bitrate = '128k'
-            elif quality_preset == 'high':
-                video_bitrate = '8000k'
-                audio_bitrate = '256k'
-            else:  # balanced
-                video_bitrate = '5000k'
-                audio_bitrate = '192k'
-            
-            # Combine video and audio
-            output_args = {
-                'vcodec': vcodec,
-                'acodec': 'aac',
-                'pix_fmt': 'yuv420p',
-                'b:v': video_bitrate,
-                'b:a': audio_bitrate,
-                **extra_args
-            }
-            
             output = ffmpeg.output(
                 frame_input.video,
                 audio_input.audio,
                 output_path,
-                **output_args
+                **self._get_output_args()
             )
             
             # Overwrite output file if exists
             output = ffmpeg.overwrite_output(output)
+            if self._get_encoder().global_args:
+                output = output.global_args(*self._get_encoder().global_args)
             
             # Run ffmpeg
-            ffmpeg.run(output, quiet=True, overwrite_output=True)
+            with profiler.span('assemble_video'):
+                ffmpeg.run(output, quiet=True, overwrite_output=True)
             
             return True
         except Exception as e:
             logger = get_logger()
             logger.error(f"Error assembling video: {e}", exc_info=True)
             # Try fallback without hardware acceleration
-            if use_hw_accel:
-                logger.warning("Retrying without hardware acceleration...")
-                self.settings['use_hardware_acceleration'] = False
+            if self._fall_back_to_software_encoder():
                 return self.assemble_video(frames_dir, output_path, audio_path)
             return False
     
+    def _build_pipeline(self, start_frame: int, end_frame: int, pix_fmt: str):
+        """
+        Build the staged render pipeline for a frame range.
+        
+        Sequential rendering runs as features -> background -> render stages,
+        each in its own thread; the render stage copies frames into recycled
+        pool buffers. With worker processes, the pool's frames are the source.
+        
+        Args:
+            start_frame: Starting frame number
+            end_frame: Ending frame number (exclusive)
+            pix_fmt: Raw frame format ('rgb24', 'yuv420p' or 'nv12')
+        
+        Returns:
+            (pipeline, frame pool) tuple; the pool is None when frames arrive as bytes
+        """
+        pipeline = RenderPipeline(self.settings.get('pipeline_queue_size', 4))
+        if self._should_render_parallel(end_frame - start_frame):
+            # Worker processes render whole frames, overlapped with encoding
+            pipeline.source('render', self.iter_frames(start_frame, end_frame, pix_fmt))
+            return pipeline, None
+        
+        self.seek(start_frame)
+        if pix_fmt in YUV_FORMATS:
+            frame_bytes = yuv420_frame_size(self.width, self.height)
+        else:
+            frame_bytes = self.width * self.height * 3
+        # Enough buffers for every queue slot after rendering plus the one being encoded
+        pool = pipeline.set_frame_pool(frame_bytes, pipeline.queue_size + 2)
+        compositor = self.compositor
+        render_thread = []
+        
+        def render(job: FrameJob) -> np.ndarray:
+            if not render_thread:
+                compositor.make_current()
+                render_thread.append(True)
+            output = self._compose_frame(job, pix_fmt)
+            buffer = pool.acquire()
+            np.copyto(buffer, output.reshape(-1))
+            return buffer
+        
+        pipeline.source('features', (self._prepare_frame(n) for n in range(start_frame, end_frame)))
+        pipeline.stage('background', self._load_frame_background)
+        pipeline.stage('render', render)
+        return pipeline, pool
+    
+    def get_pipeline_stats(self) -> Optional[Dict[str, Dict[str, Any]]]:
+        """
+        Get per-stage queue depth and throughput of the running render pipeline.
+        
+        Returns:
+            Stage statistics (see RenderPipeline.snapshot), or None when not streaming
+        """
+        return self._pipeline.snapshot() if self._pipeline is not None else None
+    
+    def _log_pipeline_stats(self, pipeline: RenderPipeline) -> None:
+        """Log the throughput of each pipeline stage and the limiting one."""
+        logger = get_logger()
+        for name, stats in pipeline.snapshot().items():
+            if 'fps' in stats:
+                logger.info(f"Pipeline stage {name}: {stats['items']} frames, {stats['fps']:.1f} fps, "
+                            f"{stats['utilization'] * 100:.0f}% busy")
+        logger.info(f"Pipeline bottleneck: {pipeline.bottleneck()}")
+    
+    def _report_profile(self, stage_profiler: profiler.Profiler, parallel: bool) -> None:
+        """
+        Log the per-stage timings of a render, export its trace and start over for the next one.
+        
+        Args:
+            stage_profiler: Profiler of the render
+            parallel: Frames were rendered by worker processes, whose stages are not timed here
+        """
+        if parallel:
+            stage_profiler.log_summary("Stage timings (frame stages ran in worker processes and are not included):")
+        else:
+            stage_profiler.log_summary("Stage timings:")
+        
+        logger = get_logger()
+        trace_path = self.settings.get('profile_trace_path', '')
+        if trace_path and stage_profiler.export_trace(trace_path):
+            logger.info(f"Trace written to {trace_path} (open in ui.perfetto.dev or chrome://tracing)")
+        stage_profiler.reset()
+    
+    def stream_video(self, output_path: str, audio_path: Optional[str], start_frame: int,
+                     end_frame: int, progress_callback=None,
+                     gop_frames: Optional[int] = None) -> bool:
+        """
+        Render frames straight into a running ffmpeg process (rawvideo over stdin).
+        
+        Frames flow through the staged pipeline, so background decode, rendering
+        and encoding overlap; a slow encoder stalls the stages through their
+        bounded queues. No intermediate PNGs are written.
+        
+        Args:
+            output_path: Output video path
+            audio_path: Path to audio file (None writes video only)
+            start_frame: Starting frame number
+            end_frame: Ending frame number (exclusive)
+            progress_callback: Callback function(frame_number, total_frames)
+            gop_frames: Force fixed-length closed GOPs of this many frames
+            
+        Returns:
+            True if successful, False otherwise
+        """
+        # Frames are converted to the encoder's native 4:2:0 layout while compositing,
+        # so ffmpeg passes them through without swscale
+        encoder = self._get_encoder()
+        pix_fmt = encoder.upload_pix_fmt
+        output_args = self._get_output_args(yuv_input=True, gop_frames=gop_frames)
+        if not audio_path:
+            output_args.pop('acodec', None)
+            output_args.pop('b:a', None)
+        writer = FFmpegPipeWriter(
+            output_path, self.width, self.height, self.frame_rate,
+            output_args, audio_path=audio_path, pix_fmt=pix_fmt,
+            global_args=encoder.global_args,
+            input_args={'color_range': 'pc' if self._yuv_full_range() else 'tv'}
+        )
+        
+        pipeline, pool = self._build_pipeline(start_frame, end_frame, pix_fmt)
+        total = end_frame - start_frame
+        frames_written = 0
+        encoder_failed = False  # ffmpeg did not start or rejected the first frame
+        
+        def feed_encoder(frame):
+            nonlocal frames_written, encoder_failed
+            with profiler.span('encode.write'):
+                try:
+                    writer.write_frame(frame)
+                except IOError:
+                    encoder_failed = writer.frames_written == 0
+                    raise
+            if pool is not None:
+                pool.release(frame)
+            
+            frames_written += 1
+            if progress_callback:
+                progress_callback(frames_written, total)
+        
+        try:
+            try:
+                writer.start()
+            except Exception:
+                encoder_failed = True
+                raise
+            self._pipeline = pipeline
+            pipeline.run('encode', feed_encoder)
+            self._log_pipeline_stats(pipeline)
+            
+            if writer.close():
+                return True
+            raise IOError("ffmpeg failed to finalize the output")
+        except Exception as e:
+            writer.abort()
+            logger = get_logger()
+            logger.error(f"Error streaming video: {e}", exc_info=True)
+            # Only an encoder that never took a frame is retried in software; render and
+            # pipeline errors, or failures mid-stream, would just fail again
+            if encoder_failed and self._fall_back_to_software_encoder():
+                return self.stream_video(output_path, audio_path, start_frame,
+                                         end_frame, progress_callback, gop_frames)
+            return False
+    
+    def render_segment(self, output_path: str, start_frame: int, end_frame: int,
+                       gop_frames: int, progress_callback=None) -> bool:
+        """
+        Encode frames [start_frame, end_frame) as a video-only segment.
+        
+        GOPs are fixed-length and closed, so when start_frame is a multiple of
+        gop_frames the segment starts with the keyframe a continuous encode
+        would place there, and segments join with ffmpeg's concat demuxer
+        without re-encoding. Stateful visualizers and overlays are replayed up
+        to start_frame and random effects are seeded per frame, so the frames
+        at a boundary match a continuous render exactly.
+        
+        Args:
+            output_path: Segment video path
+            start_frame: Starting frame number
+            end_frame: Ending frame number (exclusive)
+            gop_frames: Frames per GOP
+            progress_callback: Callback function(frame_number, total_frames)
+        
+        Returns:
+            True if successful, False otherwise
+        """
+        logger = get_logger()
+        if start_frame % gop_frames:
+            logger.warning(f"Segment start {start_frame} is not on a {gop_frames}-frame GOP boundary")
+        logger.info(f"Rendering segment frames {start_frame}-{end_frame} to {output_path}")
+        return self.stream_video(output_path, None, start_frame, end_frame,
+                                 progress_callback, gop_frames=gop_frames)
+    
     def generate_video(self, output_path: str, progress_callback=None, 
                       preview_seconds: Optional[int] = None, status_callback=None) -> bool:
         """
@@ -905,9 +1413,13 @@ class VideoGenerator:
         """
         try:
             start_time = time.time()
+            stage_profiler = profiler.configure(self.settings)
+            if stage_profiler is not None:
+                # Time this render only, not preview frames rendered before it
+                stage_profiler.reset()
             
-            # Create temp directory for frames
-            temp_dir = self._create_temp_dir()
+            # 'pipe' streams raw frames into ffmpeg; 'png' keeps the temp-frame path for debugging
+            output_mode = self.settings.get('output_mode', 'pipe')
             
             # Calculate frame range
             audio_duration = self.audio_processor.get_duration()
@@ -949,46 +1461,68 @@ class VideoGenerator:
                     remaining_frames = total - current
                     eta = remaining_frames / fps if fps > 0 else 0
                     
-                    status_callback({
+                    status = {
                         'stage': 'generating_frames',
                         'current_frame': current,
                         'total_frames': total,
                         'fps': fps,
                         'eta_seconds': eta
-                    })
-            
-            self.generate_frames(temp_dir, 0, total_frames, enhanced_progress)
+                    }
+                    pipeline_stats = self.get_pipeline_stats()
+                    if pipeline_stats is not None:
+                        # Per-stage queue depth and throughput, to see which stage limits
+                        status['pipeline'] = pipeline_stats
+                    if stage_profiler is not None:
+                        # Time histograms of each render stage, to see what a frame spends on
+                        status['stages'] = stage_profiler.snapshot()
+                    status_callback(status)
             
-            # Assemble video
-            if progress_callback:
-                progress_callback(total_frames, total_frames + 1)
-            
-            if status_callback:
-                status_callback({
-                    'stage': 'encoding_video',
-                    'current_frame': total_frames,
-                    'total_frames': total_frames,
-                    'fps': 0,
-                    'eta_seconds': 0
-                })
-            
-            success = self.assemble_video(temp_dir, output_path, self.audio_processor.audio_path)
-            
-            # Cleanup
-            self._cleanup_temp_dir()
+            audio_path = self.audio_processor.audio_path
+            if output_mode == 'png':
+                # Create temp directory for frames
+                temp_dir = self._create_temp_dir()
+                self.generate_frames(temp_dir, 0, total_frames, enhanced_progress)
+                
+                # Assemble video
+                if progress_callback:
+                    progress_callback(total_frames, total_frames + 1)
+                
+                if status_callback:
+                    status_callback({
+                        'stage': 'encoding_video',
+                        'current_frame': total_frames,
+                        'total_frames': total_frames,
+                        'fps': 0,
+                        'eta_seconds': 0
+                    })
+                
+                success = self.assemble_video(temp_dir, output_path, audio_path)
+                
+                # Cleanup
+                self._cleanup_temp_dir()
+            else:
+                logger.info("Streaming frames to ffmpeg (rawvideo pipe)")
+                success = self.stream_video(output_path, audio_path, 0, total_frames,
+                                            enhanced_progress)
             
             if progress_callback:
                 progress_callback(total_frames + 1, total_frames + 1)
             
             if status_callback:
                 total_time = time.time() - start_time
-                status_callback({
+                status = {
                     'stage': 'complete',
                     'current_frame': total_frames,
                     'total_frames': total_frames,
                     'fps': total_frames / total_time if total_time > 0 else 0,
                     'total_time': total_time
-                })
+                }
+                if stage_profiler is not None:
+                    status['stages'] = stage_profiler.snapshot()
+                status_callback(status)
+            
+            if stage_profiler is not None:
+                self._report_profile(stage_profiler, self._should_render_parallel(total_frames))
             
             return success
         except Exception as e:
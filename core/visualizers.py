@@ -5,13 +5,74 @@ Implements various visualizer types with customizable colors and effects.
 
 import numpy as np
 from PIL import Image, ImageDraw
-from typing import Tuple, Optional, Dict, Any
+from typing import Tuple, Optional, Dict, Any, Callable
 import math
 
+from core import raster
+from core.blur import GlowKernel
+from core.layers import Box, Layer
+from core.particles import ParticleSystem, particle_box, splat, disc_stamp
+from core.random_state import frame_rng
+
+
+# Particle fields shared by the particle visualizers
+PARTICLE_FIELDS = {
+    'x': np.float32, 'y': np.float32, 'vx': np.float32, 'vy': np.float32,
+    'life': np.float32, 'color': (np.uint8, 3), 'size': np.int32,
+}
+
+
+def _splat_particles(layer: Layer, particles: ParticleSystem) -> None:
+    """
+    Draw particles as discs whose alpha fades with their remaining life.
+    
+    Only the box the particles cover is read back and written to the layer.
+    
+    Args:
+        layer: Layer to draw into
+        particles: Particle system with PARTICLE_FIELDS
+    """
+    box = particle_box(particles['x'], particles['y'], particles['size'])
+    box = layer.clip(box) if box is not None else None
+    if box is None:
+        return
+    
+    colors = np.empty((len(particles), 4), dtype=np.uint8)
+    colors[:, :3] = particles['color']
+    colors[:, 3] = (255 * particles['life']).astype(np.uint8)
+    
+    pixels = layer.region(box)
+    splat(pixels, particles['x'], particles['y'], colors, particles['size'], disc_stamp, box[:2])
+    layer.put_region(pixels, box)
+
+
+def _rasterize(layer: Layer, box: Optional[Box], draw: Callable[[np.ndarray, Tuple[int, int]], None]) -> None:
+    """
+    Run a raster kernel over the region of the layer that the shapes cover.
+    
+    Args:
+        layer: Layer to draw into
+        box: Unclipped box the shapes can draw into, or None when there are none
+        draw: Function(pixels, origin) drawing into the region's RGBA array
+    """
+    box = layer.clip(box) if box is not None else None
+    if box is None:
+        return
+    
+    pixels = layer.region(box)
+    draw(pixels, box[:2])
+    layer.put_region(pixels, box)
+
 
 class BaseVisualizer:
     """Base class for all visualizers."""
     
+    # Visualizers that carry state between frames (particles, rings) set this
+    stateful = False
+    
+    # Magnitude quantization steps of the color palettes
+    PALETTE_LEVELS = 256
+    
     def __init__(self, width: int, height: int, settings: Dict[str, Any]):
         """
         Initialize visualizer.
@@ -24,6 +85,59 @@ class BaseVisualizer:
         self.width = width
         self.height = height
         self.settings = settings
+        self.seed = settings.get('random_seed', 0)
+        self._next_frame = 0
+        # Compiled color palettes keyed by gradient settings and element count
+        self._palettes: Dict[tuple, np.ndarray] = {}
+        # Layer reused for every frame, only the drawn region is cleared
+        self.layer = Layer(width, height)
+    
+    def reset(self) -> None:
+        """Reset simulation state to before frame 0."""
+        pass
+    
+    def advance(self, bands: np.ndarray, frame_number: int) -> None:
+        """
+        Update simulation state for one frame without drawing.
+        
+        Args:
+            bands: Frequency band magnitudes
+            frame_number: Frame number being advanced
+        """
+        pass
+    
+    def step(self, bands: np.ndarray, frame_number: int) -> None:
+        """Advance state by one frame and remember where the simulation is."""
+        self.advance(bands, frame_number)
+        self._next_frame = frame_number + 1
+    
+    def seek(self, frame_number: int, get_bands: Callable[[int], np.ndarray]) -> None:
+        """
+        Bring state to exactly where it is just before rendering frame_number.
+        
+        Seeking forward replays only the missing frames; seeking backward
+        replays from frame 0. Randomness is derived per frame, so the result
+        is identical to rendering every frame in order.
+        
+        Args:
+            frame_number: Frame that will be rendered next
+            get_bands: Function(frame_number) returning band magnitudes
+        """
+        if not self.stateful:
+            return
+        
+        if self._next_frame > frame_number:
+            self.reset()
+            self._next_frame = 0
+        
+        for f in range(self._next_frame, frame_number):
+            self.step(get_bands(f), f)
+    
+    def _normalize_bands(self, bands: np.ndarray) -> np.ndarray:
+        """Normalize bands to 0.0-1.0 by the frame maximum."""
+        if np.max(bands) > 0:
+            return bands / np.max(bands)
+        return bands
     
     def render(self, bands: np.ndarray, spectrum_data: np.ndarray, 
                frame_number: int) -> Image.Image:
@@ -34,12 +148,44 @@ class BaseVisualizer:
             bands: Frequency band magnitudes
             spectrum_data: Full spectrum data
             frame_number: Current frame number
-            
+        
         Returns:
             PIL Image with visualization
         """
         raise NotImplementedError("Subclasses must implement render()")
     
+    def render_layer(self, bands: np.ndarray, spectrum_data: np.ndarray,
+                     frame_number: int) -> Layer:
+        """
+        Render visualization into the reusable layer and report its dirty box.
+        
+        Args:
+            bands: Frequency band magnitudes
+            spectrum_data: Full spectrum data
+            frame_number: Current frame number
+        
+        Returns:
+            Layer with the visualization (reused by the next call)
+        """
+        image = self.render(bands, spectrum_data, frame_number)
+        if image is not self.layer.image:
+            # Visualizer drew into an image of its own
+            self.layer.begin()
+            self.layer.paste(image.convert('RGBA') if image.mode != 'RGBA' else image,
+                             (0, 0, self.width, self.height))
+        self.layer.finish()
+        return self.layer
+    
+    def _begin_layer(self) -> Tuple[Image.Image, ImageDraw.ImageDraw]:
+        """
+        Start drawing a frame into the reusable layer.
+        
+        Returns:
+            (image, draw) for the cleared layer; render() returns the image
+        """
+        self.layer.begin()
+        return self.layer.canvas()
+    
     def get_color(self, index: int, total: int, magnitude: float) -> Tuple[int, int, int, int]:
         """
         Get color for visualization based on gradient settings.
@@ -48,32 +194,98 @@ class BaseVisualizer:
             index: Current index
             total: Total number of elements
             magnitude: Magnitude value (0.0 to 1.0)
-            
+        
         Returns:
             RGBA color tuple
         """
+        return tuple(self.get_colors(index, total, magnitude)[0].tolist())
+    
+    def get_colors(self, indices, total: int, magnitudes) -> np.ndarray:
+        """
+        Get colors for many elements at once from the precomputed palette.
+        
+        Args:
+            indices: Element index or array of indices
+            total: Total number of elements
+            magnitudes: Magnitude value or array of values (0.0 to 1.0)
+        
+        Returns:
+            (N, 4) uint8 array of RGBA colors
+        """
+        palette = self.get_palette(total)
+        indices = np.clip(np.atleast_1d(np.asarray(indices, dtype=np.intp)), 0, palette.shape[0] - 1)
+        levels = np.atleast_1d(np.asarray(magnitudes, dtype=np.float32)) * (self.PALETTE_LEVELS - 1) + 0.5
+        np.clip(levels, 0, self.PALETTE_LEVELS - 1, out=levels)
+        return palette[indices, levels.astype(np.intp)]
+    
+    def get_color_tuples(self, indices, total: int, magnitudes) -> list:
+        """Get colors as RGBA tuples, the form ImageDraw accepts as fill."""
+        return [tuple(color) for color in self.get_colors(indices, total, magnitudes).tolist()]
+    
+    def get_palette(self, total: int) -> np.ndarray:
+        """
+        Get the palette for the current gradient and element count.
+        
+        The palette is a (total, PALETTE_LEVELS, 4) uint8 lookup table indexed by
+        element index and quantized magnitude. It is compiled once from the
+        gradient functions and reused for every frame of the render.
+        
+        Args:
+            total: Total number of elements
+        
+        Returns:
+            Palette array
+        """
+        total = max(int(total), 1)
         gradient_type = self.settings.get('color_gradient', 'frequency-based')
+        key = (
+            gradient_type, total,
+            tuple(self.settings.get('custom_color_start', [255, 0, 255])),
+            tuple(self.settings.get('custom_color_end', [0, 255, 255])),
+            tuple(self.settings.get('monochrome_color', [255, 255, 255])),
+        )
+        palette = self._palettes.get(key)
+        if palette is None:
+            gradient = self._gradient_function(gradient_type)
+            magnitudes = np.linspace(0.0, 1.0, self.PALETTE_LEVELS).tolist()
+            colors = [
+                [gradient(index, total, magnitude) for magnitude in magnitudes]
+                for index in range(total)
+            ]
+            palette = np.clip(np.array(colors), 0, 255).astype(np.uint8)
+            self._palettes[key] = palette
+        return palette
+    
+    def _gradient_function(self, gradient_type: str) -> Callable[[int, int, float], Tuple[int, int, int, int]]:
+        """
+        Get the scalar color function for a gradient type.
         
+        Args:
+            gradient_type: Gradient name from settings
+        
+        Returns:
+            Function(index, total, magnitude) returning an RGBA tuple
+        """
         if gradient_type == 'pitch_rainbow':
-            return self._pitch_rainbow_color(index, total, magnitude)
+            return self._pitch_rainbow_color
         elif gradient_type == 'frequency-based':
-            return self._frequency_based_color(index, total, magnitude)
+            return self._frequency_based_color
         elif gradient_type == 'energy-based':
-            return self._energy_based_color(magnitude)
+            return lambda index, total, magnitude: self._energy_based_color(magnitude)
         elif gradient_type == 'custom':
-            return self._custom_color(index, total, magnitude)
+            return self._custom_color
         elif gradient_type == 'monochrome':
-            return self._monochrome_color(magnitude)
+            return lambda index, total, magnitude: self._monochrome_color(magnitude)
         elif gradient_type == 'neon':
-            return self._neon_color(index, total, magnitude)
+            return self._neon_color
         elif gradient_type == 'sunset':
-            return self._sunset_color(index, total, magnitude)
+            return self._sunset_color
         elif gradient_type == 'ocean':
-            return self._ocean_color(index, total, magnitude)
+            return self._ocean_color
         elif gradient_type == 'fire':
-            return self._fire_color(magnitude)
+            return lambda index, total, magnitude: self._fire_color(magnitude)
         else:
-            return self._frequency_based_color(index, total, magnitude)
+            return self._frequency_based_color
     
     def _pitch_rainbow_color(self, index: int, total: int, magnitude: float) -> Tuple[int, int, int, int]:
         """Rainbow spectrum based on pitch/frequency."""
@@ -287,33 +499,23 @@ class BarsVisualizer(BaseVisualizer):
         bar_width = self.width // num_bands
         bar_spacing = 2
         
-        # Create transparent image
-        img = Image.new('RGBA', (self.width, self.height), (0, 0, 0, 0))
-        draw = ImageDraw.Draw(img)
+        self.layer.begin()
         
         # Normalize bands
-        if np.max(bands) > 0:
-            normalized_bands = bands / np.max(bands)
-        else:
-            normalized_bands = bands
+        normalized_bands = self._normalize_bands(bands)
         
-        # Draw bars
-        for i, magnitude in enumerate(normalized_bands):
-            bar_height = int(magnitude * self.height * 0.8)
-            x = i * bar_width + bar_spacing
-            
-            color = self.get_color(i, num_bands, magnitude)
-            
-            # Draw bar from bottom
-            # Ensure bar_height doesn't exceed height and coordinates are valid
-            bar_height = min(bar_height, self.height)
-            y1 = max(0, self.height - bar_height)
-            y2 = self.height
-            # Ensure valid rectangle coordinates
-            if y1 < y2 and x < x + bar_width - bar_spacing:
-                draw.rectangle([x, y1, x + bar_width - bar_spacing, y2], fill=color)
+        # Bars from the bottom, heights floored to whole pixels like the GPU backend
+        bar_heights = np.minimum((normalized_bands * self.height * 0.8).astype(np.intp), self.height)
+        drawn = np.flatnonzero(bar_heights > 0) if bar_width > bar_spacing else np.arange(0)
+        x = drawn * bar_width + bar_spacing
+        boxes = np.stack([x, self.height - bar_heights[drawn],
+                          x + bar_width - bar_spacing + 1, np.full(len(drawn), self.height)], axis=1)
+        colors = self.get_colors(drawn, num_bands, normalized_bands[drawn])
         
-        return img
+        _rasterize(self.layer, raster.rects_box(boxes),
+                   lambda pixels, origin: raster.fill_rects(pixels, boxes, colors, origin=origin))
+        
+        return self.layer.image
 
 
 class FilledWaveformVisualizer(BaseVisualizer):
@@ -322,8 +524,7 @@ class FilledWaveformVisualizer(BaseVisualizer):
     def render(self, bands: np.ndarray, spectrum_data: np.ndarray, 
                frame_number: int) -> Image.Image:
         """Render filled waveform."""
-        img = Image.new('RGBA', (self.width, self.height), (0, 0, 0, 0))
-        draw = ImageDraw.Draw(img)
+        img, draw = self._begin_layer()
         
         num_points = len(bands)
         if num_points < 2:
@@ -366,8 +567,7 @@ class CircleVisualizer(BaseVisualizer):
     def render(self, bands: np.ndarray, spectrum_data: np.ndarray, 
                frame_number: int) -> Image.Image:
         """Render circular spectrum."""
-        img = Image.new('RGBA', (self.width, self.height), (0, 0, 0, 0))
-        draw = ImageDraw.Draw(img)
+        self.layer.begin()
         
         num_bands = len(bands)
         center_x = self.width // 2
@@ -376,30 +576,26 @@ class CircleVisualizer(BaseVisualizer):
         max_bar_length = min(self.width, self.height) // 3
         
         # Normalize bands
-        if np.max(bands) > 0:
-            normalized_bands = bands / np.max(bands)
-        else:
-            normalized_bands = bands
-        
-        # Draw bars radiating from center
-        for i, magnitude in enumerate(normalized_bands):
-            angle = (i / num_bands) * 2 * math.pi
-            bar_length = magnitude * max_bar_length
-            
-            # Start point
-            x1 = center_x + int(base_radius * math.cos(angle))
-            y1 = center_y + int(base_radius * math.sin(angle))
-            
-            # End point
-            x2 = center_x + int((base_radius + bar_length) * math.cos(angle))
-            y2 = center_y + int((base_radius + bar_length) * math.sin(angle))
-            
-            color = self.get_color(i, num_bands, magnitude)
-            
-            # Draw line with width
-            draw.line([(x1, y1), (x2, y2)], fill=color, width=3)
-        
-        return img
+        normalized_bands = self._normalize_bands(bands)
+        
+        # Bars radiating from center, end points truncated to whole pixels
+        angles = np.arange(num_bands) / num_bands * 2 * math.pi
+        cos, sin = np.cos(angles), np.sin(angles)
+        bar_lengths = normalized_bands * max_bar_length
+        x1 = center_x + np.trunc(base_radius * cos)
+        y1 = center_y + np.trunc(base_radius * sin)
+        x2 = center_x + np.trunc((base_radius + bar_lengths) * cos)
+        y2 = center_y + np.trunc((base_radius + bar_lengths) * sin)
+        
+        # Lines run through pixel centers; bands without a bar draw nothing
+        drawn = np.flatnonzero((x1 != x2) | (y1 != y2))
+        segments = np.stack([x1[drawn], y1[drawn], x2[drawn], y2[drawn]], axis=1) + 0.5
+        colors = self.get_colors(drawn, num_bands, normalized_bands[drawn])
+        
+        _rasterize(self.layer, raster.lines_box(segments, 3),
+                   lambda pixels, origin: raster.draw_lines(pixels, segments, 3, colors, origin))
+        
+        return self.layer.image
 
 
 class LineWaveformVisualizer(BaseVisualizer):
@@ -408,127 +604,110 @@ class LineWaveformVisualizer(BaseVisualizer):
     def render(self, bands: np.ndarray, spectrum_data: np.ndarray, 
                frame_number: int) -> Image.Image:
         """Render line waveform."""
-        img = Image.new('RGBA', (self.width, self.height), (0, 0, 0, 0))
-        draw = ImageDraw.Draw(img)
+        self.layer.begin()
         
         num_points = len(bands)
         if num_points < 2:
-            return img
+            return self.layer.image
         
         # Normalize bands
-        if np.max(bands) > 0:
-            normalized_bands = bands / np.max(bands)
-        else:
-            normalized_bands = bands
+        normalized_bands = self._normalize_bands(bands)
         
-        # Create waveform points
-        points = []
+        # Waveform points, alternating above and below center for waveform effect
         center_y = self.height // 2
+        indices = np.arange(num_points)
+        x = (indices * self.width // num_points).astype(np.float64)
+        wave_heights = (normalized_bands * self.height * 0.4).astype(np.intp)
+        y = np.where(indices % 2 == 0, center_y - wave_heights, center_y + wave_heights).astype(np.float64)
         
-        for i, magnitude in enumerate(normalized_bands):
-            x = int((i / num_points) * self.width)
-            # Alternate above and below center for waveform effect
-            wave_height = int(magnitude * self.height * 0.4)
-            if i % 2 == 0:
-                y = center_y - wave_height
-            else:
-                y = center_y + wave_height
-            points.append((x, y))
+        # Get average color
+        avg_magnitude = np.mean(normalized_bands)
+        color = self.get_colors(num_points // 2, num_points, avg_magnitude)[0]
         
-        # Draw line
-        if len(points) >= 2:
-            # Get average color
-            avg_magnitude = np.mean(normalized_bands)
-            color = self.get_color(num_points // 2, num_points, avg_magnitude)
-            
-            draw.line(points, fill=color, width=3)
+        # Line through the pixel centers of the points
+        segments = np.stack([x[:-1], y[:-1], x[1:], y[1:]], axis=1) + 0.5
+        _rasterize(self.layer, raster.lines_box(segments, 3),
+                   lambda pixels, origin: raster.draw_lines(pixels, segments, 3, color, origin))
         
-        return img
+        return self.layer.image
 
 
 class ParticleVisualizer(BaseVisualizer):
     """Particle system that reacts to audio."""
     
+    stateful = True
+    
     def __init__(self, width: int, height: int, settings: Dict[str, Any]):
         """Initialize particle visualizer."""
         super().__init__(width, height, settings)
-        self.particles = []
         self.max_particles = 200
+        self.particles = ParticleSystem(self.max_particles, PARTICLE_FIELDS)
+    
+    def reset(self) -> None:
+        """Remove all particles."""
+        self.particles.reset()
+    
+    def advance(self, bands: np.ndarray, frame_number: int) -> None:
+        """Spawn, move and cull particles for one frame."""
+        num_bands = len(bands)
+        normalized_bands = self._normalize_bands(bands)
+        rng = frame_rng(self.seed, frame_number, 'particle_visualizer')
+        
+        # Generate new particles based on audio intensity
+        spawn_bands = np.flatnonzero(normalized_bands > 0.3)[:self.particles.free]
+        magnitude = normalized_bands[spawn_bands]
+        n = len(spawn_bands)
+        
+        # Random velocity based on magnitude
+        velocity = (rng.random((n, 2)) - 0.5) * magnitude[:, None] * 20
+        
+        self.particles.spawn(
+            x=(spawn_bands / num_bands * self.width).astype(np.intp),
+            y=np.full(n, self.height // 2),
+            vx=velocity[:, 0],
+            vy=velocity[:, 1],
+            life=np.ones(n),
+            color=self.get_colors(spawn_bands, num_bands, magnitude)[:, :3],
+            size=(magnitude * 10).astype(np.intp) + 2
+        )
+        
+        # Update particles, applying gravity
+        p = self.particles
+        p['x'] += p['vx']
+        p['y'] += p['vy']
+        p['vy'] += 0.5
+        p['life'] -= 0.02
+        
+        # Keep particles still alive and in bounds
+        p.cull((p['life'] > 0) & self._in_bounds(p))
     
     def render(self, bands: np.ndarray, spectrum_data: np.ndarray, 
                frame_number: int) -> Image.Image:
         """Render particle system."""
-        img = Image.new('RGBA', (self.width, self.height), (0, 0, 0, 0))
-        draw = ImageDraw.Draw(img)
+        self.layer.begin()
         
-        num_bands = len(bands)
+        self.step(bands, frame_number)
         
-        # Normalize bands
-        if np.max(bands) > 0:
-            normalized_bands = bands / np.max(bands)
-        else:
-            normalized_bands = bands
+        # Draw particles, fading color based on life
+        _splat_particles(self.layer, self.particles)
         
-        # Generate new particles based on audio intensity
-        for i, magnitude in enumerate(normalized_bands):
-            if magnitude > 0.3 and len(self.particles) < self.max_particles:
-                # Create particle
-                x = int((i / num_bands) * self.width)
-                y = self.height // 2
-                
-                # Random velocity based on magnitude
-                vx = (np.random.random() - 0.5) * magnitude * 20
-                vy = (np.random.random() - 0.5) * magnitude * 20
-                
-                color = self.get_color(i, num_bands, magnitude)
-                
-                self.particles.append({
-                    'x': x,
-                    'y': y,
-                    'vx': vx,
-                    'vy': vy,
-                    'life': 1.0,
-                    'color': color,
-                    'size': int(magnitude * 10) + 2
-                })
-        
-        # Update and draw particles
-        new_particles = []
-        for particle in self.particles:
-            # Update position
-            particle['x'] += particle['vx']
-            particle['y'] += particle['vy']
-            
-            # Apply gravity
-            particle['vy'] += 0.5
-            
-            # Reduce life
-            particle['life'] -= 0.02
-            
-            # Keep particle if still alive and in bounds
-            if particle['life'] > 0:
-                # Draw particle
-                x = int(particle['x'])
-                y = int(particle['y'])
-                size = particle['size']
-                
-                # Fade color based on life
-                r, g, b, a = particle['color']
-                a = int(255 * particle['life'])
-                color = (r, g, b, a)
-                
-                if 0 <= x < self.width and 0 <= y < self.height:
-                    draw.ellipse([x - size, y - size, x + size, y + size], fill=color)
-                    new_particles.append(particle)
-        
-        self.particles = new_particles
-        
-        return img
+        return self.layer.image
+    
+    def _in_bounds(self, p: ParticleSystem) -> np.ndarray:
+        """Mask of particles whose pixel position lies inside the frame."""
+        x = p['x'].astype(np.intp)
+        y = p['y'].astype(np.intp)
+        return (x >= 0) & (x < self.width) & (y >= 0) & (y < self.height)
 
 
 class NCSBarsVisualizer(BaseVisualizer):
     """NCS (NoCopyrightSounds) style centered bars with glow effect."""
     
+    def __init__(self, width: int, height: int, settings: Dict[str, Any]):
+        """Initialize NCS bars visualizer."""
+        super().__init__(width, height, settings)
+        self._glow: Optional[GlowKernel] = None
+    
     def render(self, bands: np.ndarray, spectrum_data: np.ndarray, 
                frame_number: int) -> Image.Image:
         """Render NCS-style centered bars with glow."""
@@ -537,8 +716,7 @@ class NCSBarsVisualizer(BaseVisualizer):
         bar_spacing = 2
         
         # Create transparent image
-        img = Image.new('RGBA', (self.width, self.height), (0, 0, 0, 0))
-        draw = ImageDraw.Draw(img)
+        img, draw = self._begin_layer()
         
         # Normalize bands
         if np.max(bands) > 0:
@@ -549,11 +727,12 @@ class NCSBarsVisualizer(BaseVisualizer):
         # Draw bars centered vertically
         center_y = self.height // 2
         
+        colors = self.get_color_tuples(np.arange(num_bands), num_bands, normalized_bands)
         for i, magnitude in enumerate(normalized_bands):
             bar_height = int(magnitude * self.height * 0.4)
             x = i * bar_width + bar_spacing
             
-            color = self.get_color(i, num_bands, magnitude)
+            color = colors[i]
             
             # Draw bar symmetrically from center
             # Ensure bar_height doesn't exceed half height and coordinates are valid
@@ -565,27 +744,33 @@ class NCSBarsVisualizer(BaseVisualizer):
                 draw.rectangle([x, y1, x + bar_width - bar_spacing, y2], fill=color)
         
         # Apply glow effect
-        img = self._apply_glow(img, radius=15, iterations=2)
+        self._apply_glow(radius=15, iterations=2)
         
         return img
     
-    def _apply_glow(self, image: Image.Image, radius: int = 10, iterations: int = 2) -> Image.Image:
-        """Apply glow/bloom effect to image."""
-        from PIL import ImageFilter
-        
-        # Create a copy for glowing
-        glow = image.copy()
-        
-        # Apply multiple blur passes for stronger glow
-        for _ in range(iterations):
-            glow = glow.filter(ImageFilter.GaussianBlur(radius=radius))
-        
-        # Blend glow with original
-        result = Image.new('RGBA', image.size, (0, 0, 0, 0))
-        result = Image.alpha_composite(result, glow)
-        result = Image.alpha_composite(result, image)
+    def _apply_glow(self, radius: int = 10, iterations: int = 2) -> None:
+        """
+        Apply glow/bloom effect to the drawn region of the layer.
         
-        return result
+        Args:
+            radius: Blur radius of one pass
+            iterations: Number of blur passes the glow is equivalent to
+        """
+        box = self.layer.finish()
+        if box is None:
+            return
+        if self._glow is None:
+            self._glow = GlowKernel(self.width, self.height)
+        
+        # Repeated Gaussian passes add up to one wider Gaussian
+        sigma = radius * math.sqrt(iterations)
+        
+        # Glow only the drawn region plus the distance the glow spreads
+        margin = GlowKernel.margin(sigma)
+        box = self.layer.clip((box[0] - margin, box[1] - margin, box[2] + margin, box[3] + margin))
+        region = self.layer.region(box)
+        self._glow.apply(region, sigma)
+        self.layer.put_region(region, box)
 
 
 class DualSpectrumVisualizer(BaseVisualizer):
@@ -598,8 +783,7 @@ class DualSpectrumVisualizer(BaseVisualizer):
         bar_width = self.width // num_bands
         bar_spacing = 2
         
-        img = Image.new('RGBA', (self.width, self.height), (0, 0, 0, 0))
-        draw = ImageDraw.Draw(img)
+        img, draw = self._begin_layer()
         
         # Normalize bands
         if np.max(bands) > 0:
@@ -609,11 +793,12 @@ class DualSpectrumVisualizer(BaseVisualizer):
         
         center_y = self.height // 2
         
+        colors = self.get_color_tuples(np.arange(num_bands), num_bands, normalized_bands)
         for i, magnitude in enumerate(normalized_bands):
             bar_height = int(magnitude * self.height * 0.45)
             x = i * bar_width + bar_spacing
             
-            color = self.get_color(i, num_bands, magnitude)
+            color = colors[i]
             
             # Top bars (mirrored down from center)
             draw.rectangle([x, center_y - bar_height, x + bar_width - bar_spacing, center_y], fill=color)
@@ -627,27 +812,65 @@ class DualSpectrumVisualizer(BaseVisualizer):
 class WaveformParticleVisualizer(BaseVisualizer):
     """Hybrid waveform with particle effects."""
     
+    stateful = True
+    
     def __init__(self, width: int, height: int, settings: Dict[str, Any]):
         """Initialize hybrid visualizer."""
         super().__init__(width, height, settings)
-        self.particles = []
         self.max_particles = 150
+        self.particles = ParticleSystem(self.max_particles, PARTICLE_FIELDS)
+    
+    def reset(self) -> None:
+        """Remove all particles."""
+        self.particles.reset()
+    
+    def advance(self, bands: np.ndarray, frame_number: int) -> None:
+        """Spawn particles at peaks, then move and cull them."""
+        num_points = len(bands)
+        if num_points < 2:
+            return
+        
+        normalized_bands = self._normalize_bands(bands)
+        center_y = self.height // 2
+        rng = frame_rng(self.seed, frame_number, 'waveform_particle_visualizer')
+        
+        # Generate particles at peaks
+        spawn_points = np.flatnonzero(normalized_bands > 0.5)[:self.particles.free]
+        magnitude = normalized_bands[spawn_points]
+        n = len(spawn_points)
+        
+        self.particles.spawn(
+            x=(spawn_points / num_points * self.width).astype(np.intp),
+            y=center_y - (magnitude * self.height * 0.3).astype(np.intp),
+            vx=(rng.random(n) - 0.5) * 5,
+            vy=-rng.random(n) * 5,
+            life=np.ones(n),
+            color=self.get_colors(spawn_points, num_points, magnitude)[:, :3],
+            size=3
+        )
+        
+        # Update particles
+        p = self.particles
+        p['x'] += p['vx']
+        p['y'] += p['vy']
+        p['vy'] += 0.3  # gravity
+        p['life'] -= 0.03
+        
+        x = p['x'].astype(np.intp)
+        y = p['y'].astype(np.intp)
+        p.cull((p['life'] > 0) & (x >= 0) & (x < self.width) & (y >= 0) & (y < self.height))
     
     def render(self, bands: np.ndarray, spectrum_data: np.ndarray, 
                frame_number: int) -> Image.Image:
         """Render waveform with particles."""
-        img = Image.new('RGBA', (self.width, self.height), (0, 0, 0, 0))
-        draw = ImageDraw.Draw(img)
+        img, draw = self._begin_layer()
         
         num_points = len(bands)
         if num_points < 2:
             return img
         
         # Normalize bands
-        if np.max(bands) > 0:
-            normalized_bands = bands / np.max(bands)
-        else:
-            normalized_bands = bands
+        normalized_bands = self._normalize_bands(bands)
         
         # Draw waveform
         points = []
@@ -664,42 +887,10 @@ class WaveformParticleVisualizer(BaseVisualizer):
             color = self.get_color(num_points // 2, num_points, avg_magnitude)
             draw.line(points, fill=color, width=3)
         
-        # Generate particles at peaks
-        for i, magnitude in enumerate(normalized_bands):
-            if magnitude > 0.5 and len(self.particles) < self.max_particles:
-                x = int((i / num_points) * self.width)
-                y = center_y - int(magnitude * self.height * 0.3)
-                
-                vx = (np.random.random() - 0.5) * 5
-                vy = -np.random.random() * 5
-                
-                color = self.get_color(i, num_points, magnitude)
-                
-                self.particles.append({
-                    'x': x, 'y': y, 'vx': vx, 'vy': vy,
-                    'life': 1.0, 'color': color, 'size': 3
-                })
-        
-        # Update and draw particles
-        new_particles = []
-        for particle in self.particles:
-            particle['x'] += particle['vx']
-            particle['y'] += particle['vy']
-            particle['vy'] += 0.3  # gravity
-            particle['life'] -= 0.03
-            
-            if particle['life'] > 0:
-                x, y = int(particle['x']), int(particle['y'])
-                size = particle['size']
-                r, g, b, a = particle['color']
-                a = int(255 * particle['life'])
-                color = (r, g, b, a)
-                
-                if 0 <= x < self.width and 0 <= y < self.height:
-                    draw.ellipse([x - size, y - size, x + size, y + size], fill=color)
-                    new_particles.append(particle)
-        
-        self.particles = new_particles
+        self.step(bands, frame_number)
+        
+        # Draw particles over the waveform
+        _splat_particles(self.layer, self.particles)
         
         return img
 
@@ -710,91 +901,51 @@ class ModernGradientBarsVisualizer(BaseVisualizer):
     def render(self, bands: np.ndarray, spectrum_data: np.ndarray, 
                frame_number: int) -> Image.Image:
         """Render modern gradient bars."""
-        from PIL import ImageDraw
-        
         num_bands = len(bands)
         bar_width = max(10, self.width // num_bands)
         bar_spacing = 4
         
-        img = Image.new('RGBA', (self.width, self.height), (0, 0, 0, 0))
-        draw = ImageDraw.Draw(img)
+        self.layer.begin()
         
         # Normalize bands
-        if np.max(bands) > 0:
-            normalized_bands = bands / np.max(bands)
-        else:
-            normalized_bands = bands
+        normalized_bands = self._normalize_bands(bands)
         
-        for i, magnitude in enumerate(normalized_bands):
-            bar_height = int(magnitude * self.height * 0.8)
-            x = i * bar_width + bar_spacing
-            
-            # Get color
-            color = self.get_color(i, num_bands, magnitude)
-            
-            # Draw rounded rectangle
-            # Ensure bar_height doesn't exceed height and coordinates are valid
-            bar_height = min(bar_height, self.height)
-            y1 = max(0, self.height - bar_height)
-            y2 = self.height
-            
-            # Ensure valid rectangle coordinates before drawing
-            if y1 < y2 and x < x + bar_width - bar_spacing:
-                # Draw bar with rounded top
-                corner_radius = min(bar_width // 2, 10)
-                self._draw_rounded_rectangle(draw, [x, y1, x + bar_width - bar_spacing, y2], 
-                                            corner_radius, color)
+        bar_heights = np.minimum((normalized_bands * self.height * 0.8).astype(np.intp), self.height)
+        drawn = np.flatnonzero(bar_heights > 0) if bar_width > bar_spacing else np.arange(0)
+        bar_heights = bar_heights[drawn]
+        x = drawn * bar_width + bar_spacing
+        boxes = np.stack([x, self.height - bar_heights,
+                          x + bar_width - bar_spacing + 1, np.full(len(drawn), self.height)], axis=1)
+        colors = self.get_colors(drawn, num_bands, normalized_bands[drawn])
         
-        return img
-    
-    def _draw_rounded_rectangle(self, draw, coords, radius, fill):
-        """Draw a rounded rectangle."""
-        x1, y1, x2, y2 = coords
-        
-        # Validate coordinates
-        if x1 >= x2 or y1 >= y2:
-            return  # Invalid coordinates, skip drawing
+        # Rounded top corners, no wider than half the bar and no taller than half its height
+        corner_radius = np.minimum(min(10, (bar_width - bar_spacing) // 2), bar_heights // 2)
+        top_radius = np.where(corner_radius > 0, corner_radius + 0.5, 0.0)
         
-        # Ensure radius doesn't exceed rectangle dimensions
-        radius = min(radius, (x2 - x1) // 2, (y2 - y1) // 2)
-        if radius <= 0:
-            # If radius is invalid, just draw a regular rectangle
-            draw.rectangle([x1, y1, x2, y2], fill=fill)
-            return
+        _rasterize(self.layer, raster.rects_box(boxes),
+                   lambda pixels, origin: raster.fill_rects(pixels, boxes, colors, top_radius=top_radius,
+                                                            origin=origin))
         
-        # Draw main rectangle
-        if y1 + radius < y2:
-            draw.rectangle([x1, y1 + radius, x2, y2], fill=fill)
-        if x1 + radius < x2 - radius and y1 < y1 + radius:
-            draw.rectangle([x1 + radius, y1, x2 - radius, y1 + radius], fill=fill)
-        
-        # Draw corners (only if they fit)
-        if y1 + radius * 2 <= y2:
-            if x1 + radius * 2 <= x2:
-                draw.ellipse([x1, y1, x1 + radius * 2, y1 + radius * 2], fill=fill)
-            if x2 - radius * 2 >= x1:
-                draw.ellipse([x2 - radius * 2, y1, x2, y1 + radius * 2], fill=fill)
+        return self.layer.image
 
 
 class PulseRingVisualizer(BaseVisualizer):
     """Expanding rings that pulse with bass frequencies."""
     
+    stateful = True
+    
     def __init__(self, width: int, height: int, settings: Dict[str, Any]):
         """Initialize pulse ring visualizer."""
         super().__init__(width, height, settings)
         self.rings = []
     
-    def render(self, bands: np.ndarray, spectrum_data: np.ndarray, 
-               frame_number: int) -> Image.Image:
-        """Render expanding pulse rings."""
-        img = Image.new('RGBA', (self.width, self.height), (0, 0, 0, 0))
-        draw = ImageDraw.Draw(img)
-        
-        # Normalize bands
-        if np.max(bands) > 0:
-            normalized_bands = bands / np.max(bands)
-        else:
-            normalized_bands = bands
+    def reset(self) -> None:
+        """Remove all rings."""
+        self.rings = []
+    
+    def advance(self, bands: np.ndarray, frame_number: int) -> None:
+        """Spawn a ring on strong bass, then expand and cull rings."""
+        normalized_bands = self._normalize_bands(bands)
         
         # Get bass energy (low frequencies)
         bass_energy = np.mean(normalized_bands[:len(normalized_bands)//4])
@@ -815,28 +966,37 @@ class PulseRingVisualizer(BaseVisualizer):
                 'thickness': int(10 * bass_energy)
             })
         
-        # Update and draw rings
+        # Update rings
         new_rings = []
         for ring in self.rings:
             ring['radius'] += 5
             ring['life'] -= 0.02
             
             if ring['life'] > 0 and ring['radius'] < max(self.width, self.height):
-                r, g, b, a = ring['color']
-                a = int(255 * ring['life'])
-                color = (r, g, b, a)
-                
-                thickness = ring['thickness']
-                x, y = ring['x'], ring['y']
-                radius = ring['radius']
-                
-                # Draw ring
-                draw.ellipse([x - radius, y - radius, x + radius, y + radius], 
-                           outline=color, width=thickness)
-                
                 new_rings.append(ring)
         
         self.rings = new_rings
+    
+    def render(self, bands: np.ndarray, spectrum_data: np.ndarray, 
+               frame_number: int) -> Image.Image:
+        """Render expanding pulse rings."""
+        img, draw = self._begin_layer()
+        
+        self.step(bands, frame_number)
+        
+        # Draw rings
+        for ring in self.rings:
+            r, g, b, a = ring['color']
+            a = int(255 * ring['life'])
+            color = (r, g, b, a)
+            
+            thickness = ring['thickness']
+            x, y = ring['x'], ring['y']
+            radius = ring['radius']
+            
+            # Draw ring
+            draw.ellipse([x - radius, y - radius, x + radius, y + radius], 
+                       outline=color, width=thickness)
         
         return img
 
@@ -847,14 +1007,10 @@ class FrequencyDotsVisualizer(BaseVisualizer):
     def render(self, bands: np.ndarray, spectrum_data: np.ndarray, 
                frame_number: int) -> Image.Image:
         """Render frequency dots grid."""
-        img = Image.new('RGBA', (self.width, self.height), (0, 0, 0, 0))
-        draw = ImageDraw.Draw(img)
+        self.layer.begin()
         
         # Normalize bands
-        if np.max(bands) > 0:
-            normalized_bands = bands / np.max(bands)
-        else:
-            normalized_bands = bands
+        normalized_bands = self._normalize_bands(bands)
         
         # Grid configuration
         num_bands = len(bands)
@@ -864,34 +1020,41 @@ class FrequencyDotsVisualizer(BaseVisualizer):
         cell_width = self.width // cols
         cell_height = self.height // rows
         
-        for col in range(cols):
-            if col >= len(normalized_bands):
-                break
-                
-            magnitude = normalized_bands[col]
-            
-            # Number of active dots in column based on magnitude
-            active_rows = int(magnitude * rows)
-            
-            for row in range(active_rows):
-                x = col * cell_width + cell_width // 2
-                y = self.height - (row * cell_height) - cell_height // 2
-                
-                # Dot size based on magnitude
-                dot_size = int(5 + magnitude * 10)
-                
-                # Color based on frequency
-                color = self.get_color(col, cols, magnitude)
-                
-                draw.ellipse([x - dot_size, y - dot_size, x + dot_size, y + dot_size], 
-                           fill=color)
-        
-        return img
+        # Number of active dots in each column based on magnitude
+        num_cols = min(cols, len(normalized_bands))
+        magnitudes = normalized_bands[:num_cols]
+        active_rows = (magnitudes * rows).astype(np.intp)
+        
+        # One dot per active cell, column by column from the bottom row up
+        col = np.repeat(np.arange(num_cols), active_rows)
+        row = np.arange(len(col)) - np.repeat(np.cumsum(active_rows) - active_rows, active_rows)
+        x = col * cell_width + cell_width // 2
+        y = self.height - (row * cell_height) - cell_height // 2
+        
+        # Dot size based on magnitude, color based on frequency
+        dot_sizes = (5 + magnitudes * 10).astype(np.intp)
+        colors = self.get_colors(np.arange(num_cols), cols, magnitudes)
+        
+        # ImageDraw's ellipse box [x - d, y - d, x + d, y + d] spans 2d + 1 pixels
+        center_x, center_y = x + 0.5, y + 0.5
+        radii = dot_sizes[col] + 0.5
+        box = raster.rects_box(np.stack([center_x - radii, center_y - radii,
+                                         center_x + radii, center_y + radii], axis=1))
+        _rasterize(self.layer, box,
+                   lambda pixels, origin: raster.fill_discs(pixels, center_x, center_y, radii, colors[col],
+                                                            origin))
+        
+        return self.layer.image
 
 
 class VisualizerFactory:
     """Factory for creating visualizers."""
     
+    # Style names accepted by create()
+    STYLES = ('bars', 'filled_waveform', 'circle', 'line_waveform', 'particle', 'ncs_bars',
+              'dual_spectrum', 'waveform_particle', 'modern_gradient_bars', 'pulse_ring',
+              'frequency_dots')
+    
     @staticmethod
     def create(style: str, width: int, height: int, settings: Dict[str, Any]) -> BaseVisualizer:
         """
@@ -902,7 +1065,7 @@ class VisualizerFactory:
             width: Image width
             height: Image height
             settings: Settings dictionary
-            
+        
         Returns:
             Visualizer instance
         """
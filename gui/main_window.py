@@ -14,7 +14,10 @@ from PyQt5.QtGui import QColor
 from PIL import Image
 
 from gui.preview_widget import PreviewWidget
+from core import profiler
+from core.analysis_cache import AnalysisCache
 from core.audio_processor import AudioProcessor
+from core.preview import PreviewEngine
 from core.video_generator import VideoGenerator
 from core.settings import SettingsManager
 
@@ -69,6 +72,50 @@ class VideoGenerationThread(QThread):
             self.finished.emit(False, f"Error: {str(e)}")
 
 
+class AudioAnalysisThread(QThread):
+    """Thread for audio loading and analysis to prevent GUI freezing."""
+    
+    progress = pyqtSignal(str)  # status message
+    finished = pyqtSignal(bool, str)  # success, error message
+    
+    def __init__(self, audio_processor, settings):
+        """
+        Initialize audio analysis thread.
+        
+        Args:
+            audio_processor: AudioProcessor to load and analyze
+            settings: Settings dictionary (analysis and profiling settings)
+        """
+        super().__init__()
+        self.audio_processor = audio_processor
+        self.settings = settings
+    
+    def run(self):
+        """Run audio analysis."""
+        from core.logger import get_logger
+        logger = get_logger()
+        
+        try:
+            analysis_profiler = profiler.configure(self.settings)
+            if self.audio_processor.analysis_cache is not None:
+                # Cache hits only map the stored analysis; misses decode and analyze the track
+                self.progress.emit("Analyzing audio...")
+                self.audio_processor.analyze(
+                    frame_rate=self.settings.get('frame_rate', 30),
+                    stream_longer_than=self.settings.get('streaming_analysis_seconds', 1200)
+                )
+            else:
+                self.progress.emit("Loading audio...")
+                self.audio_processor.load_audio()
+            if analysis_profiler is not None:
+                analysis_profiler.log_summary("Audio analysis stage timings:")
+                analysis_profiler.reset()
+            self.finished.emit(True, "")
+        except Exception as e:
+            logger.error(f"Exception during audio analysis: {str(e)}", exc_info=True)
+            self.finished.emit(False, str(e))
+
+
 class MainWindow(QMainWindow):
     """Main application window."""
     
@@ -79,7 +126,11 @@ class MainWindow(QMainWindow):
         self.audio_processor = None
         self.video_generator = None
         self.generation_thread = None
-        self.preview_frames = []
+        self.audio_analysis_thread = None
+        self.retired_analysis_threads = []  # Superseded analyses kept alive until they finish
+        self.preview_stream_settings = None  # (settings, display size) of the streamed full preview
+        self.preview_engine = None
+        self.preview_generator_thread = None
         self.preview_update_timer = QTimer()
         self.preview_update_timer.setSingleShot(True)
         self.preview_update_timer.timeout.connect(self.generate_preview_frames)
@@ -825,6 +876,13 @@ class MainWindow(QMainWindow):
         self.encoding_preset_combo.currentTextChanged.connect(self.update_settings)
         encoding_layout.addWidget(self.encoding_preset_combo)
         
+        self.video_codec_combo = QComboBox()
+        self.video_codec_combo.addItems(["H.264", "HEVC (H.265)", "AV1"])
+        self.video_codec_combo.setCurrentText("H.264")
+        self.video_codec_combo.setToolTip("HEVC and AV1 give smaller files at the same quality; AV1 needs a recent GPU or ffmpeg with SVT-AV1.")
+        self.video_codec_combo.currentTextChanged.connect(self.update_settings)
+        encoding_layout.addWidget(self.video_codec_combo)
+        
         encoding_info = QLabel("Ultrafast: Fastest encoding, larger file size\nSlow: Slower encoding, smaller file size")
         encoding_info.setStyleSheet("color: #aaaaaa; font-size: 11px;")
         encoding_layout.addWidget(encoding_info)
@@ -836,18 +894,41 @@ class MainWindow(QMainWindow):
         hw_accel_group = QGroupBox("Hardware Acceleration")
         hw_accel_layout = QVBoxLayout()
         
-        self.hw_accel_checkbox = QCheckBox("Use Hardware Acceleration (macOS VideoToolbox)")
+        self.hw_accel_checkbox = QCheckBox("Use Hardware Encoder (NVENC, Quick Sync, VAAPI, VideoToolbox)")
         self.hw_accel_checkbox.setChecked(True)
         self.hw_accel_checkbox.stateChanged.connect(self.update_settings)
         hw_accel_layout.addWidget(self.hw_accel_checkbox)
         
-        hw_info = QLabel("Significantly faster on supported Macs.\nAutomatically falls back to software if unavailable.")
+        hw_info = QLabel("Significantly faster on NVIDIA, Intel and AMD GPUs and on Macs.\nAutomatically falls back to software if unavailable.")
         hw_info.setStyleSheet("color: #aaaaaa; font-size: 11px;")
         hw_accel_layout.addWidget(hw_info)
         
         hw_accel_group.setLayout(hw_accel_layout)
         layout.addWidget(hw_accel_group)
         
+        # Output Mode
+        output_mode_group = QGroupBox("Frame Output")
+        output_mode_layout = QVBoxLayout()
+        
+        self.png_frames_checkbox = QCheckBox("Write PNG frames to temp folder (debug)")
+        self.png_frames_checkbox.setChecked(False)
+        self.png_frames_checkbox.setToolTip("By default frames are streamed straight into ffmpeg. Enable to save every frame as PNG before encoding.")
+        self.png_frames_checkbox.stateChanged.connect(self.update_settings)
+        output_mode_layout.addWidget(self.png_frames_checkbox)
+        
+        self.gpu_render_checkbox = QCheckBox("Render on GPU (OpenGL)")
+        self.gpu_render_checkbox.setChecked(False)
+        self.gpu_render_checkbox.setToolTip("Composite frames and draw bar visualizers with OpenGL. Requires moderngl; falls back to CPU rendering when unavailable.")
+        self.gpu_render_checkbox.stateChanged.connect(self.update_settings)
+        output_mode_layout.addWidget(self.gpu_render_checkbox)
+        
+        output_mode_info = QLabel("Streaming is faster and needs no temp disk space.\nUse PNG frames only to inspect individual frames.")
+        output_mode_info.setStyleSheet("color: #aaaaaa; font-size: 11px;")
+        output_mode_layout.addWidget(output_mode_info)
+        
+        output_mode_group.setLayout(output_mode_layout)
+        layout.addWidget(output_mode_group)
+        
         # Resolution Quick Settings
         quick_res_group = QGroupBox("Quick Resolution")
         quick_res_layout = QVBoxLayout()
@@ -1118,6 +1199,8 @@ class MainWindow(QMainWindow):
         preview_group = QGroupBox("Video Preview")
         preview_layout = QVBoxLayout()
         self.preview_widget = PreviewWidget()
+        self.preview_widget.seek_requested.connect(self.on_preview_seek)
+        self.preview_widget.display_resized.connect(self.on_preview_resized)
         preview_layout.addWidget(self.preview_widget)
         
         # Preview Controls
@@ -1382,6 +1465,8 @@ class MainWindow(QMainWindow):
         layout.addWidget(preview_label)
         
         self.preview_widget = PreviewWidget()
+        self.preview_widget.seek_requested.connect(self.on_preview_seek)
+        self.preview_widget.display_resized.connect(self.on_preview_resized)
         layout.addWidget(self.preview_widget)
         
         panel.setLayout(layout)
@@ -1626,25 +1711,68 @@ class MainWindow(QMainWindow):
             self.settings_manager.set_setting('output_path', file_path)
     
     def load_audio(self):
-        """Load audio file."""
+        """Load audio file, analyzing it on a worker thread."""
         mp3_path = self.settings_manager.get_setting('mp3_path')
         if mp3_path and os.path.exists(mp3_path):
             try:
-                self.audio_processor = AudioProcessor(mp3_path)
-                self.audio_processor.load_audio()
-                duration = self.audio_processor.get_duration()
-                self.statusBar().showMessage(f"Audio loaded: {duration:.2f} seconds")
-                self.update_video_generator()
-                
-                # Auto-calculate slideshow interval if enabled
-                if hasattr(self, 'auto_adjust_slideshow_checkbox') and self.auto_adjust_slideshow_checkbox.isChecked():
-                    self.calculate_auto_slideshow_interval()
-                
-                # Generate preview frames when audio is loaded
-                if self.auto_preview_enabled:
-                    self.generate_preview_frames()
+                settings = self.settings_manager.settings
+                analysis_cache = None
+                if settings.get('analysis_cache_enabled', True):
+                    analysis_cache = AnalysisCache(settings.get('analysis_cache_dir', ''))
+                audio_processor = AudioProcessor(
+                    mp3_path,
+                    band_layout=settings.get('band_layout', 'squared_log'),
+                    analysis_cache=analysis_cache
+                )
             except Exception as e:
                 QMessageBox.critical(self, "Error", f"Failed to load audio: {str(e)}")
+                return
+            
+            if self.audio_analysis_thread is not None and self.audio_analysis_thread.isRunning():
+                # A newer file wins; the old analysis finishes unseen
+                retired = self.audio_analysis_thread
+                retired.progress.disconnect()
+                self.retired_analysis_threads.append(retired)
+                retired.finished.connect(lambda *_: self.retired_analysis_threads.remove(retired))
+            
+            self.progress_bar.setRange(0, 0)
+            self.progress_bar.setVisible(True)
+            thread = AudioAnalysisThread(audio_processor, dict(settings))
+            thread.progress.connect(self.statusBar().showMessage)
+            thread.finished.connect(
+                lambda success, message: self.on_audio_analysis_finished(thread, success, message)
+            )
+            self.audio_analysis_thread = thread
+            thread.start()
+    
+    def on_audio_analysis_finished(self, thread, success, message):
+        """Handle audio analysis finished: switch the generator and previews to the new track."""
+        if thread is not self.audio_analysis_thread:
+            return
+        self.audio_analysis_thread = None
+        self.progress_bar.setVisible(False)
+        self.progress_bar.setRange(0, 100)
+        if not success:
+            QMessageBox.critical(self, "Error", f"Failed to load audio: {message}")
+            return
+        
+        try:
+            self.audio_processor = thread.audio_processor
+            duration = self.audio_processor.get_duration()
+            self.statusBar().showMessage(f"Audio loaded: {duration:.2f} seconds")
+            self.update_video_generator()
+            self.stop_preview_rendering()
+            self.preview_engine = PreviewEngine(self.audio_processor)
+            
+            # Auto-calculate slideshow interval if enabled
+            if hasattr(self, 'auto_adjust_slideshow_checkbox') and self.auto_adjust_slideshow_checkbox.isChecked():
+                self.calculate_auto_slideshow_interval()
+            
+            # Generate preview frames when audio is loaded
+            if self.auto_preview_enabled:
+                self.generate_preview_frames()
+        except Exception as e:
+            QMessageBox.critical(self, "Error", f"Failed to load audio: {str(e)}")
     
     def update_video_generator(self):
         """Update video generator with current settings."""
@@ -1884,6 +2012,16 @@ class MainWindow(QMainWindow):
         if hasattr(self, 'encoding_preset_combo'):
             encoding_text = self.encoding_preset_combo.currentText().lower()
             self.settings_manager.set_setting('encoding_preset', encoding_text)
+        if hasattr(self, 'video_codec_combo'):
+            codec_map = {"H.264": 'h264', "HEVC (H.265)": 'hevc', "AV1": 'av1'}
+            self.settings_manager.set_setting('video_codec',
+                                              codec_map.get(self.video_codec_combo.currentText(), 'h264'))
+        if hasattr(self, 'png_frames_checkbox'):
+            output_mode = 'png' if self.png_frames_checkbox.isChecked() else 'pipe'
+            self.settings_manager.set_setting('output_mode', output_mode)
+        if hasattr(self, 'gpu_render_checkbox'):
+            render_backend = 'gpu' if self.gpu_render_checkbox.isChecked() else 'cpu'
+            self.settings_manager.set_setting('render_backend', render_backend)
         
         # Overlay effects
         if hasattr(self, 'overlay_effect_combo'):
@@ -1927,79 +2065,66 @@ class MainWindow(QMainWindow):
     
     def generate_preview_frames(self):
         """Generate preview frames for real-time playback."""
-        if not self.audio_processor or not self.video_generator:
+        if not self.audio_processor or not self.video_generator or not self.preview_engine:
             return
         
         try:
             # Check if fast preview mode is enabled
             fast_preview = hasattr(self, 'fast_preview_checkbox') and self.fast_preview_checkbox.isChecked()
+            full_frame_rate = self.settings_manager.get_setting('frame_rate', 30)
             
-            if fast_preview:
-                # Fast mode: 3 seconds at 15fps = 45 frames (for quick preview)
-                frame_rate = 15  # Lower frame rate
-                preview_duration = 3  # Shorter duration
-                duration = min(preview_duration, self.audio_processor.get_duration())
-                num_frames = int(duration * frame_rate)
-                max_preview_frames = 45
-            else:
-                # Full video mode: Generate entire video at full frame rate
-                frame_rate = self.settings_manager.get_setting('frame_rate', 30)
-                duration = self.audio_processor.get_duration()  # Use full audio duration
-                num_frames = int(duration * frame_rate)
-                # No max limit for full preview - generate entire video
-                max_preview_frames = num_frames
-            
-            num_frames = min(num_frames, max_preview_frames)
+            # A newer settings change supersedes the preview still rendering
+            self.stop_preview_rendering()
             
-            self.preview_frames = []
             was_playing = self.preview_widget.is_playing_preview()
+            display_size = (self.preview_widget.preview_label.width(),
+                            self.preview_widget.preview_label.height())
+            settings = self.settings_manager.settings.copy()
+            
+            if not fast_preview:
+                # Full mode: the whole track at full frame rate, streamed just ahead of the playhead
+                total_frames = int(self.audio_processor.get_duration() * full_frame_rate)
+                start = self.preview_widget.current_frame_index if self.preview_widget.streaming else 0
+                ring, generation = self.preview_widget.set_stream(
+                    total_frames, full_frame_rate,
+                    self.settings_manager.get_setting('preview_buffer_frames', 60), start
+                )
+                self.preview_stream_settings = (settings, display_size)
+                self.start_preview_stream(ring, generation, self.preview_widget.current_frame_index)
+                self.play_preview_btn.setEnabled(total_frames > 0)
+                if was_playing:
+                    self.preview_widget.play()
+                return
+            
+            # Fast mode: 3 seconds at 15fps = 45 frames (for quick preview)
+            frame_rate = 15  # Lower frame rate
+            preview_duration = 3  # Shorter duration
+            duration = min(preview_duration, self.audio_processor.get_duration())
+            num_frames = int(duration * frame_rate)
+            # Sample preview frames from the output timeline
+            frame_numbers = [int(i * (full_frame_rate / frame_rate)) for i in range(num_frames)]
             
             # Generate frames in a separate thread to avoid blocking UI
             class PreviewFrameGenerator(QThread):
                 frames_ready = pyqtSignal(list, int)
                 
-                def __init__(self, video_generator, num_frames, frame_rate, fast_mode=False):
+                def __init__(self, engine, settings, display_size, frame_numbers, frame_rate):
                     super().__init__()
-                    self.video_generator = video_generator
-                    self.num_frames = num_frames
+                    self.engine = engine
+                    self.settings = settings
+                    self.display_size = display_size
+                    self.frame_numbers = frame_numbers
                     self.frame_rate = frame_rate
-                    self.fast_mode = fast_mode
                 
                 def run(self):
-                    frames = []
-                    # In fast mode, scale frame numbers to sample from full timeline
-                    full_frame_rate = self.video_generator.frame_rate
-                    
-                    for i in range(self.num_frames):
-                        try:
-                            # Map preview frame to actual video frame
-                            if self.fast_mode:
-                                # Sample frames at lower rate across the timeline
-                                actual_frame = int(i * (full_frame_rate / self.frame_rate))
-                            else:
-                                actual_frame = i
-                            
-                            frame = self.video_generator.generate_frame(actual_frame)
-                            
-                            # In fast mode, optionally reduce resolution for even faster generation
-                            if self.fast_mode and i < 5:  # Only first 5 frames in super fast mode
-                                # Reduce to 50% size for faster processing
-                                width, height = frame.size
-                                # Use NEAREST for fastest resampling (FAST doesn't exist in newer Pillow)
-                                frame = frame.resize((width // 2, height // 2), Image.Resampling.NEAREST)
-                                # Scale back up (preview widget will handle final sizing)
-                                frame = frame.resize((width, height), Image.Resampling.NEAREST)
-                            
-                            frames.append(frame)
-                        except Exception as e:
-                            from core.logger import get_logger
-                            logger = get_logger()
-                            logger.error(f"Error generating preview frame {i}: {e}", exc_info=True)
-                            break
-                    self.frames_ready.emit(frames, self.frame_rate)
+                    # Every finished pass replaces the shown frames: coarse first, then refined
+                    self.engine.render(
+                        self.settings, self.display_size, self.frame_numbers,
+                        pass_callback=lambda _, frames: self.frames_ready.emit(frames, self.frame_rate)
+                    )
             
             self.preview_generator_thread = PreviewFrameGenerator(
-                self.video_generator, num_frames, frame_rate, fast_preview
+                self.preview_engine, settings, display_size, frame_numbers, frame_rate
             )
             self.preview_generator_thread.frames_ready.connect(
                 lambda frames, fr: self.on_preview_frames_ready(frames, fr, was_playing)
@@ -2011,13 +2136,80 @@ class MainWindow(QMainWindow):
             logger = get_logger()
             logger.error(f"Error generating preview frames: {e}", exc_info=True)
     
+    def start_preview_stream(self, ring, generation, start):
+        """
+        Start rendering streamed preview frames into the widget's ring.
+        
+        Args:
+            ring: FrameRing the widget plays from
+            generation: Ring generation the frames belong to
+            start: First frame to render
+        """
+        if self.preview_stream_settings is None or not self.preview_engine:
+            return
+        settings, display_size = self.preview_stream_settings
+        
+        class PreviewFrameStreamer(QThread):
+            def __init__(self, engine, settings, display_size, total_frames, start, ring, generation):
+                super().__init__()
+                self.engine = engine
+                self.settings = settings
+                self.display_size = display_size
+                self.total_frames = total_frames
+                self.start_frame = start
+                self.ring = ring
+                self.generation = generation
+            
+            def run(self):
+                frames = self.engine.stream(self.settings, self.display_size,
+                                            range(self.start_frame, self.total_frames))
+                try:
+                    # put() blocks while the ring is full and fails once the ring was reset
+                    for frame_number, frame in frames:
+                        if not self.ring.put(frame_number, frame, self.generation):
+                            break
+                finally:
+                    frames.close()
+        
+        self.preview_generator_thread = PreviewFrameStreamer(
+            self.preview_engine, settings, display_size, self.preview_widget.frame_count(),
+            start, ring, generation
+        )
+        self.preview_generator_thread.start()
+    
+    def stop_preview_rendering(self):
+        """Stop the preview render or stream still running, waiting for its thread."""
+        if self.preview_generator_thread is not None and self.preview_generator_thread.isRunning():
+            self.preview_engine.cancel()
+            # Releases a streamer blocked on a full ring
+            self.preview_widget.ring.reset()
+            self.preview_generator_thread.wait()
+    
+    def on_preview_seek(self, index):
+        """Restart the preview stream at the frame the user seeked to."""
+        if not self.preview_widget.streaming or self.preview_engine is None:
+            return
+        if self.preview_generator_thread is not None and self.preview_generator_thread.isRunning():
+            self.preview_engine.cancel()
+            self.preview_generator_thread.wait()
+        self.start_preview_stream(self.preview_widget.ring, self.preview_widget.ring.generation, index)
+    
+    def on_preview_resized(self):
+        """Re-render the preview at the new display size."""
+        if self.auto_preview_enabled and self.preview_engine is not None:
+            self.preview_update_timer.stop()
+            self.preview_update_timer.start(500)
+    
     def on_preview_frames_ready(self, frames, frame_rate, was_playing):
         """Handle preview frames ready signal."""
-        self.preview_frames = frames
         if frames:
+            # Keep the playback position when a refined pass replaces the frames
+            position = 0 if self.preview_widget.streaming else self.preview_widget.current_frame_index
+            playing = self.preview_widget.is_playing_preview()
             self.preview_widget.set_frames(frames, frame_rate)
+            self.preview_widget.seek(position % len(frames))
             self.play_preview_btn.setEnabled(True)
-            if was_playing:
+            if was_playing or playing:
                 self.preview_widget.play()
                 self.play_preview_btn.setText("⏸ Pause")
     
@@ -2027,7 +2219,7 @@ class MainWindow(QMainWindow):
             self.preview_widget.pause()
             self.play_preview_btn.setText("▶ Play")
         else:
-            if not self.preview_frames:
+            if not self.preview_widget.frame_count():
                 # Generate frames if not available
                 self.generate_preview_frames()
             else:
@@ -2308,6 +2500,15 @@ class MainWindow(QMainWindow):
             else:
                 self.resolution_combo.setCurrentText('1080p (Full HD)')
         
+        if hasattr(self, 'video_codec_combo'):
+            codec_names = {'h264': "H.264", 'hevc': "HEVC (H.265)", 'av1': "AV1"}
+            self.video_codec_combo.setCurrentText(codec_names.get(settings.get('video_codec', 'h264'), "H.264"))
+        
+        if hasattr(self, 'png_frames_checkbox'):
+            self.png_frames_checkbox.setChecked(settings.get('output_mode', 'pipe') == 'png')
+        if hasattr(self, 'gpu_render_checkbox'):
+            self.gpu_render_checkbox.setChecked(settings.get('render_backend', 'cpu') == 'gpu')
+        
         self.output_path_input.setText(settings.get('output_path', ''))
         
         self.update_settings()
@@ -1,18 +1,124 @@
 """
 Preview widget for displaying video preview frames with real-time playback.
+Playback reads from a fixed-size ring of frames filled just ahead of the
+playhead, so preview memory stays flat however long the track is.
 """
 
-from PyQt5.QtWidgets import QWidget, QLabel, QVBoxLayout
-from PyQt5.QtCore import Qt, QTimer
+import threading
+from PyQt5.QtWidgets import QWidget, QLabel, QVBoxLayout, QSlider
+from PyQt5.QtCore import Qt, QTimer, QSize, pyqtSignal
 from PyQt5.QtGui import QPixmap, QImage
 from PIL import Image
-import io
-from typing import List, Optional
+import numpy as np
+from typing import List, Optional, Sequence, Tuple, Union
+
+
+class FrameRing:
+    """
+    Fixed number of frame slots filled ahead of the playhead.
+    
+    A producer thread puts consecutive frames and blocks while it is a full
+    ring ahead of the playhead; playback takes the frame at the playhead,
+    which frees the slots behind it for the producer. reset() empties the ring
+    and starts a new generation, so a producer still rendering for the old
+    playhead stops.
+    """
+    
+    def __init__(self, capacity: int):
+        """
+        Initialize ring.
+        
+        Args:
+            capacity: Number of frame slots
+        """
+        self.capacity = max(int(capacity), 1)
+        # Slot -> [frame index, RGB frame, scaled pixmap or None]
+        self._slots: List[Optional[list]] = [None] * self.capacity
+        self._playhead = 0
+        self.generation = 0
+        self._condition = threading.Condition()
+    
+    def reset(self, playhead: Optional[int] = None) -> int:
+        """
+        Drop all buffered frames.
+        
+        Args:
+            playhead: New playhead (None keeps the current one)
+        
+        Returns:
+            Generation the producer for the new playhead must put with
+        """
+        with self._condition:
+            self._slots = [None] * self.capacity
+            if playhead is not None:
+                self._playhead = playhead
+            self.generation += 1
+            self._condition.notify_all()
+            return self.generation
+    
+    def put(self, index: int, frame: np.ndarray, generation: int) -> bool:
+        """
+        Store a frame, blocking while it is a full ring ahead of the playhead.
+        
+        Args:
+            index: Frame index
+            frame: (height, width, 3) RGB frame, kept by reference
+            generation: Generation returned by reset() when the producer started
+        
+        Returns:
+            False once the ring was reset, i.e. the producer should stop
+        """
+        with self._condition:
+            while generation == self.generation and index >= self._playhead + self.capacity:
+                self._condition.wait(0.1)
+            if generation != self.generation:
+                return False
+            # Frames the playhead already passed are dropped
+            if index >= self._playhead:
+                self._slots[index % self.capacity] = [index, frame, None]
+            return True
+    
+    def get(self, index: int) -> Optional[list]:
+        """
+        Move the playhead to a frame and get its slot.
+        
+        Args:
+            index: Frame index
+        
+        Returns:
+            [index, frame, pixmap] slot, or None while the frame isn't buffered yet
+        """
+        with self._condition:
+            if index != self._playhead:
+                self._playhead = index
+                self._condition.notify_all()
+            slot = self._slots[index % self.capacity]
+            return slot if slot is not None and slot[0] == index else None
+
+
+def frame_to_array(frame: Union[Image.Image, np.ndarray]) -> np.ndarray:
+    """
+    Get a frame as a C-contiguous (height, width, 3) uint8 RGB array.
+    
+    Args:
+        frame: PIL Image or RGB array
+    
+    Returns:
+        The array (the input itself when it already qualifies)
+    """
+    if isinstance(frame, Image.Image):
+        frame = np.asarray(frame.convert('RGB') if frame.mode != 'RGB' else frame)
+    return np.ascontiguousarray(frame, dtype=np.uint8)
 
 
 class PreviewWidget(QWidget):
     """Widget for displaying preview frames with real-time playback."""
     
+    # Frame index the user seeked to while streaming; the owner restarts its producer there
+    seek_requested = pyqtSignal(int)
+    # Emitted when the display area changed size, so frames can be re-rendered to fit
+    display_resized = pyqtSignal()
+    
     def __init__(self, parent=None):
         """
         Initialize preview widget.
@@ -21,12 +127,20 @@ class PreviewWidget(QWidget):
             parent: Parent widget
         """
         super().__init__(parent)
-        self.frames: List[Image.Image] = []
+        self.ring = FrameRing(1)
+        self.total_frames = 0
+        self.streaming = False  # Frames come from a producer instead of set_frames()
         self.current_frame_index = 0
         self.is_playing = False
         self.frame_rate = 30
+        self._shown_index: Optional[int] = None
+        self._display_size = QSize()
         self.timer = QTimer()
         self.timer.timeout.connect(self.next_frame)
+        # Polls for the frame at the playhead while the producer is catching up
+        self.buffer_timer = QTimer()
+        self.buffer_timer.setInterval(30)
+        self.buffer_timer.timeout.connect(self._show_pending_frame)
         self.init_ui()
     
     def init_ui(self):
@@ -47,30 +161,89 @@ class PreviewWidget(QWidget):
             }
         """)
         
+        self.position_slider = QSlider(Qt.Horizontal)
+        self.position_slider.setRange(0, 0)
+        self.position_slider.setEnabled(False)
+        self.position_slider.sliderReleased.connect(
+            lambda: self.seek(self.position_slider.value())
+        )
+        
         layout.addWidget(self.preview_label)
+        layout.addWidget(self.position_slider)
         self.setLayout(layout)
     
-    def set_frames(self, frames: List[Image.Image], frame_rate: int = 30):
+    def set_frames(self, frames: Sequence[Union[Image.Image, np.ndarray]], frame_rate: int = 30):
         """
         Set frames for preview playback.
         
         Args:
-            frames: List of PIL Images
+            frames: PIL Images or (height, width, 3) RGB arrays, played in a loop
+            frame_rate: Frame rate for playback
+        """
+        self.streaming = False
+        self.ring = FrameRing(max(len(frames), 1))
+        generation = self.ring.reset(0)
+        for index, frame in enumerate(frames):
+            self.ring.put(index, frame_to_array(frame), generation)
+        self._start_playback(len(frames), frame_rate, 0)
+    
+    def set_stream(self, total_frames: int, frame_rate: int, buffer_frames: int,
+                   start: int = 0) -> Tuple[FrameRing, int]:
+        """
+        Play frames put into the ring by a producer, rendering ahead of the playhead.
+        
+        Args:
+            total_frames: Number of frames in the stream
             frame_rate: Frame rate for playback
+            buffer_frames: Ring capacity (frames buffered ahead of the playhead)
+            start: Frame index to start at
+        
+        Returns:
+            (ring, generation) for the producer's FrameRing.put() calls
         """
-        self.frames = frames
+        self.streaming = True
+        start = min(max(start, 0), max(total_frames - 1, 0))
+        self.ring = FrameRing(buffer_frames)
+        generation = self.ring.reset(start)
+        self._start_playback(total_frames, frame_rate, start)
+        return self.ring, generation
+    
+    def _start_playback(self, total_frames: int, frame_rate: int, start: int):
+        """Reset playback state for new frames, keeping play/pause."""
+        self.total_frames = total_frames
         self.frame_rate = frame_rate
-        self.current_frame_index = 0
+        self.current_frame_index = start
+        self._shown_index = None
+        self.timer.setInterval(int(1000 / frame_rate))  # milliseconds
+        self.position_slider.setRange(0, max(total_frames - 1, 0))
+        self.position_slider.setEnabled(total_frames > 1)
+        self.position_slider.setValue(start)
+        self._show_pending_frame()
+    
+    def frame_count(self) -> int:
+        """Number of frames available for playback."""
+        return self.total_frames
+    
+    def seek(self, index: int):
+        """
+        Move the playhead to a frame.
         
-        if self.frames:
-            self.display_frame(self.frames[0])
-            # Update timer interval based on frame rate
-            interval = int(1000 / frame_rate)  # milliseconds
-            self.timer.setInterval(interval)
+        Args:
+            index: Frame index
+        """
+        if not self.total_frames:
+            return
+        index = min(max(int(index), 0), self.total_frames - 1)
+        self.current_frame_index = index
+        if self.streaming and self.ring.get(index) is None:
+            # Not buffered: restart the producer at the new position
+            self.ring.reset(index)
+            self.seek_requested.emit(index)
+        self._show_pending_frame()
     
     def play(self):
         """Start playing preview frames."""
-        if self.frames and not self.is_playing:
+        if self.total_frames and not self.is_playing:
             self.is_playing = True
             self.timer.start()
     
@@ -83,68 +256,99 @@ class PreviewWidget(QWidget):
     def stop(self):
         """Stop preview playback and reset to first frame."""
         self.pause()
-        self.current_frame_index = 0
-        if self.frames:
-            self.display_frame(self.frames[0])
+        self.seek(0)
     
     def next_frame(self):
         """Display next frame in sequence."""
-        if not self.frames:
+        if not self.total_frames:
+            return
+        # Hold the current frame until the producer catches up with the playhead
+        if self._shown_index != self.current_frame_index:
+            self._show_pending_frame()
             return
         
-        self.current_frame_index = (self.current_frame_index + 1) % len(self.frames)
-        self.display_frame(self.frames[self.current_frame_index])
+        next_index = self.current_frame_index + 1
+        if next_index >= self.total_frames:
+            # Loop; a streamed preview has to be rendered again from the start
+            self.seek(0)
+            return
+        self.current_frame_index = next_index
+        self._show_current_frame()
     
     def is_playing_preview(self) -> bool:
         """Check if preview is currently playing."""
         return self.is_playing
     
-    def display_frame(self, pil_image: Image.Image):
+    def _show_pending_frame(self):
+        """Show the frame at the playhead, polling until it is buffered."""
+        if self._show_current_frame():
+            self.buffer_timer.stop()
+        elif not self.buffer_timer.isActive():
+            self.buffer_timer.start()
+    
+    def _show_current_frame(self) -> bool:
+        """Show the frame at the playhead; False while it isn't buffered yet."""
+        slot = self.ring.get(self.current_frame_index)
+        if slot is None:
+            return False
+        
+        # Scaled once per frame and display size; a looping preview reuses it
+        pixmap = slot[2]
+        if pixmap is None or pixmap.size() != self._fit_size(slot[1]):
+            pixmap = self._to_pixmap(slot[1])
+            slot[2] = pixmap
+        self.preview_label.setPixmap(pixmap)
+        self._shown_index = self.current_frame_index
+        if not self.position_slider.isSliderDown():
+            self.position_slider.setValue(self.current_frame_index)
+        return True
+    
+    def _fit_size(self, frame: np.ndarray) -> QSize:
+        """Size of a frame scaled to fit the display area, keeping its aspect ratio."""
+        height, width = frame.shape[:2]
+        display = self._display_size if self._display_size.isValid() else self.preview_label.size()
+        if display.width() <= 0 or display.height() <= 0:
+            return QSize(width, height)
+        fit = QSize(width, height).scaled(display, Qt.KeepAspectRatio)
+        # Frames rendered for this display are only rounded to even sizes: show them as-is
+        if abs(fit.width() - width) <= 2 and abs(fit.height() - height) <= 2:
+            return QSize(width, height)
+        return fit
+    
+    def _to_pixmap(self, frame: np.ndarray) -> QPixmap:
+        """Convert an RGB frame to a pixmap fitting the display area."""
+        height, width = frame.shape[:2]
+        # The QImage wraps the array's memory without copying; the array must
+        # stay alive until the pixmap is made, which the ring slot guarantees
+        image = QImage(frame.data, width, height, frame.strides[0], QImage.Format_RGB888)
+        size = self._fit_size(frame)
+        if size != QSize(width, height):
+            image = image.scaled(size, Qt.KeepAspectRatio, Qt.SmoothTransformation)
+        return QPixmap.fromImage(image)
+    
+    def resizeEvent(self, event):
+        """Track the display size: frames are scaled for it once, not on every tick."""
+        super().resizeEvent(event)
+        size = self.preview_label.size()
+        if size != self._display_size:
+            self._display_size = size
+            if self.total_frames:
+                self._show_current_frame()
+            self.display_resized.emit()
+    
+    def display_frame(self, frame: Union[Image.Image, np.ndarray]):
         """
-        Display a PIL Image in the preview.
+        Display a single frame in the preview.
         
         Args:
-            pil_image: PIL Image to display
+            frame: PIL Image or (height, width, 3) RGB array to display
         """
-        if pil_image is None:
+        if frame is None:
             return
         
-        # Convert PIL Image to QPixmap
         try:
-            # Resize to fit preview while maintaining aspect ratio
-            preview_width = self.preview_label.width()
-            preview_height = self.preview_label.height()
-            
-            if preview_width > 0 and preview_height > 0:
-                # Calculate aspect ratio preserving size
-                img_width, img_height = pil_image.size
-                aspect_ratio = img_width / img_height
-                
-                if preview_width / preview_height > aspect_ratio:
-                    display_height = preview_height
-                    display_width = int(preview_height * aspect_ratio)
-                else:
-                    display_width = preview_width
-                    display_height = int(preview_width / aspect_ratio)
-                
-                pil_image = pil_image.resize((display_width, display_height), Image.Resampling.LANCZOS)
-            
-            # Convert to RGB if needed
-            if pil_image.mode != 'RGB':
-                pil_image = pil_image.convert('RGB')
-            
-            # Convert to bytes
-            img_bytes = io.BytesIO()
-            pil_image.save(img_bytes, format='PNG')
-            img_bytes.seek(0)
-            
-            # Create QImage from bytes
-            qimage = QImage()
-            qimage.loadFromData(img_bytes.read())
-            
-            # Convert to QPixmap and display
-            pixmap = QPixmap.fromImage(qimage)
-            self.preview_label.setPixmap(pixmap)
+            array = frame_to_array(frame)
+            self.preview_label.setPixmap(self._to_pixmap(array))
         except Exception as e:
             print(f"Error displaying frame: {e}")
     
@@ -162,4 +366,3 @@ class PreviewWidget(QWidget):
         """
         self.preview_label.clear()
         self.preview_label.setText(message)
-
@@ -1,14 +1,19 @@
 """
 Main entry point for MP3 Spectrum Visualizer application.
+Starts the GUI, or renders headlessly: a batch manifest with --batch, or one
+track split over worker nodes with --distributed.
 """
 
 import sys
-from PyQt5.QtWidgets import QApplication
-from gui.main_window import MainWindow
+import argparse
+import multiprocessing
 
 
-def main():
-    """Main application entry point."""
+def run_gui():
+    """Start the PyQt GUI."""
+    from PyQt5.QtWidgets import QApplication
+    from gui.main_window import MainWindow
+    
     app = QApplication(sys.argv)
     app.setStyle('Fusion')  # Use Fusion style for better look
     
@@ -18,13 +23,45 @@ def main():
     sys.exit(app.exec_())
 
 
-if __name__ == '__main__':
-    main()
-
-
-
-
-
-
+def main():
+    """Main application entry point."""
+    parser = argparse.ArgumentParser(description='MP3 Spectrum Visualizer')
+    parser.add_argument('--batch', metavar='MANIFEST',
+                        help='render the jobs of a JSON manifest without the GUI')
+    parser.add_argument('--workers', type=int, default=0,
+                        help='jobs rendered at once in batch mode (default: manifest or settings)')
+    parser.add_argument('--report', metavar='PATH', help='write a JSON report of the batch results')
+    parser.add_argument('--settings', metavar='PATH',
+                        help='settings file used as the base of every batch job or distributed render')
+    parser.add_argument('--distributed', nargs=2, metavar=('AUDIO', 'OUTPUT'),
+                        help='render a track as segments on the distributed_nodes and join them')
+    parser.add_argument('--segment', metavar='TASK', help=argparse.SUPPRESS)  # Run by worker nodes
+    args = parser.parse_args()
+    
+    if args.segment:
+        from core.distributed import render_segment_task
+        sys.exit(0 if render_segment_task(args.segment) else 1)
+    
+    if args.distributed:
+        from core.distributed import DistributedRenderer
+        from core.settings import SettingsManager
+        settings_manager = SettingsManager(args.settings) if args.settings else SettingsManager()
+        settings = settings_manager.load_settings() if args.settings else dict(SettingsManager.DEFAULT_SETTINGS)
+        audio_path, output_path = args.distributed
+        success = DistributedRenderer(audio_path, settings).render(output_path)
+        sys.exit(0 if success else 1)
+    
+    if args.batch:
+        # Headless: no Qt import, so render servers don't need a display
+        from core.batch import run_batch
+        success = run_batch(args.batch, workers=args.workers, report_path=args.report,
+                            settings_file=args.settings)
+        sys.exit(0 if success else 1)
+    
+    run_gui()
 
 
+if __name__ == '__main__':
+    # Required for render worker processes in frozen (PyInstaller) builds
+    multiprocessing.freeze_support()
+    main()